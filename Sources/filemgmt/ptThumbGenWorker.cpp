@@ -148,7 +148,7 @@ TThumbPtr ptThumbGenWorker::generateThumb(const TThumbId& AThumbId) {
     MagickWand* hGMImage = NewMagickWand();
     QSize       hSize;
 
-    if (hDcRaw.Identify(hFilePath) == 0) {
+    if (hDcRaw.Identify(hFilePath, 1) == 0) {
       // we have a raw image
       auto hImgData = hDcRaw.thumbnail();
       if (!hImgData.empty()) {
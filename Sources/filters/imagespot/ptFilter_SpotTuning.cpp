@@ -266,7 +266,7 @@ void ptFilter_SpotTuning::updatePreview() {
   if (FInteractionOngoing) {
     // We’re in interactive mode: only recalc spots
     auto hImage = make_unique<ptImage>();
-    hImage->Set(TheProcessor->m_Image_AfterLocalEdit);
+    hImage->Set(TheProcessor->RestoreStage(TheProcessor->m_Image_AfterLocalEdit));
     this->runFilter(hImage.get());
     hImage->LchToRGB(Settings->GetInt("WorkColor"));
     UpdatePreviewImage(hImage.get());
@@ -27,6 +27,8 @@
 #include "../ptColorSelectButton.h"
 #include "../ptUtils_Storage.h"
 #include "../ptInfo.h"
+#include "../ptImage.h"
+#include "../ptProfiler.h"
 #include "../ptCheck.h"
 #include "../ptChoice.h"
 #include "../ptWidget.h"
@@ -37,6 +39,7 @@
 #include <QWidget>
 #include <QVBoxLayout>
 #include <QMap>
+#include <QCryptographicHash>
 
 //==============================================================================
 
@@ -119,9 +122,94 @@ void ptFilterBase::reset(const bool ARequestPipeRun /*=false*/) {
 
 /*! Executes the filter on \c AImage. */
 void ptFilterBase::runFilter(ptImage *AImage) {
+  // Most filters only know the 16 bit representation.
+  if (AImage->isFloat() && !this->supportsFloat()) AImage->toUInt16();
+  // The layout only changes when a filter wants the other one.
+  if (this->prefersPlanar()) {
+    AImage->toPlanar();
+  } else {
+    AImage->toInterleaved();
+  }
+  // Filters write to the buffer directly, so it must not be shared with a cached stage.
+  AImage->detach();
+  ptProfileScope hProfile(FUniqueName, "filter", AImage);
   this->doRunFilter(AImage);
 }
 
+//------------------------------------------------------------------------------
+/*! Returns the number of neighbouring pixel rows the filter needs to compute one output pixel.
+    Point-wise filters return \c 0. A negative value means the filter depends on the whole image
+    (global statistics, position in the frame, …) and cannot run on strips of the image.
+    Derived classes reimplement \c doHaloRadius(). The default is \c -1.
+ */
+int ptFilterBase::haloRadius() const {
+  return this->doHaloRadius();
+}
+
+//------------------------------------------------------------------------------
+/*! Returns the colour space in which the filter maps each channel through a fixed 1D function.
+    Such filters can be evaluated once on a lookup table instead of the image, and consecutive
+    ones in the same space collapse into a single pass, see \c ptProcessor::RunFilter().
+    Anything that mixes channels or looks at neighbours or image statistics must return
+    \c TPointSpace::None, which is the default. Derived classes reimplement \c doPointSpace().
+ */
+ptFilterBase::TPointSpace ptFilterBase::pointSpace() const {
+  return this->doPointSpace();
+}
+
+//------------------------------------------------------------------------------
+/*! Returns the colour space the filter needs its input in, or \c TColorSpace::Any when it
+    works in whatever space the image is in. The pipe executor converts the image before the
+    filter runs, only when the space actually changes; the conversion calls at the start of
+    the filters' \c doRunFilter() then are no-ops. The default is the space of \c pointSpace()
+    for point filters and \c FInputSpace, set by the derived class's constructor, otherwise.
+ */
+ptFilterBase::TColorSpace ptFilterBase::inputSpace() const {
+  return this->doInputSpace();
+}
+
+//------------------------------------------------------------------------------
+
+ptFilterBase::TColorSpace ptFilterBase::doInputSpace() const {
+  switch (this->pointSpace()) {
+    case TPointSpace::Rgb: return TColorSpace::Rgb;
+    case TPointSpace::Lab: return TColorSpace::Lab;
+    default:               return FInputSpace;
+  }
+}
+
+//------------------------------------------------------------------------------
+/*! Returns \c true if the filter can work on the float32 representation of \c ptImage
+    directly (see \c ptImage::isFloat()). Other filters get the image converted back to 16 bit
+    by \c runFilter(). Derived classes reimplement \c doSupportsFloat(). The default is \c false.
+ */
+bool ptFilterBase::supportsFloat() const {
+  return this->doSupportsFloat();
+}
+
+//------------------------------------------------------------------------------
+/*! Returns \c true if the filter works on single channels and wants the planar layout of
+    \c ptImage (see \c ptImage::isPlanar()). \c runFilter() switches the image to the layout the
+    filter prefers; all other filters get interleaved data, so filters that do not reimplement
+    \c doPrefersPlanar() never see a planar image. The default is \c false.
+ */
+bool ptFilterBase::prefersPlanar() const {
+  return this->doPrefersPlanar();
+}
+
+//------------------------------------------------------------------------------
+/*! Returns a key that identifies the output of this filter when it runs on an input image
+    identified by \c AInputKey. The key combines the input key, the filter’s unique name and a
+    hash of its current config, so any config change produces a different key.
+ */
+QByteArray ptFilterBase::cacheKey(const QByteArray &AInputKey) const {
+  QCryptographicHash hHash(QCryptographicHash::Md5);
+  hHash.addData(AInputKey);
+  hHash.addData(FUniqueName.toUtf8());
+  hHash.addData(FConfig.hash());
+  return hHash.result();
+}
+
 //------------------------------------------------------------------------------
 /*! A filter has an active config when it is configured to do processing on the image.
     That does not imply that the filter is really performing any processing. E.g. it might be
@@ -361,6 +449,7 @@ ptFilterBase::ptFilterBase():
   /*QObject(),*/ptTempFilterBase(),
   FHasActiveCfg(false),
   FIsSlow(false),
+  FInputSpace(TColorSpace::Any),
   FGuiContainer(nullptr),
   FIsActive(false),
   FParentTabIdx(-1),
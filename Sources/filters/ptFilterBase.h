@@ -63,6 +63,14 @@ public:
   /*! Standard Qt typedef to make OR combinations of \c TFilterFlag possible. */
   typedef QFlags<TFilterFlag> TFilterFlags;
 
+  /*! Colour space in which a filter is a pure per channel point operation, i.e. every output
+      channel value depends only on the same channel of the same input pixel. \see pointSpace() */
+  enum class TPointSpace { None, Rgb, Lab };
+
+  /*! Colour space a filter expects its input in. \c Lch filters take Lab and LCh images alike
+      and leave them in that space. \see inputSpace() */
+  enum class TColorSpace { Any, Rgb, Lab, Lch };
+
 public:
   virtual ~ptFilterBase();              //!< Destroys a ptFilterBase object.
 
@@ -74,6 +82,12 @@ public:
   void    init(const QString &AUniqueName, const QString &AGuiNamePostfix);
   void    reset(const bool ARequestPipeRun = false);
   void    runFilter(ptImage *AImage);
+  int     haloRadius() const;
+  TPointSpace pointSpace() const;
+  TColorSpace inputSpace() const;
+  bool    supportsFloat() const;
+  bool    prefersPlanar() const;
+  QByteArray cacheKey(const QByteArray &AInputKey) const;
 
 
   /*! \name Status getters and setters *//*! @{*/
@@ -134,6 +148,11 @@ protected:
   virtual void      doImportCustomConfig(QSettings *APreset) {}
   virtual void      doUpdateGui() {}                          //!< Update for the children.
   virtual void      doRunFilter(ptImage *AImage) = 0;         //!< Children should do the work.
+  virtual int       doHaloRadius() const { return -1; }       //!< \see haloRadius()
+  virtual TPointSpace doPointSpace() const { return TPointSpace::None; } //!< \see pointSpace()
+  virtual TColorSpace doInputSpace() const;                   //!< \see inputSpace()
+  virtual bool      doSupportsFloat() const { return false; }  //!< \see supportsFloat()
+  virtual bool      doPrefersPlanar() const { return false; }  //!< \see prefersPlanar()
   virtual void      doReset() {}                              //!< Reset for the children
   virtual void      doDefineControls() = 0;                   //!< Children know which controls they need.
 #pragma GCC diagnostic pop
@@ -144,6 +163,7 @@ protected:
   QString           FHelpUri;
   bool              FHasActiveCfg;
   bool              FIsSlow;
+  TColorSpace       FInputSpace;    //!< \see inputSpace()
   ptToolBox*        FGuiContainer;
 
 protected slots:
@@ -26,6 +26,8 @@
 #include "../ptInfo.h"
 
 #include <QSettings>
+#include <QDataStream>
+#include <QCryptographicHash>
 
 //------------------------------------------------------------------------------
 // Strictly for debugging! Dumps all key/value pairs to stdout.
@@ -123,6 +125,27 @@ void ptFilterConfig::importPreset(QSettings *APreset) {
   }
 }
 
+//------------------------------------------------------------------------------
+/*!
+  Returns an MD5 hash over the current values in both data stores. Two configs with equal
+  values produce the same hash. Items are processed in *FItems* order so the result does not
+  depend on QHash iteration order.
+*/
+QByteArray ptFilterConfig::hash() const {
+  QByteArray  hData;
+  QDataStream hStream(&hData, QIODevice::WriteOnly);
+
+  for (const ptCfgItem &hCfgItem: FItems) {
+    hStream << hCfgItem.Id;
+    if (hCfgItem.Type < ptCfgItem::CFirstCustomType)
+      hStream << FDefaultStore.value(hCfgItem.Id);
+    else
+      hStream << FCustomStore.value(hCfgItem.Id)->storeConfig("");
+  }
+
+  return QCryptographicHash::hash(hData, QCryptographicHash::Md5);
+}
+
 //------------------------------------------------------------------------------
 /*! Returns *true* if both the default store and custom store are empty. */
 bool ptFilterConfig::isEmpty() const {
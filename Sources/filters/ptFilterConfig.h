@@ -26,6 +26,7 @@
 
 #include "ptCfgItem.h"
 #include "../ptStorable.h"
+#include <QByteArray>
 #include <QHash>
 #include <QVariant>
 #include <QStringList>
@@ -46,6 +47,7 @@ public:
   void                importPreset(QSettings* APreset);
   const TCfgItemList& items() const;
   bool                isEmpty() const;
+  QByteArray          hash() const;
 
 
   /*! \name Access to the data store. *//*! @{*/
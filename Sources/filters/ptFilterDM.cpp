@@ -545,11 +545,11 @@ ptFilterBase *ptFilterDM::NewFilter(const QString &AFilterId,
 
 void ptFilterDM::UpdatePositions(ptFilterBase *AFilter) {
   // Remove filter at old positions
-  for (TCacheGroup hCacheGroup: FOrderedFilters) {
+  for (TCacheGroup &hCacheGroup: FOrderedFilters) {
     if (hCacheGroup.removeOne(AFilter))
       break;
   }
-  for (TCacheGroup hCacheGroup: FActiveFilters) {
+  for (TCacheGroup &hCacheGroup: FActiveFilters) {
     if (hCacheGroup.removeOne(AFilter))
       break;
   }
@@ -582,6 +582,16 @@ bool ptFilterDM::isActiveCacheGroup(const int AGroupIdx) {
 
 //==============================================================================
 
+const TCacheGroup &ptFilterDM::activeGroup(const int AGroupIdx) const {
+  static const TCacheGroup hEmpty;
+  if (AGroupIdx < 0 || AGroupIdx > FActiveFilters.size()-1)
+    return hEmpty;   // catch invalid indexes
+
+  return FActiveFilters.at(AGroupIdx);
+}
+
+//==============================================================================
+
 void ptFilterDM::UpdateActivesList(ptFilterBase *AFilter) {
   if (AFilter->isActive()) {
     InsertToList(ActiveList, AFilter);
@@ -80,6 +80,12 @@ public:
    */
   bool                isActiveCacheGroup(const int AGroupIdx);
 
+  /*! Returns the active filters of the cache group \c AGroupIdx in pipe order, or an empty
+      list when the index is invalid. Inactive filters are not in the list at all, so an
+      inactive group costs nothing to skip. Only valid in GUI mode, in job mode the filters
+      have no positions. */
+  const TCacheGroup  &activeGroup(const int AGroupIdx) const;
+
   /*! Adds or removes a filter from the list of active filters. The performed action depends
       on AFilter->isActive(). */
   void                UpdateActivesList(ptFilterBase *AFilter);
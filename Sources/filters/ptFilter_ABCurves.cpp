@@ -79,5 +79,16 @@ void ptFilter_ABCurves::doRunFilter(ptImage *AImage) {
     AImage->ApplyCurve(FConfig.items()[1].Curve.get(), ChMask_b);
 }
 
+//------------------------------------------------------------------------------
+
+int ptFilter_ABCurves::doHaloRadius() const {
+  return 0;
+}
+
+//------------------------------------------------------------------------------
+ptFilterBase::TPointSpace ptFilter_ABCurves::doPointSpace() const {
+  return TPointSpace::Lab;
+}
+
 //------------------------------------------------------------------------------
 RegisterHelper ABCurvesRegister(&ptFilter_ABCurves::CreateABCurves, CABCurvesId);
@@ -42,6 +42,7 @@ ptFilter_BlackWhite::ptFilter_BlackWhite():
   ptFilterBase()
 {
   FHelpUri = "http://photivo.org/manual/tabs/eyecandy#black_and_white";
+  FInputSpace = TColorSpace::Rgb;
   this->internalInit();
 }
 
@@ -113,6 +114,12 @@ void ptFilter_BlackWhite::doRunFilter(ptImage* AImage) {
 
 //------------------------------------------------------------------------------
 
+int ptFilter_BlackWhite::doHaloRadius() const {
+  return 0;
+}
+
+//------------------------------------------------------------------------------
+
 QWidget* ptFilter_BlackWhite::doCreateGui() {
   auto guiBody = new QWidget;
 
@@ -37,6 +37,7 @@ protected:
   void      doDefineControls() override;
   bool      doCheckHasActiveCfg() override;
   void      doRunFilter(ptImage* AImage) override;
+  int       doHaloRadius() const override;
   void      doUpdateGui() override;
 
 private:
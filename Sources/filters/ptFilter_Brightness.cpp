@@ -107,6 +107,18 @@ void ptFilter_Brightness::doRunFilter(ptImage *AImage) {
 
 //==============================================================================
 
+int ptFilter_Brightness::doHaloRadius() const {
+  return 0;
+}
+
+//==============================================================================
+
+ptFilterBase::TPointSpace ptFilter_Brightness::doPointSpace() const {
+  return TPointSpace::Rgb;
+}
+
+//==============================================================================
+
 RegisterHelper BrightnessRegister(&ptFilter_Brightness::createBrightness, CBrightnessId);
 
 //==============================================================================
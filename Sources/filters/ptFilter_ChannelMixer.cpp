@@ -59,6 +59,7 @@ const QString CMixerName   = "MixerName";
 ptFilter_ChannelMixer::ptFilter_ChannelMixer():
   ptFilterBase()
 {
+  FInputSpace = TColorSpace::Rgb;
   this->internalInit();
 }
 
@@ -111,6 +112,12 @@ void ptFilter_ChannelMixer::doRunFilter(ptImage *AImage) {
   AImage->mixChannels(this->configToMatrix());
 }
 
+//------------------------------------------------------------------------------
+
+int ptFilter_ChannelMixer::doHaloRadius() const {
+  return 0;
+}
+
 // -----------------------------------------------------------------------------
 
 TChannelMatrix ptFilter_ChannelMixer::configToMatrix() const {
@@ -76,6 +76,18 @@ void ptFilter_ColorBoost::doRunFilter(ptImage *AImage) {
 
 //==============================================================================
 
+int ptFilter_ColorBoost::doHaloRadius() const {
+  return 0;
+}
+
+//==============================================================================
+
+ptFilterBase::TPointSpace ptFilter_ColorBoost::doPointSpace() const {
+  return TPointSpace::Lab;
+}
+
+//==============================================================================
+
 RegisterHelper ColorBoostRegister(&ptFilter_ColorBoost::createColorBoost, CColorBoostId);
 
 //==============================================================================
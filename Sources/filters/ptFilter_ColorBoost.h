@@ -38,6 +38,8 @@ protected:
   void      doDefineControls() override;
   bool      doCheckHasActiveCfg() override;
   void      doRunFilter(ptImage *AImage) override;
+  int       doHaloRadius() const override;
+  TPointSpace doPointSpace() const override;
 
 
 private:
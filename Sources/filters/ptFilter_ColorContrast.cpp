@@ -38,6 +38,7 @@ const QString CHaloControl  = "HaloControl";
 ptFilter_ColorContrast::ptFilter_ColorContrast()
 : ptFilterBase()
 {
+  FInputSpace = TColorSpace::Lab;
   internalInit();
 }
 
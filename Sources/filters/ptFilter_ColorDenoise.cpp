@@ -43,6 +43,7 @@ ptFilter_ColorDenoise::ptFilter_ColorDenoise():
   ptFilterBase()
 {
   FIsSlow = true;
+  FInputSpace = TColorSpace::Lab;
   this->internalInit();
 }
 
@@ -103,6 +104,13 @@ void ptFilter_ColorDenoise::doRunFilter(ptImage *AImage) {
 
 //------------------------------------------------------------------------------
 
+bool ptFilter_ColorDenoise::doPrefersPlanar() const {
+  // Each pass only reads and writes one of a* and b*.
+  return true;
+}
+
+//------------------------------------------------------------------------------
+
 RegisterHelper ColorDenoiseRegister(&ptFilter_ColorDenoise::createColorDenoise, CColorDenoiseId);
 
 //------------------------------------------------------------------------------
@@ -37,6 +37,7 @@ ptFilter_ColorEnhancement::ptFilter_ColorEnhancement()
 : ptFilterBase()
 {
 //  FHelpUri = "http://photivo.org/something";
+  FInputSpace = TColorSpace::Rgb;
   internalInit();
 }
 
@@ -76,6 +77,12 @@ void ptFilter_ColorEnhancement::doRunFilter(ptImage *AImage) {
 
 //==============================================================================
 
+int ptFilter_ColorEnhancement::doHaloRadius() const {
+  return 0;
+}
+
+//==============================================================================
+
 RegisterHelper ColorEnhancementRegister(&ptFilter_ColorEnhancement::createColorEnhancement, CColorEnhancementId);
 
 //==============================================================================
@@ -40,6 +40,7 @@ ptFilter_ColorIntensity::ptFilter_ColorIntensity()
 : ptFilterBase()
 {
 //  FHelpUri = "http://photivo.org/something";
+  FInputSpace = TColorSpace::Rgb;
   internalInit();
 }
 
@@ -97,6 +98,12 @@ void ptFilter_ColorIntensity::doRunFilter(ptImage *AImage) {
 
 //==============================================================================
 
+int ptFilter_ColorIntensity::doHaloRadius() const {
+  return 0;
+}
+
+//==============================================================================
+
 RegisterHelper ColorIntensityRegister(&ptFilter_ColorIntensity::createColorIntensity, CColorIntensityId);
 
 //==============================================================================
@@ -38,6 +38,7 @@ protected:
   void      doDefineControls() override;
   bool      doCheckHasActiveCfg() override;
   void      doRunFilter(ptImage *AImage) override;
+  int       doHaloRadius() const override;
 
 private:
   ptFilter_ColorIntensity();
@@ -48,6 +48,8 @@ ptFilter_ColorTone::ptFilter_ColorTone():
 {
 //  FHelpUri = "http://photivo.org/something";
 
+  FInputSpace = TColorSpace::Rgb;
+
   // internalInit() cannot be done here because controls’ values depend on
   // the concrete filter instance. We need the unique name which is not set yet.
   // Init is performed by doAfterInit() instead.
@@ -118,6 +120,12 @@ void ptFilter_ColorTone::doRunFilter(ptImage* AImage) {
 
 //------------------------------------------------------------------------------
 
+int ptFilter_ColorTone::doHaloRadius() const {
+  return 0;
+}
+
+//------------------------------------------------------------------------------
+
 QWidget* ptFilter_ColorTone::doCreateGui() {
   auto guiBody = new QWidget;
   Ui_ColorToneForm form;
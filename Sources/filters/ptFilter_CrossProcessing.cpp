@@ -39,6 +39,7 @@ ptFilter_CrossProcessing::ptFilter_CrossProcessing():
   ptFilterBase()
 {
 //  FHelpUri = "http://photivo.org/something";
+  FInputSpace = TColorSpace::Rgb;
   this->internalInit();
 }
 
@@ -90,6 +91,12 @@ void ptFilter_CrossProcessing::doRunFilter(ptImage* AImage) {
 
 //------------------------------------------------------------------------------
 
+int ptFilter_CrossProcessing::doHaloRadius() const {
+  return 0;
+}
+
+//------------------------------------------------------------------------------
+
 RegisterHelper CrossProcessingRegister(&ptFilter_CrossProcessing::createCrossProcessing, CCrossProcessingId);
 
 //------------------------------------------------------------------------------
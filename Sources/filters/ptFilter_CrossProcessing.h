@@ -35,6 +35,7 @@ protected:
   void      doDefineControls() override;
   bool      doCheckHasActiveCfg() override;
   void      doRunFilter(ptImage* AImage) override;
+  int       doHaloRadius() const override;
 
 private:
   ptFilter_CrossProcessing();
@@ -48,6 +48,7 @@ const QString CColorPurple = "ColorPurple";
 ptFilter_Defringe::ptFilter_Defringe():
   ptFilterBase()
 {
+  FInputSpace = TColorSpace::Lab;
   this->internalInit();
 }
 
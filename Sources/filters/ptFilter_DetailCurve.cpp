@@ -39,6 +39,7 @@ const QString CAntiBadpixel = "AntiBadpixel";
 ptFilter_DetailCurve::ptFilter_DetailCurve()
 : ptFilterBase()
 {
+  FInputSpace = TColorSpace::Lab;
   internalInit();
 }
 
@@ -38,6 +38,7 @@ ptFilter_Drc::ptFilter_Drc()
 : ptFilterBase()
 {
   FIsSlow = true;
+  FInputSpace = TColorSpace::Lab;
 //  FHelpUri = "http://photivo.org/something";
   internalInit();
 }
@@ -79,6 +80,12 @@ void ptFilter_Drc::doRunFilter(ptImage *AImage) {
 
 //==============================================================================
 
+bool ptFilter_Drc::doSupportsFloat() const {
+  return true;
+}
+
+//==============================================================================
+
 RegisterHelper DrcRegister(&ptFilter_Drc::createDrc, CDrcId);
 
 //==============================================================================
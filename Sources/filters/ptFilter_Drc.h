@@ -37,6 +37,7 @@ protected:
   void      doDefineControls() override;
   bool      doCheckHasActiveCfg() override;
   void      doRunFilter(ptImage *AImage) override;
+  bool      doSupportsFloat() const override;
 
 private:
   ptFilter_Drc();
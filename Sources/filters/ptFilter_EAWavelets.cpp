@@ -46,6 +46,7 @@ const QString CLevel6 = "Level6";
 ptFilter_EAWavelets::ptFilter_EAWavelets():
   ptFilterBase()
 {
+  FInputSpace = TColorSpace::Lab;
   this->internalInit();
 }
 
@@ -172,6 +173,19 @@ void ptFilter_EAWavelets::doRunFilter(ptImage *AImage) {
 
 //------------------------------------------------------------------------------
 
+bool ptFilter_EAWavelets::doSupportsFloat() const {
+  return true;
+}
+
+//------------------------------------------------------------------------------
+
+bool ptFilter_EAWavelets::doPrefersPlanar() const {
+  // Only L is read and written.
+  return true;
+}
+
+//------------------------------------------------------------------------------
+
 QWidget *ptFilter_EAWavelets::doCreateGui() {
   auto guiBody = new QWidget;
   Ui_EAWaveletsForm form;
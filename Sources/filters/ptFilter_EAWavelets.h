@@ -36,6 +36,8 @@ protected:
   void      doDefineControls() override;
   bool      doCheckHasActiveCfg() override;
   void      doRunFilter(ptImage *AImage) override;
+  bool      doSupportsFloat() const override;
+  bool      doPrefersPlanar() const override;
 
 private:
   ptFilter_EAWavelets();
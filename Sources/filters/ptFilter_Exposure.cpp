@@ -47,6 +47,7 @@ ptFilter_Exposure::ptFilter_Exposure():
   ptFilterBase()
 {
 //  FHelpUri = "http://photivo.org/something";
+  FInputSpace = TColorSpace::Rgb;
   internalInit();
 }
 
@@ -181,6 +182,16 @@ void ptFilter_Exposure::doRunFilter(ptImage* AImage) {
 
 // -----------------------------------------------------------------------------
 
+int ptFilter_Exposure::doHaloRadius() const {
+  // Auto exposure measures the whole image, so it cannot work strip by strip.
+  if (static_cast<TMode>(FConfig.value(CExposureMode).toInt()) == TMode::Manual) {
+    return 0;
+  }
+  return -1;
+}
+
+// -----------------------------------------------------------------------------
+
 double ptFilter_Exposure::calcAutoExposure() const {
   auto whiteFrac = TheProcessor->m_Image_AfterGeometry->CalculateFractionLevel(
       FConfig.value(CWhiteFraction).toInt() / 100.0,
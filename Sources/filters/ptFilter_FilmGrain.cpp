@@ -57,6 +57,7 @@ ptFilter_FilmGrain::ptFilter_FilmGrain():
   ptFilterBase()
 {
 //  FHelpUri = "http://photivo.org/something";
+  FInputSpace = TColorSpace::Lab;
   this->internalInit();
 }
 
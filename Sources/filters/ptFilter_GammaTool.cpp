@@ -74,6 +74,18 @@ void ptFilter_GammaTool::doRunFilter(ptImage *AImage) {
 
 //==============================================================================
 
+int ptFilter_GammaTool::doHaloRadius() const {
+  return 0;
+}
+
+//==============================================================================
+
+ptFilterBase::TPointSpace ptFilter_GammaTool::doPointSpace() const {
+  return TPointSpace::Rgb;
+}
+
+//==============================================================================
+
 RegisterHelper GammaToolRegister(&ptFilter_GammaTool::CreateGammaTool, CGammaToolId);
 
 //==============================================================================
@@ -41,6 +41,7 @@ const QString CCleanup       = "Cleanup";
 ptFilter_GradientSharpen::ptFilter_GradientSharpen():
   ptFilterBase()
 {
+  FInputSpace = TColorSpace::Lab;
   this->internalInit();
 }
 
@@ -51,6 +51,7 @@ ptFilter_GradualBlur::ptFilter_GradualBlur():
   ptFilterBase()
 {
   FIsSlow = true;
+  FInputSpace = TColorSpace::Rgb;
   FHelpUri = "http://photivo.org/manual/tabs/eyecandy#gradual_blur";
   this->internalInit();
 }
@@ -49,6 +49,8 @@ ptFilter_GradualOverlay::ptFilter_GradualOverlay():
 {
 //  FHelpUri = "http://photivo.org/something";
 
+  FInputSpace = TColorSpace::Rgb;
+
   // internalInit() cannot be done here because controls’ values depend on
   // the concrete filter instance. We need the unique name which is not set yet.
   // Init is performed by doAfterInit() instead.
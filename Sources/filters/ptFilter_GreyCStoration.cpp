@@ -56,6 +56,7 @@ ptFilter_GreyCStoration::ptFilter_GreyCStoration():
   ptFilterBase()
 {
   FIsSlow = true;
+  FInputSpace = TColorSpace::Lab;
   this->internalInit();
 }
 
@@ -37,6 +37,7 @@ const QString CHighlightsB  = "HighlightsB";
 ptFilter_Highlights::ptFilter_Highlights()
 : ptFilterBase()
 {
+  FInputSpace = TColorSpace::Rgb;
   internalInit();
 }
 
@@ -79,6 +80,12 @@ void ptFilter_Highlights::doRunFilter(ptImage *AImage) {
 
 //==============================================================================
 
+int ptFilter_Highlights::doHaloRadius() const {
+  return 0;
+}
+
+//==============================================================================
+
 RegisterHelper HighlightsRegister(&ptFilter_Highlights::CreateHighlights, CHighlightsId);
 
 //==============================================================================
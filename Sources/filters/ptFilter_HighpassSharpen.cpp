@@ -44,6 +44,7 @@ const QString CDenoise  = "Denoise";
 ptFilter_HighpassSharpen::ptFilter_HighpassSharpen():
   ptFilterBase()
 {
+  FInputSpace = TColorSpace::Lab;
   this->internalInit();
 }
 
@@ -36,6 +36,7 @@ const QString CThresholdAB = "ThresholdAB";
 ptFilter_ImpulseNR::ptFilter_ImpulseNR():
   ptFilterBase()
 {
+  FInputSpace = TColorSpace::Lab;
   this->internalInit();
 }
 
@@ -39,6 +39,7 @@ const QString CAmplitude  = "Amplitude";
 ptFilter_InvDiffSharpen::ptFilter_InvDiffSharpen():
   ptFilterBase()
 {
+  FInputSpace = TColorSpace::Lab;
   this->internalInit();
 }
 
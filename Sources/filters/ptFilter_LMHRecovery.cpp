@@ -53,6 +53,8 @@ ptFilter_LMHRecovery::ptFilter_LMHRecovery(const QString &AFilterName, TColorSpa
 //  FHelpUri = "http://photivo.org/something";
   FFilterName = AFilterName;
   FColorSpace = AColorSpace;
+  FInputSpace = (AColorSpace == TColorSpace::Lab) ? ptFilterBase::TColorSpace::Lab
+                                                  : ptFilterBase::TColorSpace::Rgb;
   internalInit();
 }
 
@@ -135,6 +137,12 @@ void ptFilter_LMHRecovery::doRunFilter(ptImage *AImage) {
 
 //==============================================================================
 
+int ptFilter_LMHRecovery::doHaloRadius() const {
+  return 0;
+}
+
+//==============================================================================
+
 
 QWidget *ptFilter_LMHRecovery::doCreateGui() {
   auto hGuiBody = new QWidget;
@@ -35,6 +35,7 @@ ptFilter_LabTransform::ptFilter_LabTransform()
 : ptFilterBase()
 {
 //  FHelpUri = "http://photivo.org/something";
+  FInputSpace = TColorSpace::Rgb;
   internalInit();
 }
 
@@ -77,6 +78,12 @@ void ptFilter_LabTransform::doRunFilter(ptImage *AImage) {
 
 //==============================================================================
 
+int ptFilter_LabTransform::doHaloRadius() const {
+  return 0;
+}
+
+//==============================================================================
+
 RegisterHelper LabTransformRegister(&ptFilter_LabTransform::createLabTransform, CLabTransformId);
 
 //==============================================================================
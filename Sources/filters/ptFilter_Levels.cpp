@@ -103,6 +103,18 @@ void ptFilter_Levels::doRunFilter(ptImage *AImage) {
 
 //==============================================================================
 
+int ptFilter_Levels::doHaloRadius() const {
+  return 0;
+}
+
+//==============================================================================
+
+ptFilterBase::TPointSpace ptFilter_Levels::doPointSpace() const {
+  return (FColorSpace == TColorSpace::Lab) ? TPointSpace::Lab : TPointSpace::Rgb;
+}
+
+//==============================================================================
+
 RegisterHelper LevelsRgbRegister(&ptFilter_Levels::createLevelsRgb, CLevelsRgbId);
 RegisterHelper LevelsLabRegister(&ptFilter_Levels::createLevelsLab, CLevelsLabId);
 
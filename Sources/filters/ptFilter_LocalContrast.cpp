@@ -62,6 +62,7 @@ ptFilter_LocalContrast::ptFilter_LocalContrast():
 ptFilterBase *ptFilter_LocalContrast::createLocalContrastRgb() {
   auto hInstance         = new ptFilter_LocalContrast;
   hInstance->FFilterName = CLocalContrastRgbId;
+  hInstance->FInputSpace = TColorSpace::Rgb;
   hInstance->FCaption    = tr("Local contrast");
   return hInstance;
 }
@@ -71,6 +72,7 @@ ptFilterBase *ptFilter_LocalContrast::createLocalContrastRgb() {
 ptFilterBase *ptFilter_LocalContrast::createLocalContrastLab() {
   auto hInstance         = new ptFilter_LocalContrast;
   hInstance->FFilterName = CLocalContrastLabId;
+  hInstance->FInputSpace = TColorSpace::Lab;
   hInstance->FCaption    = tr("Local contrast");
   return hInstance;
 }
@@ -45,6 +45,8 @@ ptFilter_LocalContrastStretch::ptFilter_LocalContrastStretch():
   ptFilterBase()
 {
   FIsSlow = true;
+  FInputSpace = TColorSpace::Lab;
+
   // internalInit() cannot be done here because controls’ values depend on
   // the concrete filter instance. We need the unique name which is not set yet.
   // Init is performed by doAfterInit() instead.
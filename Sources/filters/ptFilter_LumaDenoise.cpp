@@ -43,6 +43,7 @@ ptFilter_LumaDenoise::ptFilter_LumaDenoise():
   ptFilterBase()
 {
   FIsSlow = true;
+  FInputSpace = TColorSpace::Lab;
   this->internalInit();
 }
 
@@ -43,6 +43,7 @@ ptFilter_LumaDenoiseCurve::ptFilter_LumaDenoiseCurve()
 : ptFilterBase()
 {
   FIsSlow = true;
+  FInputSpace = TColorSpace::Lab;
   internalInit();
 }
 
@@ -44,6 +44,7 @@ const QString CAdjustMagenta    = "AdjustMagenta";
 ptFilter_LumaSatAdjust::ptFilter_LumaSatAdjust()
 : ptFilterBase()
 {
+  FInputSpace = TColorSpace::Lch;
   internalInit();
 }
 
@@ -99,7 +100,8 @@ bool ptFilter_LumaSatAdjust::doCheckHasActiveCfg() {
 //==============================================================================
 
 void ptFilter_LumaSatAdjust::doRunFilter(ptImage *AImage) {
-  AImage->toLab();
+  // hue filters also take LCh, see ptImage::LabToLch()
+  if (AImage->m_ColorSpace != ptSpace_LCH) AImage->toLab();
 
   switch (FMode) {
     case LumaMode:
@@ -131,6 +133,12 @@ void ptFilter_LumaSatAdjust::doRunFilter(ptImage *AImage) {
 
 //==============================================================================
 
+int ptFilter_LumaSatAdjust::doHaloRadius() const {
+  return 0;
+}
+
+//==============================================================================
+
 RegisterHelper LumaSatAdjustRegister(&ptFilter_LumaSatAdjust::createLumaAdjust, CLumaAdjustId);
 RegisterHelper SatAdjustRegister(&ptFilter_LumaSatAdjust::createSatAdjust, CSatAdjustId);
 
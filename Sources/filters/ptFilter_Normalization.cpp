@@ -36,6 +36,7 @@ ptFilter_Normalization::ptFilter_Normalization()
 : ptFilterBase()
 {
 //  FHelpUri = "http://photivo.org/something";
+  FInputSpace = TColorSpace::Rgb;
   internalInit();
 }
 
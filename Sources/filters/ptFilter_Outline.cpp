@@ -43,6 +43,7 @@ const QString CCurve         = "Curve";
 ptFilter_Outline::ptFilter_Outline()
 : ptFilterBase()
 {
+  FInputSpace = TColorSpace::Lab;
   internalInit();
 }
 
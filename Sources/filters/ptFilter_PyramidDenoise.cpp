@@ -42,6 +42,7 @@ const QString CLevels         = "Levels";
 ptFilter_PyramidDenoise::ptFilter_PyramidDenoise():
   ptFilterBase()
 {
+  FInputSpace = TColorSpace::Lab;
   this->internalInit();
 }
 
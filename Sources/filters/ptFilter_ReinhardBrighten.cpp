@@ -39,6 +39,7 @@ ptFilter_ReinhardBrighten::ptFilter_ReinhardBrighten()
 : ptFilterBase()
 {
 //  FHelpUri = "http://photivo.org/something";
+  FInputSpace = TColorSpace::Rgb;
   internalInit();
 }
 
@@ -38,6 +38,7 @@ const QString CMode     = "Mode";
 ptFilter_SatCurve::ptFilter_SatCurve()
 : ptFilterBase()
 {
+  FInputSpace = TColorSpace::Lch;
   internalInit();
 }
 
@@ -77,13 +78,20 @@ bool ptFilter_SatCurve::doCheckHasActiveCfg() {
 //==============================================================================
 
 void ptFilter_SatCurve::doRunFilter(ptImage *AImage) {
-  AImage->toLab();
+  // hue filters also take LCh, see ptImage::LabToLch()
+  if (AImage->m_ColorSpace != ptSpace_LCH) AImage->toLab();
   AImage->ApplySaturationCurve(FConfig.items()[0].Curve.get(),
                                FConfig.value(CMode).toInt());
 }
 
 //==============================================================================
 
+int ptFilter_SatCurve::doHaloRadius() const {
+  return 0;
+}
+
+//==============================================================================
+
 RegisterHelper SatCurveRegister(&ptFilter_SatCurve::CreateSatCurve, CSatCurveId);
 
 //==============================================================================
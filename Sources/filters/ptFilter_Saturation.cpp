@@ -35,6 +35,7 @@ ptFilter_Saturation::ptFilter_Saturation()
 : ptFilterBase()
 {
 //  FHelpUri = "http://photivo.org/something";
+  FInputSpace = TColorSpace::Lab;
   internalInit();
 }
 
@@ -71,6 +72,12 @@ void ptFilter_Saturation::doRunFilter(ptImage *AImage) {
 
 //==============================================================================
 
+int ptFilter_Saturation::doHaloRadius() const {
+  return 0;
+}
+
+//==============================================================================
+
 RegisterHelper SaturationRegister(&ptFilter_Saturation::createSaturation, CSaturationId);
 
 //==============================================================================
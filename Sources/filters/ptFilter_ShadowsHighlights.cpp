@@ -39,6 +39,7 @@ const QString CCurve        = "Curve";
 ptFilter_ShadowsHighlights::ptFilter_ShadowsHighlights()
 : ptFilterBase()
 {
+  FInputSpace = TColorSpace::Lab;
   internalInit();
 }
 
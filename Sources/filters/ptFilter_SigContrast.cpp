@@ -91,6 +91,18 @@ void ptFilter_SigContrast::doRunFilter(ptImage *AImage) {
 
 //==============================================================================
 
+int ptFilter_SigContrast::doHaloRadius() const {
+  return 0;
+}
+
+//==============================================================================
+
+ptFilterBase::TPointSpace ptFilter_SigContrast::doPointSpace() const {
+  return (FColorSpace == TColorSpace::Lab) ? TPointSpace::Lab : TPointSpace::Rgb;
+}
+
+//==============================================================================
+
 /* static */
 ptFilterBase *ptFilter_SigContrast::CreateLabContrast() {
   ptFilter_SigContrast *hInstance = new ptFilter_SigContrast(CSigContrastLabId,
@@ -40,6 +40,8 @@ protected:
   void doDefineControls() override;
   bool doCheckHasActiveCfg() override;
   void doRunFilter(ptImage *AImage) override;
+  int  doHaloRadius() const override;
+  TPointSpace doPointSpace() const override;
 
 private:
   enum class TColorSpace { Rgb, Lab };
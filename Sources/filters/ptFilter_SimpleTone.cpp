@@ -82,6 +82,18 @@ void ptFilter_SimpleTone::doRunFilter(ptImage *AImage) {
 
 //------------------------------------------------------------------------------
 
+int ptFilter_SimpleTone::doHaloRadius() const {
+  return 0;
+}
+
+//------------------------------------------------------------------------------
+
+ptFilterBase::TPointSpace ptFilter_SimpleTone::doPointSpace() const {
+  return TPointSpace::Rgb;
+}
+
+//------------------------------------------------------------------------------
+
 RegisterHelper SimpleToneRegister(&ptFilter_SimpleTone::createSimpleTone, CSimpleToneId);
 
 //------------------------------------------------------------------------------
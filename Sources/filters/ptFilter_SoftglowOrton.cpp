@@ -45,6 +45,7 @@ ptFilter_SoftglowOrton::ptFilter_SoftglowOrton():
   ptFilterBase()
 {
 //  FHelpUri = "http://photivo.org/something";
+  FInputSpace = TColorSpace::Rgb;
   this->internalInit();
 }
 
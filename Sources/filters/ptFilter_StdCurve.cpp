@@ -73,11 +73,12 @@ void ptFilter_StdCurve::doRunFilter(ptImage *AImage) {
                               (int) (logf(TheProcessor->m_ScaleFactor)/logf(0.5)));
 
   } else if (FFilterName == "LumaByHueCurve") {
-    AImage->toLab();
+    // hue filters also take LCh, see ptImage::LabToLch()
+    if (AImage->m_ColorSpace != ptSpace_LCH) AImage->toLab();
     AImage->ApplyLByHueCurve(FConfig.items()[0].Curve.get());
 
   } else if (FFilterName == "HueCurve") {
-    AImage->toLab();
+    if (AImage->m_ColorSpace != ptSpace_LCH) AImage->toLab();
     AImage->ApplyHueCurve(FConfig.items()[0].Curve.get());
 
   } else if (FFilterName == "LCurve") {
@@ -103,6 +104,32 @@ void ptFilter_StdCurve::doRunFilter(ptImage *AImage) {
 
 //==============================================================================
 
+int ptFilter_StdCurve::doHaloRadius() const {
+  // The texture curve works on a blurred copy of L.
+  return (FFilterName == "TextureCurve") ? -1 : 0;
+}
+
+//==============================================================================
+
+ptFilterBase::TPointSpace ptFilter_StdCurve::doPointSpace() const {
+  if (FFilterName == "LCurve") return TPointSpace::Lab;
+  if (FFilterName == "RgbCurve"   || FFilterName == "RToneCurve" ||
+      FFilterName == "GToneCurve" || FFilterName == "BToneCurve")
+    return TPointSpace::Rgb;
+  // Hue dependent, texture and the space agnostic after gamma curve.
+  return TPointSpace::None;
+}
+
+//==============================================================================
+
+ptFilterBase::TColorSpace ptFilter_StdCurve::doInputSpace() const {
+  if (FFilterName == "LumaByHueCurve" || FFilterName == "HueCurve") return TColorSpace::Lch;
+  if (FFilterName == "TextureCurve") return TColorSpace::Lab;
+  return ptFilterBase::doInputSpace();
+}
+
+//==============================================================================
+
 bool ptFilter_StdCurve::doCheckHasActiveCfg() {
   return !FConfig.items()[0].Curve->isNull();
 }
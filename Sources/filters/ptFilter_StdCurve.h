@@ -52,6 +52,9 @@ protected:
   void      doDefineControls() override;
   bool      doCheckHasActiveCfg() override;
   void      doRunFilter(ptImage *AImage) override;
+  int       doHaloRadius() const override;
+  TPointSpace doPointSpace() const override;
+  TColorSpace doInputSpace() const override;
 
 private:
   ptFilter_StdCurve(std::shared_ptr<ptCurve> ACurve);
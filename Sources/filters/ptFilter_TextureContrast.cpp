@@ -57,6 +57,7 @@ ptFilter_TextureContrast::ptFilter_TextureContrast():
 ptFilterBase *ptFilter_TextureContrast::createTextureContrastRgb() {
   auto hInstance         = new ptFilter_TextureContrast;
   hInstance->FFilterName = CTextureContrastRgbId;
+  hInstance->FInputSpace = TColorSpace::Rgb;
   hInstance->FCaption    = tr("Texture contrast");
   return hInstance;
 }
@@ -66,6 +67,7 @@ ptFilterBase *ptFilter_TextureContrast::createTextureContrastRgb() {
 ptFilterBase *ptFilter_TextureContrast::createTextureContrastLab() {
   auto hInstance         = new ptFilter_TextureContrast;
   hInstance->FFilterName = CTextureContrastLabId;
+  hInstance->FInputSpace = TColorSpace::Lab;
   hInstance->FCaption    = tr("Texture contrast");
   return hInstance;
 }
@@ -54,6 +54,7 @@ ptFilter_TextureOverlay::ptFilter_TextureOverlay():
   ptFilterBase()
 {
 //  FHelpUri = "http://photivo.org/something";
+  FInputSpace = TColorSpace::Rgb;
   this->internalInit();
 }
 
@@ -51,6 +51,7 @@ ptFilter_Tone::ptFilter_Tone()
 : ptFilterBase()
 {
 //  FHelpUri = "http://photivo.org/something";
+  FInputSpace = TColorSpace::Lab;
   internalInit();
 }
 
@@ -128,6 +129,12 @@ void ptFilter_Tone::doRunFilter(ptImage *AImage) {
 
 //==============================================================================
 
+int ptFilter_Tone::doHaloRadius() const {
+  return 0;
+}
+
+//==============================================================================
+
 QWidget *ptFilter_Tone::doCreateGui() {
   auto hGuiBody = new QWidget;
   Ui_ToneForm hForm;
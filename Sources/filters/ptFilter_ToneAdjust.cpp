@@ -44,6 +44,7 @@ const QString CSoftness     = "Softness";
 ptFilter_ToneAdjust::ptFilter_ToneAdjust()
 : ptFilterBase()
 {
+  FInputSpace = TColorSpace::Lab;
   internalInit();
 }
 
@@ -96,6 +97,12 @@ void ptFilter_ToneAdjust::doRunFilter(ptImage *AImage) {
 
 //==============================================================================
 
+int ptFilter_ToneAdjust::doHaloRadius() const {
+  return 0;
+}
+
+//==============================================================================
+
 RegisterHelper ToneAdjustRegister(&ptFilter_ToneAdjust::CreateToneAdjust, CToneAdjustId);
 
 //==============================================================================
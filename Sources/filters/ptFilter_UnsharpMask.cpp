@@ -44,6 +44,7 @@ const QString CThreshold = "Threshold";
 ptFilter_UnsharpMask::ptFilter_UnsharpMask():
   ptFilterBase()
 {
+  FInputSpace = TColorSpace::Lab;
   this->internalInit();
 }
 
@@ -87,6 +88,14 @@ void ptFilter_UnsharpMask::doRunFilter(ptImage *AImage) {
 
 //------------------------------------------------------------------------------
 
+int ptFilter_UnsharpMask::doHaloRadius() const {
+  // GraphicsMagick cuts the Gaussian where it drops below one quantum step. For 16 bit data
+  // that stays well inside 6 sigma.
+  return static_cast<int>(ceil(6.0 * FConfig.value(CRadius).toDouble() * TheProcessor->m_ScaleFactor)) + 1;
+}
+
+//------------------------------------------------------------------------------
+
 RegisterHelper UnsharpMaskRegister(&ptFilter_UnsharpMask::createUnsharpMask, CUnsharpMaskId);
 
 //------------------------------------------------------------------------------
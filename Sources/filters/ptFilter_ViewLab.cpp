@@ -36,6 +36,7 @@ ptFilter_ViewLab::ptFilter_ViewLab():
   ptFilterBase()
 {
 //  FHelpUri = "http://photivo.org/something";
+  FInputSpace = TColorSpace::Lab;
   this->internalInit();
 }
 
@@ -50,6 +50,8 @@ ptFilter_Vignette::ptFilter_Vignette(TColorSpace AColorSpace)
   FColorSpace(AColorSpace)
 {
 //  FHelpUri = "http://photivo.org/something";
+  FInputSpace = (AColorSpace == TColorSpace::Lab) ? ptFilterBase::TColorSpace::Lab
+                                                  : ptFilterBase::TColorSpace::Rgb;
   internalInit();
 }
 
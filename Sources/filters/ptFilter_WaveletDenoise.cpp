@@ -49,6 +49,7 @@ const QString CBSoftness      = "BSoftness";
 ptFilter_WaveletDenoise::ptFilter_WaveletDenoise():
   ptFilterBase()
 {
+  FInputSpace = TColorSpace::Lab;
   this->internalInit();
 }
 
@@ -127,6 +128,12 @@ void ptFilter_WaveletDenoise::doRunFilter(ptImage *AImage) {
 
 //------------------------------------------------------------------------------
 
+bool ptFilter_WaveletDenoise::doSupportsFloat() const {
+  return true;
+}
+
+//------------------------------------------------------------------------------
+
 QWidget *ptFilter_WaveletDenoise::doCreateGui() {
   auto guiBody = new QWidget;
   Ui_WaveletDenoiseForm form;
@@ -36,6 +36,7 @@ protected:
   void      doDefineControls() override;
   bool      doCheckHasActiveCfg() override;
   void      doRunFilter(ptImage *AImage) override;
+  bool      doSupportsFloat() const override;
 
 private:
   ptFilter_WaveletDenoise();
@@ -42,6 +42,7 @@ ptFilter_Wiener::ptFilter_Wiener()
 : ptFilterBase()
 {
   FIsSlow = true;
+  FInputSpace = TColorSpace::Lab;
   internalInit();
 }
 
@@ -0,0 +1,757 @@
+/*******************************************************************************
+**
+** Photivo
+**
+** Copyright (C) 2026 agent <agent@local>
+**
+** This file is part of Photivo.
+**
+** Photivo is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License version 3
+** as published by the Free Software Foundation.
+**
+** Photivo is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with Photivo.  If not, see <http://www.gnu.org/licenses/>.
+**
+*******************************************************************************/
+
+#include "ptBench.h"
+#include "ptCmsTransformCache.h"
+#include "ptConstants.h"
+#include "ptDcRaw.h"
+#include "ptLabKernels.h"
+#include "ptProcessor.h"
+#include "ptProfiler.h"
+#include "ptSettings.h"
+#include "filters/ptFilterDM.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QMap>
+#include <QTime>
+#include <QtEndian>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#ifdef _OPENMP
+  #include <omp.h>
+#endif
+
+//==============================================================================
+
+extern ptSettings*  Settings;
+extern ptProcessor* TheProcessor;
+extern ptDcRaw*     TheDcRaw;
+
+void        ReportProgress(const QString Message);
+void        CB_Event0();
+ptImageType CheckImageType(QString filename, uint16_t* width, uint16_t* height, ptDcRaw* dcRaw);
+
+//==============================================================================
+
+namespace {
+
+const int      CSizesMPix[] = { 12, 24, 50 };
+const uint16_t CBayerWhite  = 16383;    // 14 bit data in 16 bit containers
+
+// Scene value in 0..1 to the raw value stored in the bench DNG.
+inline uint16_t toRaw(const float AValue) {
+  return (uint16_t)(AValue*0.9f*CBayerWhite);
+}
+
+struct TDemosaicer {
+  short       Quality;
+  const char* Name;
+};
+
+const TDemosaicer CDemosaicers[] = {
+  {ptInterpolation_Linear,   "Linear"},
+  {ptInterpolation_VNG,      "VNG"},
+  {ptInterpolation_VNG4,     "VNG4"},
+  {ptInterpolation_PPG,      "PPG"},
+  {ptInterpolation_AHD,      "AHD"},
+  {ptInterpolation_AHD_mod,  "AHD mod"},
+  {ptInterpolation_DCB,      "DCB"},
+  {ptInterpolation_DCBSoft,  "DCB soft"},
+  {ptInterpolation_DCBSharp, "DCB sharp"},
+  {ptInterpolation_VCD,      "VCD"},
+  {ptInterpolation_LMMSE,    "LMMSE"},
+  {ptInterpolation_AMaZE,    "AMaZE"}
+};
+
+// Small helper to assemble a little endian TIFF/DNG in memory.
+class TTiffWriter {
+public:
+  void entry(const uint16_t ATag, const uint16_t AType, const uint32_t ACount, const QByteArray &AData) {
+    FEntries.append({ATag, AType, ACount, AData});
+  }
+  void shorts(const uint16_t ATag, const QList<uint16_t> &AValues) {
+    QByteArray hData;
+    for (uint16_t hValue: AValues) append(hData, hValue, 2);
+    entry(ATag, 3, AValues.size(), hData);
+  }
+  void longs(const uint16_t ATag, const uint32_t AValue) {
+    QByteArray hData;
+    append(hData, AValue, 4);
+    entry(ATag, 4, 1, hData);
+  }
+  void bytes(const uint16_t ATag, const QByteArray &AValues) {
+    entry(ATag, 1, AValues.size(), AValues);
+  }
+  void ascii(const uint16_t ATag, const QByteArray &AText) {
+    entry(ATag, 2, AText.size()+1, AText + '\0');
+  }
+  void rationals(const uint16_t ATag, const uint16_t AType, const QList<double> &AValues) {
+    QByteArray hData;
+    for (double hValue: AValues) {
+      append(hData, (uint32_t)(int32_t)lround(hValue*10000), 4);
+      append(hData, 10000, 4);
+    }
+    entry(ATag, AType, AValues.size(), hData);
+  }
+
+  /*! Header and IFD for an image whose data follows directly, \c ADataOffsetTag is patched
+      with the offset of that data. */
+  QByteArray header(const uint16_t ADataOffsetTag) {
+    std::sort(FEntries.begin(), FEntries.end(),
+              [](const TEntry &A, const TEntry &B) { return A.Tag < B.Tag; });
+
+    const uint32_t hIfdSize = 2 + FEntries.size()*12 + 4;
+    QByteArray     hExtra;
+    for (const TEntry &hEntry: FEntries)
+      if (hEntry.Data.size() > 4) hExtra.append(hEntry.Data.size() & 1 ? hEntry.Data + '\0' : hEntry.Data);
+    uint32_t hDataOffset = 8 + hIfdSize + hExtra.size();
+
+    QByteArray hResult("II*\0", 4);
+    append(hResult, 8, 4);
+    append(hResult, FEntries.size(), 2);
+    uint32_t hExtraOffset = 8 + hIfdSize;
+    for (TEntry &hEntry: FEntries) {
+      if (hEntry.Tag == ADataOffsetTag) {
+        hEntry.Data.clear();
+        append(hEntry.Data, hDataOffset, 4);
+      }
+      append(hResult, hEntry.Tag, 2);
+      append(hResult, hEntry.Type, 2);
+      append(hResult, hEntry.Count, 4);
+      if (hEntry.Data.size() > 4) {
+        append(hResult, hExtraOffset, 4);
+        hExtraOffset += hEntry.Data.size() + (hEntry.Data.size() & 1);
+      } else {
+        hResult.append(hEntry.Data.leftJustified(4, '\0'));
+      }
+    }
+    append(hResult, 0, 4);   // no next IFD
+    hResult.append(hExtra);
+    return hResult;
+  }
+
+private:
+  struct TEntry {
+    uint16_t   Tag;
+    uint16_t   Type;
+    uint32_t   Count;
+    QByteArray Data;
+  };
+
+  static void append(QByteArray &ATarget, const uint32_t AValue, const int ABytes) {
+    for (int i = 0; i < ABytes; ++i) ATarget.append((char)((AValue >> (8*i)) & 0xff));
+  }
+
+  QList<TEntry> FEntries;
+};
+
+} // namespace
+
+//==============================================================================
+
+ptBench::ptBench() {}
+
+//==============================================================================
+
+int ptBench::run(const QString &APresets) {
+  const QStringList hPresets = collectPresets(APresets);
+  if (hPresets.isEmpty()) {
+    printf("ptBench: no settings files found in '%s'.\n", APresets.toLocal8Bit().data());
+    return EXIT_FAILURE;
+  }
+
+  benchLabKernels();
+  benchColorLut();
+  benchDemosaic();
+
+  Settings->SetValue("JobMode",1);
+  CB_Event0();
+  GProfiler->setEnabled(true);
+
+  for (int hMPix: CSizesMPix) {
+    // 3:2 frame, even dimensions for the Bayer pattern
+    const uint16_t hWidth  = (uint16_t)(sqrt(hMPix*1.0e6*1.5)) & ~1;
+    const uint16_t hHeight = (uint16_t)(hMPix*1.0e6/hWidth) & ~1;
+
+    for (TInputKind hKind: {ikBayer, ikBitmap}) {
+      const QString hLabel = QString("%1 MP %2").arg(hMPix).arg(hKind == ikBayer ? "bayer" : "bitmap");
+      const QString hFile  = QDir::tempPath() +
+                             QString("/ptBench_%1mp.%2").arg(hMPix).arg(hKind == ikBayer ? "dng" : "ppm");
+
+      printf("ptBench: generating %s input (%dx%d)\n", hLabel.toLocal8Bit().data(), hWidth, hHeight);
+      const bool hWritten = (hKind == ikBayer) ? writeBayerDng(hFile, hWidth, hHeight)
+                                               : writeBitmap(hFile, hWidth, hHeight);
+      if (!hWritten) {
+        printf("ptBench: cannot write '%s'.\n", hFile.toLocal8Bit().data());
+        continue;
+      }
+
+      for (const QString &hPreset: hPresets)
+        runPreset(hFile, hPreset, hLabel);
+
+      QFile::remove(hFile);
+    }
+  }
+
+  printf("ptBench: peak resident memory %.0f MB\n", ptProfiler::peakResidentBytes()/1048576.0);
+  GProfiler->flush();
+  return EXIT_SUCCESS;
+}
+
+//==============================================================================
+
+QStringList ptBench::collectPresets(const QString &APresets) {
+  QFileInfo hInfo(APresets);
+  if (hInfo.isFile()) return QStringList(hInfo.absoluteFilePath());
+  if (!hInfo.isDir()) return QStringList();
+
+  QStringList hResult;
+  QDir hDir(APresets);
+  for (const QFileInfo &hFile: hDir.entryInfoList(QStringList("*.pts"), QDir::Files, QDir::Name))
+    hResult << hFile.absoluteFilePath();
+  return hResult;
+}
+
+//==============================================================================
+// RGB <-> Lab on a 12 MP sRGB scene, the vectorised kernels of ptImage against the former
+// double precision code. The difference is in 16 bit steps; the former RGB->Lab rounds XYZ
+// to its lookup table, which alone is a few steps in dark saturated colours.
+void ptBench::benchLabKernels() {
+  const uint16_t hWidth  = 4240;
+  const uint16_t hHeight = 2832;
+  const size_t   hSize   = (size_t)hWidth*hHeight;
+  const double   hMPix   = hSize/1.0e6;
+
+  std::vector<uint16_t> hScene(hSize*3);
+  for (uint16_t y = 0; y < hHeight; ++y)
+    for (uint16_t x = 0; x < hWidth; ++x)
+      for (int c = 0; c < 3; ++c)
+        hScene[((size_t)y*hWidth + x)*3 + c] =
+          (uint16_t)(sceneValue(x, y, c, hWidth, hHeight)*0xffff);
+
+  const double (&hToXyz)[3][3] = MatrixRGBToXYZ[ptSpace_sRGB_D65];
+  const double (&hToRgb)[3][3] = MatrixXYZToRGB[ptSpace_sRGB_D65];
+  float hToXyzF[3][3];
+  float hToRgbF[3][3];
+  float hOffset[3];
+  for (int c = 0; c < 3; ++c) {
+    hOffset[c] = 0.0f;
+    for (int k = 0; k < 3; ++k) {
+      hToXyzF[c][k] = hToXyz[c][k]/(D65Reference[c]*ptWP);
+      hToRgbF[c][k] = hToRgb[c][k]*D65Reference[k]*ptWP;
+      hOffset[c]   -= 0.5f*hToRgb[c][k];
+    }
+  }
+
+  std::vector<uint16_t> hRef(hScene);
+  std::vector<uint16_t> hVec(hScene);
+  auto hPixels = [](std::vector<uint16_t> &ABuffer) { return (uint16_t (*)[3])ABuffer.data(); };
+  auto hMaxDiff = [&]() {
+    int hDiff = 0;
+    for (size_t i = 0; i < hRef.size(); ++i) hDiff = qMax(hDiff, qAbs((int)hRef[i] - (int)hVec[i]));
+    return hDiff;
+  };
+  auto hReport = [&](const char *AName, const int ARefMs, const int AVecMs) {
+    printf("  %-32s %10d %10d %10.2f %10d\n", AName, ARefMs, AVecMs,
+           AVecMs > 0 ? (double)ARefMs/AVecMs : 0.0, hMaxDiff());
+  };
+
+  printf("\nptBench: Lab conversion, %.1f MP, %s kernels, single thread\n",
+         hMPix, ptLabKernels::isaName());
+  printf("  %-32s %10s %10s %10s %10s\n", "Step", "ref ms", "vec ms", "speedup", "max diff");
+
+  QTime hTimer;
+  hTimer.start();
+  ptLabKernels::rgbToLabReference(hPixels(hRef), hSize, hToXyz, D65Reference);
+  const int hRefMs = hTimer.restart();
+  ptLabKernels::rgbToLab(hPixels(hVec), hSize, hToXyzF);
+  hReport("RGB to Lab", hRefMs, hTimer.elapsed());
+
+  // Both back from the same Lab data, so only this step is compared.
+  hVec = hRef;
+  const std::vector<uint16_t> hLab(hRef);
+  hTimer.restart();
+  ptLabKernels::labToRgbReference(hPixels(hRef), hSize, hToRgb, D65Reference);
+  const int hRefBackMs = hTimer.restart();
+  ptLabKernels::labToRgb(hPixels(hVec), hSize, hToRgbF, hOffset);
+  hReport("Lab to RGB", hRefBackMs, hTimer.elapsed());
+
+  // Lab -> LCh -> Lab as around the hue filters, the former atan2f()/sinf()/cosf()
+  // code against the polar kernels.
+  hRef = hLab;
+  hVec = hLab;
+  std::vector<float> hChroma(hSize);
+  std::vector<float> hHue(hSize);
+  hTimer.restart();
+  for (size_t i = 0; i < hSize; ++i) {
+    const float hA = (float)hRef[i*3+1] - ptWPHLab;
+    const float hB = (float)hRef[i*3+2] - ptWPHLab;
+    hChroma[i] = sqrtf(hA*hA + hB*hB);
+    hHue[i]    = (hA == 0.0f && hB == 0.0f) ? 0.0f : atan2f(hB, hA);
+    if (hHue[i] < 0.0f) hHue[i] += pt2PI;
+  }
+  for (size_t i = 0; i < hSize; ++i) {
+    hRef[i*3+1] = CLIP((int32_t)(cosf(hHue[i])*hChroma[i] + ptWPHLab));
+    hRef[i*3+2] = CLIP((int32_t)(sinf(hHue[i])*hChroma[i] + ptWPHLab));
+  }
+  const int hRefPolarMs = hTimer.restart();
+  ptLabKernels::labToPolar(hPixels(hVec), hSize, ptWPHLab, hChroma.data(), hHue.data());
+  ptLabKernels::polarToLab(hPixels(hVec), hSize, ptWPHLab, hChroma.data(), hHue.data());
+  hReport("Lab to LCh to Lab", hRefPolarMs, hTimer.elapsed());
+  fflush(stdout);
+}
+
+//==============================================================================
+// Output conversion on a 12 MP scene in linear ProPhoto, the unoptimised lcms transform to
+// sRGB against the lookup table baked from it. The difference is in 16 bit steps.
+void ptBench::benchColorLut() {
+  const uint16_t hWidth  = 4240;
+  const uint16_t hHeight = 2832;
+  const size_t   hSize   = (size_t)hWidth*hHeight;
+
+  std::vector<uint16_t> hRef(hSize*3);
+  for (uint16_t y = 0; y < hHeight; ++y)
+    for (uint16_t x = 0; x < hWidth; ++x)
+      for (int c = 0; c < 3; ++c)
+        hRef[((size_t)y*hWidth + x)*3 + c] =
+          (uint16_t)(sceneValue(x, y, c, hWidth, hHeight)*0xffff);
+  std::vector<uint16_t> hLut(hRef);
+
+  cmsHPROFILE hSRGB = cmsCreate_sRGBProfile();
+  const ptCmsEnd        hIn    = ptCmsEnd::workspace(ptSpace_ProPhotoRGB_D50);
+  const ptCmsEnd        hOut   = ptCmsEnd::profile(hSRGB);
+  const cmsUInt32Number hFlags = cmsFLAGS_NOOPTIMIZE | cmsFLAGS_BLACKPOINTCOMPENSATION;
+
+  QTime hTimer;
+  hTimer.start();
+  ptCmsLut hTable =
+    ptCmsTransformCache::instance()->lut(hIn, hOut, INTENT_PERCEPTUAL, hFlags);
+  const int hBakeMs = hTimer.restart();
+  ptCmsTransform hTransform =
+    ptCmsTransformCache::instance()->get(hIn, TYPE_RGB_16, hOut, TYPE_RGB_16, INTENT_PERCEPTUAL, hFlags);
+  if (!hTable || !hTransform) {
+    printf("\nptBench: cannot build the output transform.\n");
+    cmsCloseProfile(hSRGB);
+    return;
+  }
+
+  hTimer.restart();
+  cmsDoTransform(hTransform.get(), hRef.data(), hRef.data(), (cmsUInt32Number)hSize);
+  const int hRefMs = hTimer.restart();
+  hTable->apply((uint16_t (*)[3])hLut.data(), hSize);
+  const int hLutMs = hTimer.elapsed();
+
+  int    hMaxDiff = 0;
+  double hSumDiff = 0.0;
+  for (size_t i = 0; i < hRef.size(); ++i) {
+    const int hDiff = qAbs((int)hRef[i] - (int)hLut[i]);
+    hMaxDiff  = qMax(hMaxDiff, hDiff);
+    hSumDiff += hDiff;
+  }
+
+  printf("\nptBench: output transform, %.1f MP, %d^3 table baked in %d ms, %.1f %% exact cells, single thread\n",
+         hSize/1.0e6, hTable->gridSize(), hBakeMs, 100.0*hTable->exactShare());
+  printf("  %-32s %10s %10s %10s %10s %10s\n", "Step", "lcms ms", "table ms", "speedup", "max diff", "mean diff");
+  printf("  %-32s %10d %10d %10.2f %10d %10.2f\n", "ProPhoto to sRGB", hRefMs, hLutMs,
+         hLutMs > 0 ? (double)hRefMs/hLutMs : 0.0, hMaxDiff, hSumDiff/hRef.size());
+  fflush(stdout);
+
+  hTable.reset();
+  hTransform.reset();
+  ptCmsTransformCache::instance()->clear();
+  cmsCloseProfile(hSRGB);
+}
+
+//==============================================================================
+// Demosaicing on a 6 MP scene with hard colour edges and a zone plate, mosaiced into the
+// RGGB pattern of the bench DNG and into the 6x6 pattern of ptDcRaw::fcol(). Every
+// ptInterpolation_* path runs through RunDcRaw_Phase2() from the phase 1 cache, like a
+// setting change in the GUI. The default ptDcRaw settings apply, no CA correction or
+// denoise. The quality columns compare against the scene after a per channel gain taken
+// from the photosites of that channel (white balance and scaling), 8 pixels of border
+// excluded.
+void ptBench::benchDemosaic() {
+  const uint16_t hWidth  = 3008;
+  const uint16_t hHeight = 2000;
+  const int      hBorder = 8;
+  const size_t   hSize   = (size_t)hWidth*hHeight;
+  const double   hMPix   = hSize/1.0e6;
+  const QString  hFile   = QDir::tempPath() + "/ptBench_demosaic.dng";
+
+  if (!writeBayerDng(hFile, hWidth, hHeight, demosaicSceneValue)) {
+    printf("\nptBench: cannot write '%s'.\n", hFile.toLocal8Bit().data());
+    return;
+  }
+
+  // Ground truth in the raw units of the DNG.
+  std::vector<float> hTruth(hSize*3);
+#pragma omp parallel for schedule(static)
+  for (int y = 0; y < hHeight; ++y)
+    for (int x = 0; x < hWidth; ++x)
+      for (int c = 0; c < 3; ++c)
+        hTruth[((size_t)y*hWidth + x)*3 + c] = toRaw(demosaicSceneValue(x, y, c, hWidth, hHeight));
+
+  QList<int> hThreads;
+  for (int hCount = 1; hCount < ptProfiler::threadCount(); hCount *= 2) hThreads << hCount;
+  hThreads << ptProfiler::threadCount();
+  const int hMaxThreads = hThreads.last();
+
+  const double (&hToXyz)[3][3] = MatrixRGBToXYZ[ptSpace_sRGB_D65];
+  auto hToLab = [&](const float ARgb[3], float ALab[3]) {
+    float hF[3];
+    for (int c = 0; c < 3; ++c) {
+      float hValue = 0.0f;
+      for (int k = 0; k < 3; ++k) hValue += hToXyz[c][k]*ARgb[k];
+      hValue /= D65Reference[c];
+      hF[c] = hValue > 0.008856f ? cbrtf(hValue) : 7.787f*hValue + 16.0f/116.0f;
+    }
+    ALab[0] = 116.0f*hF[1] - 16.0f;
+    ALab[1] = 500.0f*(hF[0] - hF[1]);
+    ALab[2] = 200.0f*(hF[1] - hF[2]);
+  };
+
+  for (const bool hIs3x3: {false, true}) {
+    ptDcRaw* hDcRaw = new ptDcRaw;
+    if (hDcRaw->Identify(hFile) || hDcRaw->RunDcRaw_Phase1() ||
+        hDcRaw->m_Width_AfterPhase1 != hWidth || hDcRaw->m_Height_AfterPhase1 != hHeight) {
+      printf("\nptBench: cannot decode '%s'.\n", hFile.toLocal8Bit().data());
+      delete hDcRaw;
+      break;
+    }
+
+    // Colour of every photosite, the second green of RGGB is channel 1 in the result.
+    std::vector<uint8_t> hColors(hSize);
+    if (hIs3x3) hDcRaw->m_Filters = 2;
+    for (int y = 0; y < hHeight; ++y) {
+      for (int x = 0; x < hWidth; ++x) {
+        const int hColor = hDcRaw->fcol(y, x);
+        hColors[(size_t)y*hWidth + x] = hColor == 3 ? 1 : hColor;
+      }
+    }
+
+    if (hIs3x3) {
+      // Replace the photosites in the phase 1 cache by the scene in the 6x6 pattern.
+      hDcRaw->m_Filters_AfterPhase1 = 2;
+      for (int y = 0; y < hHeight; ++y) {
+        for (int x = 0; x < hWidth; ++x) {
+          const size_t   hIdx   = (size_t)y*hWidth + x;
+          const int      hColor = hColors[hIdx];
+          const uint16_t hValue = (uint16_t)hTruth[hIdx*3 + hColor];
+          if (hDcRaw->m_CfaImage_AfterPhase1) {
+            hDcRaw->m_CfaImage_AfterPhase1[hIdx] = hValue;
+          } else {
+            memset(hDcRaw->m_Image_AfterPhase1[hIdx], 0, sizeof *hDcRaw->m_Image_AfterPhase1);
+            hDcRaw->m_Image_AfterPhase1[hIdx][hColor] = hValue;
+          }
+        }
+      }
+    }
+
+    printf("\nptBench: demosaicing, %.1f MP, %s pattern\n", hMPix, hIs3x3 ? "6x6" : "RGGB");
+    printf("  %-16s", "Algorithm");
+    for (int hCount: hThreads) printf(" %10s", QString("%1 thr MP/s").arg(hCount).toLatin1().data());
+    printf(" %10s %10s %10s %10s\n", "scaling", "PSNR dB", "dE mean", "dE 99%");
+
+    for (const TDemosaicer &hDemosaicer: CDemosaicers) {
+      // 3x3 patterns are always done with VNG.
+      if (hIs3x3 && hDemosaicer.Quality != ptInterpolation_VNG) continue;
+      hDcRaw->m_UserSetting_Quality = hDemosaicer.Quality;
+
+      printf("  %-16s", hIs3x3 ? "VNG (forced)" : hDemosaicer.Name);
+      QList<double> hRates;
+      for (int hCount: hThreads) {
+#ifdef _OPENMP
+        omp_set_num_threads(hCount);
+#endif
+        QTime hTimer;
+        hTimer.start();
+        hDcRaw->RunDcRaw_Phase2(0);
+        const int hMs = hTimer.elapsed();
+        hRates << (hMs > 0 ? hMPix*1000.0/hMs : 0.0);
+        printf(" %10.2f", hRates.last());
+        fflush(stdout);
+      }
+#ifdef _OPENMP
+      omp_set_num_threads(hMaxThreads);
+#endif
+
+      // Per channel gain of the result against the truth on the photosites of the channel.
+      const uint16_t (*hImage)[4] = hDcRaw->m_Image;
+      double hResultSum[3] = {0.0, 0.0, 0.0};
+      double hTruthSum[3]  = {0.0, 0.0, 0.0};
+      for (int y = hBorder; y < hHeight - hBorder; ++y) {
+        for (int x = hBorder; x < hWidth - hBorder; ++x) {
+          const size_t hIdx   = (size_t)y*hWidth + x;
+          const int    hColor = hColors[hIdx];
+          hResultSum[hColor] += hImage[hIdx][hColor];
+          hTruthSum[hColor]  += hTruth[hIdx*3 + hColor];
+        }
+      }
+      double hGain[3];
+      for (int c = 0; c < 3; ++c)
+        hGain[c] = (hResultSum[c] > 0.0 && hTruthSum[c] > 0.0) ? hResultSum[c]/hTruthSum[c] : 1.0;
+
+      // Both sides normalised to the scene range 0..1.
+      const float hPeak = toRaw(1.0f);
+      double hSquaredError = 0.0;
+      std::vector<float> hDeltaE;
+      hDeltaE.reserve((size_t)(hWidth - 2*hBorder)*(hHeight - 2*hBorder));
+      for (int y = hBorder; y < hHeight - hBorder; ++y) {
+        for (int x = hBorder; x < hWidth - hBorder; ++x) {
+          const size_t hIdx = (size_t)y*hWidth + x;
+          float hResult[3];
+          float hScene[3];
+          for (int c = 0; c < 3; ++c) {
+            hResult[c] = hImage[hIdx][c]/hGain[c]/hPeak;
+            hScene[c]  = hTruth[hIdx*3 + c]/hPeak;
+            hSquaredError += (double)(hResult[c] - hScene[c])*(hResult[c] - hScene[c]);
+          }
+          float hResultLab[3];
+          float hSceneLab[3];
+          hToLab(hResult, hResultLab);
+          hToLab(hScene, hSceneLab);
+          hDeltaE.push_back(sqrtf((hResultLab[0] - hSceneLab[0])*(hResultLab[0] - hSceneLab[0]) +
+                                  (hResultLab[1] - hSceneLab[1])*(hResultLab[1] - hSceneLab[1]) +
+                                  (hResultLab[2] - hSceneLab[2])*(hResultLab[2] - hSceneLab[2])));
+        }
+      }
+      const double hMse  = hSquaredError/(3.0*hDeltaE.size());
+      double hSumDeltaE  = 0.0;
+      for (float hValue: hDeltaE) hSumDeltaE += hValue;
+      const size_t hP99 = hDeltaE.size()*99/100;
+      std::nth_element(hDeltaE.begin(), hDeltaE.begin() + hP99, hDeltaE.end());
+
+      printf(" %10.2f %10.2f %10.3f %10.3f\n",
+             hRates.first() > 0.0 ? hRates.last()/hRates.first() : 0.0,
+             hMse > 0.0 ? 10.0*log10(1.0/hMse) : 99.0,
+             hSumDeltaE/hDeltaE.size(), hDeltaE[hP99]);
+      fflush(stdout);
+    }
+    delete hDcRaw;
+  }
+
+  QFile::remove(hFile);
+}
+
+//==============================================================================
+// Deterministic test scene in 0..1: smooth gradients for the tone filters, some
+// periodic detail for the sharpening and denoise filters and a little noise.
+float ptBench::sceneValue(const int AX, const int AY, const int AChannel,
+                          const int AWidth, const int AHeight)
+{
+  const float hX = (float)AX/AWidth;
+  const float hY = (float)AY/AHeight;
+
+  float hValue = 0.05f + 0.6f*hX*(0.4f + 0.6f*hY)*(0.7f + 0.15f*AChannel);
+  hValue += 0.08f*sinf(AX*0.043f*(AChannel+1))*cosf(AY*0.031f);
+
+  uint32_t hHash = (uint32_t)AX*73856093u ^ (uint32_t)AY*19349663u ^ (uint32_t)AChannel*83492791u;
+  hHash ^= hHash >> 13;
+  hHash *= 0x5bd1e995u;
+  hHash ^= hHash >> 15;
+  hValue += 0.02f*((hHash & 0xffff)/65535.0f - 0.5f);
+
+  return qBound(0.0f, hValue, 1.0f);
+}
+
+//==============================================================================
+// Test scene for the demosaicers in 0..1: the smooth scene on the left, a zone plate up to
+// the Nyquist frequency top right and saturated colour blocks with hard edges bottom right.
+float ptBench::demosaicSceneValue(const int AX, const int AY, const int AChannel,
+                                  const int AWidth, const int AHeight)
+{
+  if (AX < AWidth/2) return sceneValue(AX, AY, AChannel, AWidth, AHeight);
+
+  if (AY < AHeight/2) {
+    const float hDx   = AX - AWidth*0.75f;
+    const float hDy   = AY - AHeight*0.25f;
+    const float hRMax = qMin(AWidth, AHeight)*0.25f;
+    // The local frequency k*r/pi reaches 0.5 cycles per pixel at hRMax.
+    const float hK    = (float)ptPI/(2.0f*hRMax);
+    const float hR2   = hDx*hDx + hDy*hDy;
+    return hR2 < hRMax*hRMax ? 0.5f + 0.4f*cosf(hK*hR2) : 0.5f;
+  }
+
+  static const float CBlocks[6][3] = {
+    {0.80f, 0.10f, 0.10f}, {0.10f, 0.80f, 0.10f}, {0.10f, 0.10f, 0.80f},
+    {0.80f, 0.80f, 0.10f}, {0.10f, 0.80f, 0.80f}, {0.80f, 0.10f, 0.80f} };
+  return CBlocks[(AX/24 + (AY/24)*4) % 6][AChannel];
+}
+
+//==============================================================================
+// Minimal uncompressed DNG with an RGGB pattern. The colour matrix is the one of
+// sRGB, so the camera is neutral.
+bool ptBench::writeBayerDng(const QString &AFileName, const uint16_t AWidth, const uint16_t AHeight,
+                            TSceneFunc AScene)
+{
+  TTiffWriter hTiff;
+  hTiff.longs (254, 0);                                // NewSubFileType
+  hTiff.longs (256, AWidth);
+  hTiff.longs (257, AHeight);
+  hTiff.shorts(258, {16});                             // BitsPerSample
+  hTiff.shorts(259, {1});                              // no compression
+  hTiff.shorts(262, {32803});                          // CFA
+  hTiff.ascii (271, "Photivo");
+  hTiff.ascii (272, "Bench");
+  hTiff.longs (273, 0);                                // StripOffsets, patched by header()
+  hTiff.shorts(274, {1});
+  hTiff.shorts(277, {1});                              // SamplesPerPixel
+  hTiff.longs (278, AHeight);                          // RowsPerStrip
+  hTiff.longs (279, (uint32_t)AWidth*AHeight*2);       // StripByteCounts
+  hTiff.shorts(284, {1});
+  hTiff.shorts(33421, {2, 2});                         // CFARepeatPatternDim
+  hTiff.bytes (33422, QByteArray("\0\1\1\2", 4));      // RGGB
+  hTiff.bytes (50706, QByteArray("\1\4\0\0", 4));      // DNGVersion
+  hTiff.ascii (50708, "Photivo Bench");
+  hTiff.longs (50717, CBayerWhite);                    // WhiteLevel
+  hTiff.rationals(50721, 10, { 3.2406, -1.5372, -0.4986,
+                              -0.9689,  1.8758,  0.0415,
+                               0.0557, -0.2040,  1.0570});   // ColorMatrix1
+  hTiff.rationals(50728, 5, {1.0, 1.0, 1.0});          // AsShotNeutral
+  hTiff.shorts(50778, {21});                           // D65
+
+  QFile hFile(AFileName);
+  if (!hFile.open(QIODevice::WriteOnly | QIODevice::Truncate)) return false;
+  hFile.write(hTiff.header(273));
+
+  std::vector<uint16_t> hRow(AWidth);
+  for (int hY = 0; hY < AHeight; ++hY) {
+#pragma omp parallel for schedule(static)
+    for (int hX = 0; hX < AWidth; ++hX) {
+      const int hChannel = (hY & 1) ? ((hX & 1) ? 2 : 1) : ((hX & 1) ? 1 : 0);
+      hRow[hX] = toRaw(AScene(hX, hY, hChannel, AWidth, AHeight));
+    }
+    // little endian as declared in the header
+    for (uint16_t &hValue: hRow) hValue = qToLittleEndian(hValue);
+    if (hFile.write((const char*)hRow.data(), AWidth*2) != AWidth*2) return false;
+  }
+  return true;
+}
+
+//==============================================================================
+// 16 bit binary PPM, read through GraphicsMagick like any other bitmap.
+bool ptBench::writeBitmap(const QString &AFileName, const uint16_t AWidth, const uint16_t AHeight) {
+  QFile hFile(AFileName);
+  if (!hFile.open(QIODevice::WriteOnly | QIODevice::Truncate)) return false;
+  hFile.write(QString("P6\n%1 %2\n65535\n").arg(AWidth).arg(AHeight).toLatin1());
+
+  std::vector<uint16_t> hRow((size_t)AWidth*3);
+  for (int hY = 0; hY < AHeight; ++hY) {
+#pragma omp parallel for schedule(static)
+    for (int hX = 0; hX < AWidth; ++hX) {
+      for (int c = 0; c < 3; ++c) {
+        // PPM samples are big endian
+        hRow[hX*3+c] = qToBigEndian((uint16_t)(sceneValue(hX, hY, c, AWidth, AHeight)*0xffff));
+      }
+    }
+    if (hFile.write((const char*)hRow.data(), AWidth*6) != AWidth*6) return false;
+  }
+  return true;
+}
+
+//==============================================================================
+
+void ptBench::runPreset(const QString &AInputFile, const QString &APreset, const QString &ALabel) {
+  short hNextPhase = ptProcessorPhase_Raw;
+  if (GFilterDM->ReadPresetFile(APreset, hNextPhase)) {
+    printf("ptBench: cannot read '%s'.\n", APreset.toLocal8Bit().data());
+    return;
+  }
+
+  Settings->SetValue("InputFileNameList", QStringList(AInputFile));
+
+  ptDcRaw* hDcRaw = new ptDcRaw;
+  Settings->ToDcRaw(hDcRaw);
+  uint16_t hWidth  = 0;
+  uint16_t hHeight = 0;
+  ptImageType hType = CheckImageType(AInputFile, &hWidth, &hHeight, hDcRaw);
+  if (hType <= itUndetermined) {
+    printf("ptBench: cannot decode '%s'.\n", AInputFile.toLocal8Bit().data());
+    delete hDcRaw;
+    return;
+  }
+
+  Settings->SetValue("IsRAW", hType == itRaw ? 1 : 0);
+  if (!Settings->useRAWHandling())
+    Settings->SetValue("ExposureNormalization", 0.0);
+
+  // Same setup as a job, see RunJob().
+  delete TheDcRaw;
+  delete TheProcessor;
+  TheProcessor = new ptProcessor(ReportProgress);
+  TheDcRaw     = hDcRaw;
+  TheProcessor->m_DcRaw = TheDcRaw;
+  Settings->SetValue("ImageW",hWidth);
+  Settings->SetValue("ImageH",hHeight);
+  Settings->SetValue("RunMode",0);
+  Settings->SetValue("FullOutput",1);
+
+  GProfiler->clear();
+  TheProcessor->Run(ptProcessorPhase_Raw, ptProcessorPhase_Load, 0, ptProcessorMode_Full);
+  const qint64 hTotalUs = GProfiler->elapsedUs();
+
+  Settings->SetValue("FullOutput",0);
+
+  report(ALabel, QFileInfo(APreset).fileName(), hTotalUs, (double)hWidth*hHeight/1.0e6);
+}
+
+//==============================================================================
+// One block per run: the whole pipe first, then every step in pipe order.
+void ptBench::report(const QString &ALabel, const QString &APreset,
+                     const qint64 ATotalUs, const double AMPix) const
+{
+  struct TStep {
+    qint64 WallUs;
+    qint64 MaxResident;
+  };
+  QStringList          hOrder;
+  QMap<QString, TStep> hSteps;
+  for (const ptProfiler::TEvent &hEvent: GProfiler->events()) {
+    if (!hSteps.contains(hEvent.Name)) hOrder << hEvent.Name;
+    TStep &hStep = hSteps[hEvent.Name];
+    hStep.WallUs     += hEvent.WallUs;
+    hStep.MaxResident = qMax(hStep.MaxResident, hEvent.ResidentBytes);
+  }
+
+  printf("\nptBench: %s, %s\n", ALabel.toLocal8Bit().data(), APreset.toLocal8Bit().data());
+  printf("  %-32s %10s %10s %10s\n", "Step", "ms", "MP/s", "RSS MB");
+  printf("  %-32s %10.1f %10.2f %10.0f\n", "Pipe",
+         ATotalUs/1000.0, ATotalUs > 0 ? AMPix*1.0e6/ATotalUs : 0.0,
+         ptProfiler::residentBytes()/1048576.0);
+  for (const QString &hName: hOrder) {
+    const TStep &hStep = hSteps[hName];
+    printf("  %-32s %10.1f %10.2f %10.0f\n", hName.toLocal8Bit().data(),
+           hStep.WallUs/1000.0, hStep.WallUs > 0 ? AMPix*1.0e6/hStep.WallUs : 0.0,
+           hStep.MaxResident/1048576.0);
+  }
+  fflush(stdout);
+}
+
+//==============================================================================
@@ -0,0 +1,79 @@
+/*******************************************************************************
+**
+** Photivo
+**
+** Copyright (C) 2026 agent <agent@local>
+**
+** This file is part of Photivo.
+**
+** Photivo is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License version 3
+** as published by the Free Software Foundation.
+**
+** Photivo is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with Photivo.  If not, see <http://www.gnu.org/licenses/>.
+**
+*******************************************************************************/
+
+#ifndef PTBENCH_H
+#define PTBENCH_H
+
+#include <QString>
+#include <QStringList>
+
+#include <cstdint>
+
+//==============================================================================
+
+/*! \class ptBench
+  Headless benchmark of the full size pipe, started with the \c --bench command line option.
+  It generates deterministic synthetic inputs – an uncompressed Bayer DNG and a 16 bit PPM –
+  at 12, 24 and 50 megapixels in the temp directory and runs every given preset on each of them
+  through \c ptProcessor::Run() like a job does, without writing the result.
+  For every run it prints wall time, throughput and resident memory per pipe step, taken from
+  the profiler (see \c ptProfiler). Combine with \c --profile to keep the raw measurements.
+  Before the pipe runs it compares the RGB <-> Lab kernels against the former implementation
+  and the lookup table output transform against lcms, and times every demosaicing algorithm
+  of \c ptDcRaw at 1, 2, 4 … threads with its PSNR and Delta E against a known scene.
+  */
+class ptBench {
+public:
+  ptBench();
+
+  /*! Runs the benchmark. \c APresets is a settings file or a directory of settings files.
+      Returns the process exit code. */
+  int run(const QString &APresets);
+
+private:
+  enum TInputKind { ikBayer, ikBitmap };
+  typedef float (*TSceneFunc)(const int AX, const int AY, const int AChannel,
+                              const int AWidth, const int AHeight);
+
+  static QStringList  collectPresets(const QString &APresets);
+  static void         benchLabKernels();
+  static void         benchColorLut();
+  static void         benchDemosaic();
+  static float        sceneValue(const int AX, const int AY, const int AChannel,
+                                 const int AWidth, const int AHeight);
+  static float        demosaicSceneValue(const int AX, const int AY, const int AChannel,
+                                         const int AWidth, const int AHeight);
+  static bool         writeBayerDng(const QString &AFileName,
+                                    const uint16_t AWidth, const uint16_t AHeight,
+                                    TSceneFunc AScene = sceneValue);
+  static bool         writeBitmap(const QString &AFileName,
+                                  const uint16_t AWidth, const uint16_t AHeight);
+
+  void                runPreset(const QString &AInputFile, const QString &APreset,
+                                const QString &ALabel);
+  void                report(const QString &ALabel, const QString &APreset,
+                             const qint64 ATotalUs, const double AMPix) const;
+};
+
+//==============================================================================
+
+#endif // PTBENCH_H
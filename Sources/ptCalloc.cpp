@@ -90,6 +90,60 @@ void* ptCalloc_Ex(size_t num,
 
 //==============================================================================
 
+void* ptRealloc(void*  Ptr,
+                size_t size,
+                const char*  FileName,
+                const int    LineNumber,
+                const void*  ObjectPointer) {
+
+  if (!CallocDebugFile) {
+    CallocDebugFile = fopen("CallocDebug.txt","w");
+    assert(CallocDebugFile);
+  }
+
+  Allocation* TheAllocation = NULL;
+  for (int i=0; i<Allocations.size(); i++) {
+    if (Allocations.at(i)->Pointer == Ptr) {
+      TheAllocation = Allocations.at(i);
+      break;
+    }
+  }
+  assert(TheAllocation);
+
+  void* RV = realloc(Ptr,size);
+
+  Allocated += (int) size - TheAllocation->Size;
+  TheAllocation->Pointer       = RV;
+  TheAllocation->Size          = size;
+  TheAllocation->FileName      = FileName;
+  TheAllocation->LineNumber    = LineNumber;
+  TheAllocation->ObjectPointer = ObjectPointer;
+
+  fprintf(CallocDebugFile,
+          "Realloc : %p -> %p\n  %10s : %d\n  %10s : %s\n  %10s : %d\n  %10s : %p\n\n",
+          Ptr,
+          RV,
+          "Nr Bytes",(int) size,
+          "Filename",FileName,
+          "LineNumber",LineNumber,
+          "Object",ObjectPointer);
+  fprintf(CallocDebugFile,"Total allocated : %d\n",Allocated);
+  return RV;
+}
+
+//==============================================================================
+
+void* ptRealloc_Ex(void*  Ptr,
+                   size_t size) {
+  void* RV = realloc(Ptr,size);
+  if (RV == 0) {
+    throw std::bad_alloc();
+  }
+  return RV;
+}
+
+//==============================================================================
+
 void  ptFree(void* Ptr,
              const char* FileName,
              const int   LineNumber,
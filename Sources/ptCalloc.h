@@ -40,6 +40,19 @@ void* ptCalloc_Ex(size_t num,
 
 //==============================================================================
 
+void* ptRealloc(void*  Ptr,
+                size_t size,
+                const char*  FileName,
+                const int    LineNumber,
+                const void*  ObjectPointer);
+
+//==============================================================================
+
+void* ptRealloc_Ex(void*  Ptr,
+                   size_t size);
+
+//==============================================================================
+
 void  ptFree(void* Ptr,
              const char* FileName,
              const int   LineNumber,
@@ -0,0 +1,226 @@
+/*******************************************************************************
+**
+** Photivo
+**
+** Copyright (C) 2026 agent <agent@local>
+**
+** This file is part of Photivo.
+**
+** Photivo is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License version 3
+** as published by the Free Software Foundation.
+**
+** Photivo is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with Photivo.  If not, see <http://www.gnu.org/licenses/>.
+**
+*******************************************************************************/
+
+#include "ptCmsTransformCache.h"
+#include "ptConstants.h"
+#include "ptError.h"
+
+#include <QMutexLocker>
+
+#include <cassert>
+#include <cstring>
+
+extern cmsCIExyY D65;
+extern cmsCIExyY D50;
+
+//==============================================================================
+
+ptCmsEnd::ptCmsEnd(const QByteArray &AKey, const short ASpace, cmsHPROFILE AProfile):
+  FKey(AKey),
+  FSpace(ASpace),
+  FProfile(AProfile)
+{}
+
+//------------------------------------------------------------------------------
+
+ptCmsEnd ptCmsEnd::workspace(const short AColorSpace) {
+  return ptCmsEnd("ws:" + QByteArray::number(AColorSpace), AColorSpace, nullptr);
+}
+
+//------------------------------------------------------------------------------
+
+ptCmsEnd ptCmsEnd::lab() {
+  return ptCmsEnd("lab4", ptSpace_Lab, nullptr);
+}
+
+//------------------------------------------------------------------------------
+
+ptCmsEnd ptCmsEnd::xyz() {
+  return ptCmsEnd("xyz", ptSpace_XYZ, nullptr);
+}
+
+//------------------------------------------------------------------------------
+/*! The profile ID from the header is used when the profile has one, otherwise it is
+    computed (and stored in the in-memory header) once. */
+ptCmsEnd ptCmsEnd::profile(cmsHPROFILE AProfile) {
+  assert(AProfile);
+  cmsUInt8Number hId[16];
+  cmsGetHeaderProfileID(AProfile, hId);
+  static const cmsUInt8Number CNoId[16] = {0};
+  if (memcmp(hId, CNoId, sizeof(hId)) == 0) {
+    cmsMD5computeID(AProfile);
+    cmsGetHeaderProfileID(AProfile, hId);
+  }
+  return ptCmsEnd("icc:" + QByteArray((const char*)hId, sizeof(hId)).toHex(),
+                  ptSpace_Profiled, AProfile);
+}
+
+//------------------------------------------------------------------------------
+
+cmsHPROFILE ptCmsEnd::open(bool &AOwned) const {
+  AOwned = true;
+  switch (FSpace) {
+    case ptSpace_Lab:      return cmsCreateLab4Profile(NULL);
+    case ptSpace_XYZ:      return cmsCreateXYZProfile();
+    case ptSpace_Profiled: AOwned = false; return FProfile;
+    default: break;
+  }
+
+  cmsCIExyY hWhite;
+  switch (FSpace) {
+    case ptSpace_sRGB_D65 :
+    case ptSpace_AdobeRGB_D65 :
+      hWhite = D65;
+      break;
+    case ptSpace_WideGamutRGB_D50 :
+    case ptSpace_ProPhotoRGB_D50 :
+      hWhite = D50;
+      break;
+    default:
+      assert(0);
+      return nullptr;
+  }
+
+  cmsToneCurve* hGamma = cmsBuildGamma(NULL, 1.0);
+  cmsToneCurve* hGamma3[3] = {hGamma, hGamma, hGamma};
+  cmsHPROFILE hProfile = cmsCreateRGBProfile(&hWhite,
+                                             (cmsCIExyYTRIPLE*)&RGBPrimaries[FSpace],
+                                             hGamma3);
+  cmsFreeToneCurve(hGamma);
+  return hProfile;
+}
+
+//==============================================================================
+
+ptCmsTransformCache::ptCmsTransformCache():
+  FHits(0),
+  FMisses(0)
+{}
+
+//------------------------------------------------------------------------------
+
+ptCmsTransformCache *ptCmsTransformCache::instance() {
+  static ptCmsTransformCache hInstance;
+  return &hInstance;
+}
+
+//------------------------------------------------------------------------------
+
+ptCmsTransform ptCmsTransformCache::get(const ptCmsEnd         &AIn,
+                                        const cmsUInt32Number   AInFormat,
+                                        const ptCmsEnd         &AOut,
+                                        const cmsUInt32Number   AOutFormat,
+                                        const int               AIntent,
+                                        const cmsUInt32Number   AFlags)
+{
+  const QByteArray hKey = AIn.key() + '>' + AOut.key() + '|' +
+                          QByteArray::number(AInFormat) + ',' +
+                          QByteArray::number(AOutFormat) + ',' +
+                          QByteArray::number(AIntent) + ',' +
+                          QByteArray::number(AFlags);
+
+  // Building under the lock keeps two threads from building the same transform.
+  QMutexLocker hLock(&FMutex);
+
+  auto hIt = FTransforms.constFind(hKey);
+  if (hIt != FTransforms.constEnd()) {
+    ++FHits;
+    FLru.removeOne(hKey);
+    FLru.append(hKey);
+    return hIt.value();
+  }
+  ++FMisses;
+
+  bool hInOwned  = false;
+  bool hOutOwned = false;
+  cmsHPROFILE hIn  = AIn.open(hInOwned);
+  cmsHPROFILE hOut = AOut.open(hOutOwned);
+
+  cmsHTRANSFORM hTransform = nullptr;
+  if (!hIn || !hOut) {
+    ptLogError(ptError_Profile,"Could not open profile for colour transform.");
+  } else {
+    hTransform = cmsCreateTransform(hIn, AInFormat, hOut, AOutFormat, AIntent, AFlags);
+  }
+  // A transform does not need its profiles once it is built.
+  if (hIn  && hInOwned)  cmsCloseProfile(hIn);
+  if (hOut && hOutOwned) cmsCloseProfile(hOut);
+
+  if (!hTransform) return ptCmsTransform();
+
+  ptCmsTransform hResult(hTransform, cmsDeleteTransform);
+  FTransforms.insert(hKey, hResult);
+  FLru.append(hKey);
+  while (FLru.size() > CMaxTransforms)
+    FTransforms.remove(FLru.takeFirst());
+
+  return hResult;
+}
+
+//------------------------------------------------------------------------------
+
+ptCmsLut ptCmsTransformCache::lut(const ptCmsEnd         &AIn,
+                                  const ptCmsEnd         &AOut,
+                                  const int               AIntent,
+                                  const cmsUInt32Number   AFlags)
+{
+  const QByteArray hKey = AIn.key() + '>' + AOut.key() + '|' +
+                          QByteArray::number(AIntent) + ',' +
+                          QByteArray::number(AFlags);
+
+  QMutexLocker hLock(&FLutMutex);
+
+  auto hIt = FLuts.constFind(hKey);
+  if (hIt != FLuts.constEnd()) {
+    FLutLru.removeOne(hKey);
+    FLutLru.append(hKey);
+    return hIt.value();
+  }
+
+  ptCmsTransform hTransform = get(AIn, TYPE_RGB_16, AOut, TYPE_RGB_16, AIntent, AFlags);
+  if (!hTransform) return ptCmsLut();
+
+  // The sampler holds on to the transform, the table needs it for its exact cells.
+  ptCmsLut hResult = std::make_shared<ptColorLut>(
+    [hTransform](const uint16_t (*ASrc)[3], uint16_t (*ADst)[3], size_t ACount) {
+      cmsDoTransform(hTransform.get(), ASrc, ADst, (cmsUInt32Number)ACount);
+    });
+  FLuts.insert(hKey, hResult);
+  FLutLru.append(hKey);
+  while (FLutLru.size() > CMaxLuts)
+    FLuts.remove(FLutLru.takeFirst());
+
+  return hResult;
+}
+
+//------------------------------------------------------------------------------
+
+void ptCmsTransformCache::clear() {
+  {
+    QMutexLocker hLock(&FLutMutex);
+    FLuts.clear();
+    FLutLru.clear();
+  }
+  QMutexLocker hLock(&FMutex);
+  FTransforms.clear();
+  FLru.clear();
+}
@@ -0,0 +1,124 @@
+/*******************************************************************************
+**
+** Photivo
+**
+** Copyright (C) 2026 agent <agent@local>
+**
+** This file is part of Photivo.
+**
+** Photivo is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License version 3
+** as published by the Free Software Foundation.
+**
+** Photivo is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with Photivo.  If not, see <http://www.gnu.org/licenses/>.
+**
+*******************************************************************************/
+
+#ifndef PTCMSTRANSFORMCACHE_H
+#define PTCMSTRANSFORMCACHE_H
+
+#include <QByteArray>
+#include <QHash>
+#include <QList>
+#include <QMutex>
+
+#include <lcms2.h>
+
+#include "ptColorLut.h"
+
+#include <memory>
+
+//==============================================================================
+
+/*! A shared lcms transform. It stays valid as long as a reference is held, even when the cache
+    drops it in the meantime. */
+typedef std::shared_ptr<void> ptCmsTransform;
+
+/*! A shared RGB -> RGB transform baked into a 3D lookup table, see ptColorLut. */
+typedef std::shared_ptr<const ptColorLut> ptCmsLut;
+
+//==============================================================================
+
+/*! One end of a transform, identified by a key so that a cached transform can be found
+    without building its profiles. Built-in profiles are only created on a cache miss.
+ */
+class ptCmsEnd {
+public:
+  static ptCmsEnd workspace(const short AColorSpace); //!< linear RGB working space, ptSpace_*
+  static ptCmsEnd lab();                              //!< lcms Lab v4
+  static ptCmsEnd xyz();
+  static ptCmsEnd profile(cmsHPROFILE AProfile);      //!< keyed by the profile’s MD5
+
+  const QByteArray &key() const { return FKey; }
+
+  /*! Returns a new profile for built-in ends and the external profile otherwise.
+      \c AOwned tells if the caller has to close it. */
+  cmsHPROFILE open(bool &AOwned) const;
+
+private:
+  ptCmsEnd(const QByteArray &AKey, const short ASpace, cmsHPROFILE AProfile);
+
+  QByteArray    FKey;
+  short         FSpace;
+  cmsHPROFILE   FProfile;
+};
+
+//==============================================================================
+
+/*! ptCmsTransformCache is the process-wide cache of lcms transforms. Building a precalculated
+    transform takes tens of milliseconds, so every transform is built once per combination of
+    profiles, intent, flags and pixel formats and then reused by preview and batch runs.
+    All functions are thread-safe. \c cmsDoTransform() may run on one transform from several
+    threads at a time.
+ */
+class ptCmsTransformCache {
+public:
+  static ptCmsTransformCache *instance();
+
+  /*! Returns the transform from \c AIn to \c AOut, building it on first use.
+      Returns an empty pointer when lcms could not build it. */
+  ptCmsTransform get(const ptCmsEnd         &AIn,
+                     const cmsUInt32Number   AInFormat,
+                     const ptCmsEnd         &AOut,
+                     const cmsUInt32Number   AOutFormat,
+                     const int               AIntent,
+                     const cmsUInt32Number   AFlags);
+
+  /*! Returns the RGB -> RGB transform from \c AIn to \c AOut baked into a lookup table,
+      building it on first use. The table samples the 16 bit lcms transform with \c AFlags,
+      which also converts the pixels the table leaves to the exact transform.
+      Returns an empty pointer when lcms could not build the transform. */
+  ptCmsLut lut(const ptCmsEnd         &AIn,
+               const ptCmsEnd         &AOut,
+               const int               AIntent,
+               const cmsUInt32Number   AFlags);
+
+  /*! Drops all transforms and tables not referenced elsewhere. */
+  void clear();
+
+  int  hits()   const { return FHits; }
+  int  misses() const { return FMisses; }
+
+private:
+  ptCmsTransformCache();
+
+  static const int CMaxTransforms = 32;
+  static const int CMaxLuts       = 8;    // about 4.5 MB each
+
+  QMutex                              FMutex;
+  QHash<QByteArray, ptCmsTransform>   FTransforms;
+  QList<QByteArray>                   FLru;         // least recently used first
+  QMutex                              FLutMutex;    // held while a table is baked, not FMutex
+  QHash<QByteArray, ptCmsLut>         FLuts;
+  QList<QByteArray>                   FLutLru;
+  int                                 FHits;
+  int                                 FMisses;
+};
+
+#endif // PTCMSTRANSFORMCACHE_H
@@ -0,0 +1,241 @@
+/*******************************************************************************
+**
+** Photivo
+**
+** Copyright (C) 2026 agent <agent@local>
+**
+** This file is part of Photivo.
+**
+** Photivo is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License version 3
+** as published by the Free Software Foundation.
+**
+** Photivo is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with Photivo.  If not, see <http://www.gnu.org/licenses/>.
+**
+*******************************************************************************/
+
+#include "ptColorLut.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+//==============================================================================
+
+namespace {
+
+// Node spacing: the input value of node i is (i/(N-1))^CShaperGamma of full scale.
+const double CShaperGamma = 2.4;
+
+// Largest error in 16 bit steps a cell may show at its centre before it is done exactly.
+const float CCellTolerance = 16.0f;
+
+#pragma GCC diagnostic ignored "-Wpsabi"
+typedef float TFloat4 __attribute__((vector_size(16)));
+
+inline TFloat4 loadNode(const float *ANode) {
+  TFloat4 hResult;
+  __builtin_memcpy(&hResult, ANode, sizeof(hResult));
+  return hResult;
+}
+
+//==============================================================================
+
+// Tetrahedral interpolation in the cell whose lowest node is \c ABase.
+inline TFloat4 interpolate(const float *ABase, const int AGridSize,
+                           const float ADr, const float ADg, const float ADb)
+{
+  // Node strides in floats.
+  const size_t  hStrideB = 4;
+  const size_t  hStrideG = hStrideB*AGridSize;
+  const size_t  hStrideR = hStrideG*AGridSize;
+  const TFloat4 hC000 = loadNode(ABase);
+  const TFloat4 hC111 = loadNode(ABase + hStrideR + hStrideG + hStrideB);
+
+  // One of the six tetrahedra of the cell, each spanned by the cell diagonal.
+  TFloat4 hOut;
+  if (ADr >= ADg) {
+    if (ADg >= ADb) {
+      const TFloat4 hC100 = loadNode(ABase + hStrideR);
+      const TFloat4 hC110 = loadNode(ABase + hStrideR + hStrideG);
+      hOut = hC000 + ADr*(hC100 - hC000) + ADg*(hC110 - hC100) + ADb*(hC111 - hC110);
+    } else if (ADr >= ADb) {
+      const TFloat4 hC100 = loadNode(ABase + hStrideR);
+      const TFloat4 hC101 = loadNode(ABase + hStrideR + hStrideB);
+      hOut = hC000 + ADr*(hC100 - hC000) + ADb*(hC101 - hC100) + ADg*(hC111 - hC101);
+    } else {
+      const TFloat4 hC001 = loadNode(ABase + hStrideB);
+      const TFloat4 hC101 = loadNode(ABase + hStrideR + hStrideB);
+      hOut = hC000 + ADb*(hC001 - hC000) + ADr*(hC101 - hC001) + ADg*(hC111 - hC101);
+    }
+  } else {
+    if (ADb >= ADg) {
+      const TFloat4 hC001 = loadNode(ABase + hStrideB);
+      const TFloat4 hC011 = loadNode(ABase + hStrideG + hStrideB);
+      hOut = hC000 + ADb*(hC001 - hC000) + ADg*(hC011 - hC001) + ADr*(hC111 - hC011);
+    } else if (ADb >= ADr) {
+      const TFloat4 hC010 = loadNode(ABase + hStrideG);
+      const TFloat4 hC011 = loadNode(ABase + hStrideG + hStrideB);
+      hOut = hC000 + ADg*(hC010 - hC000) + ADb*(hC011 - hC010) + ADr*(hC111 - hC011);
+    } else {
+      const TFloat4 hC010 = loadNode(ABase + hStrideG);
+      const TFloat4 hC110 = loadNode(ABase + hStrideR + hStrideG);
+      hOut = hC000 + ADg*(hC010 - hC000) + ADr*(hC110 - hC010) + ADb*(hC111 - hC110);
+    }
+  }
+  return hOut;
+}
+
+}
+
+//==============================================================================
+
+ptColorLut::ptColorLut(const TSampler &ASampler, const int AGridSize):
+  FSampler(ASampler),
+  FGridSize(AGridSize)
+{
+  assert(AGridSize >= 2 && AGridSize <= 256);
+  const int hLast = AGridSize - 1;
+
+  // Node positions in 16 bit input values, strictly increasing.
+  std::vector<int32_t> hPositions(AGridSize);
+  for (int i = 0; i < AGridSize; ++i)
+    hPositions[i] = (int32_t)lround(0xffff*pow((double)i/hLast, CShaperGamma));
+  for (int i = 1; i < AGridSize; ++i)
+    hPositions[i] = std::max(hPositions[i], hPositions[i-1] + 1);
+  assert(hPositions[hLast] == 0xffff);
+
+  // Linear between the nodes, so the shaper hits the nodes exactly.
+  FShaper.resize(0x10000);
+  for (int i = 0; i < hLast; ++i) {
+    const int32_t hFrom = hPositions[i];
+    const int32_t hTo   = hPositions[i+1];
+    for (int32_t v = hFrom; v < hTo; ++v)
+      FShaper[v] = i + (float)(v - hFrom)/(hTo - hFrom);
+  }
+  FShaper[0xffff] = (float)hLast;
+
+  // All nodes through the transform in one go.
+  const size_t hCount = (size_t)AGridSize*AGridSize*AGridSize;
+  std::vector<uint16_t> hGrid(hCount*3);
+  size_t hIdx = 0;
+  for (int r = 0; r < AGridSize; ++r)
+    for (int g = 0; g < AGridSize; ++g)
+      for (int b = 0; b < AGridSize; ++b) {
+        hGrid[hIdx++] = (uint16_t)hPositions[r];
+        hGrid[hIdx++] = (uint16_t)hPositions[g];
+        hGrid[hIdx++] = (uint16_t)hPositions[b];
+      }
+  ASampler((const uint16_t (*)[3])hGrid.data(), (uint16_t (*)[3])hGrid.data(), hCount);
+
+  FNodes.resize(hCount*4);
+  for (size_t i = 0; i < hCount; ++i) {
+    for (int c = 0; c < 3; ++c)
+      FNodes[i*4 + c] = hGrid[i*3 + c];
+    FNodes[i*4 + 3] = 0.0f;
+  }
+
+  // Cells are indexed like their lowest node, the ones on the upper borders stay unused.
+  // A cell is done exactly when clipped and unclipped nodes meet in it, or when the
+  // interpolation misses the transform at the cell centre: a kink the nodes do not see.
+  FExact.assign(hCount, false);
+  std::vector<int32_t> hCentres(hLast);
+  for (int i = 0; i < hLast; ++i)
+    hCentres[i] = (hPositions[i] + hPositions[i+1])/2;
+  std::vector<uint16_t> hProbes(hCount*3);
+  for (int r = 0; r < hLast; ++r)
+    for (int g = 0; g < hLast; ++g)
+      for (int b = 0; b < hLast; ++b) {
+        const size_t hCell = ((size_t)r*AGridSize + g)*AGridSize + b;
+        hProbes[hCell*3]     = (uint16_t)hCentres[r];
+        hProbes[hCell*3 + 1] = (uint16_t)hCentres[g];
+        hProbes[hCell*3 + 2] = (uint16_t)hCentres[b];
+      }
+  ASampler((const uint16_t (*)[3])hProbes.data(), (uint16_t (*)[3])hProbes.data(), hCount);
+
+  const size_t hOffsets[8] = {
+    0, 1, (size_t)AGridSize, (size_t)AGridSize + 1,
+    (size_t)AGridSize*AGridSize, (size_t)AGridSize*AGridSize + 1,
+    (size_t)AGridSize*AGridSize + AGridSize, (size_t)AGridSize*AGridSize + AGridSize + 1
+  };
+  for (int r = 0; r < hLast; ++r)
+    for (int g = 0; g < hLast; ++g)
+      for (int b = 0; b < hLast; ++b) {
+        const size_t  hCell = ((size_t)r*AGridSize + g)*AGridSize + b;
+        const TFloat4 hGuess =
+          interpolate(FNodes.data() + hCell*4, AGridSize,
+                      FShaper[hCentres[r]] - r, FShaper[hCentres[g]] - g, FShaper[hCentres[b]] - b);
+        bool hExact = false;
+        for (int c = 0; c < 3 && !hExact; ++c) {
+          int hClipCount = 0;
+          for (int k = 0; k < 8; ++k) {
+            const uint16_t hValue = hGrid[(hCell + hOffsets[k])*3 + c];
+            hClipCount += (hValue == 0 || hValue == 0xffff);
+          }
+          hExact = (hClipCount > 0 && hClipCount < 8) ||
+                   std::fabs(hGuess[c] - hProbes[hCell*3 + c]) > CCellTolerance;
+        }
+        FExact[hCell] = hExact;
+      }
+}
+
+//==============================================================================
+
+void ptColorLut::apply(uint16_t (*APixels)[3], const size_t ACount) const {
+  const int     hLast   = FGridSize - 1;
+  const float  *hShaper = FShaper.data();
+  const float  *hNodes  = FNodes.data();
+  std::vector<size_t>   hExactIdx;
+  std::vector<uint16_t> hExact;
+
+  for (size_t i = 0; i < ACount; ++i) {
+    const float hR = hShaper[APixels[i][0]];
+    const float hG = hShaper[APixels[i][1]];
+    const float hB = hShaper[APixels[i][2]];
+    // The last cell also takes the upper grid border.
+    const int   hCellR = std::min((int)hR, hLast - 1);
+    const int   hCellG = std::min((int)hG, hLast - 1);
+    const int   hCellB = std::min((int)hB, hLast - 1);
+    const float hDr = hR - hCellR;
+    const float hDg = hG - hCellG;
+    const float hDb = hB - hCellB;
+
+    const size_t  hCell = ((size_t)hCellR*FGridSize + hCellG)*FGridSize + hCellB;
+    if (FExact[hCell]) {
+      hExactIdx.push_back(i);
+      hExact.insert(hExact.end(), APixels[i], APixels[i] + 3);
+      continue;
+    }
+
+    const TFloat4 hOut = interpolate(hNodes + hCell*4, FGridSize, hDr, hDg, hDb);
+
+    // Nodes are in range, so is every convex combination of them.
+    APixels[i][0] = (uint16_t)(hOut[0] + 0.5f);
+    APixels[i][1] = (uint16_t)(hOut[1] + 0.5f);
+    APixels[i][2] = (uint16_t)(hOut[2] + 0.5f);
+  }
+
+  if (hExactIdx.empty()) return;
+  FSampler((const uint16_t (*)[3])hExact.data(), (uint16_t (*)[3])hExact.data(), hExactIdx.size());
+  for (size_t k = 0; k < hExactIdx.size(); ++k)
+    std::copy(&hExact[k*3], &hExact[k*3] + 3, APixels[hExactIdx[k]]);
+}
+
+//==============================================================================
+
+double ptColorLut::exactShare() const {
+  const int hCells = (FGridSize - 1)*(FGridSize - 1)*(FGridSize - 1);
+  return (double)std::count(FExact.begin(), FExact.end(), true)/hCells;
+}
+
+//==============================================================================
+
+size_t ptColorLut::byteSize() const {
+  return (FShaper.size() + FNodes.size())*sizeof(float);
+}
@@ -0,0 +1,72 @@
+/*******************************************************************************
+**
+** Photivo
+**
+** Copyright (C) 2026 agent <agent@local>
+**
+** This file is part of Photivo.
+**
+** Photivo is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License version 3
+** as published by the Free Software Foundation.
+**
+** Photivo is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with Photivo.  If not, see <http://www.gnu.org/licenses/>.
+**
+*******************************************************************************/
+
+#ifndef PTCOLORLUT_H
+#define PTCOLORLUT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+//==============================================================================
+
+/*! ptColorLut is an RGB -> RGB colour transform baked into a 3D lookup table, applied with
+    tetrahedral interpolation. The working spaces are linear, so each input channel first
+    goes through a gamma shaped 1D table: the grid nodes then sit densely in the shadows,
+    where the output profiles' tone curves are steep.
+    Output clipping at the gamut border is a kink no interpolation follows, so pixels in grid
+    cells where clipped and unclipped nodes meet go through the exact transform instead.
+    Baking costs one transform of the grid nodes; after that a conversion is a memory bound
+    pass, independent of how expensive the profiles are. \c apply() is thread-safe when the
+    sampler is.
+ */
+class ptColorLut {
+public:
+  /*! Transforms \c ACount interleaved 16 bit pixels from \c AIn to \c AOut. */
+  typedef std::function<void(const uint16_t (*AIn)[3], uint16_t (*AOut)[3], size_t ACount)> TSampler;
+
+  /*! With 65 nodes per axis the mean error against lcms is a few 16 bit steps, see ptBench. */
+  static const int CDefaultGridSize = 65;
+
+  ptColorLut(const TSampler &ASampler, const int AGridSize = CDefaultGridSize);
+
+  /*! Converts \c ACount interleaved 16 bit pixels in place. */
+  void apply(uint16_t (*APixels)[3], const size_t ACount) const;
+
+  int gridSize() const { return FGridSize; }
+
+  /*! Share of the grid cells that fall back to the exact transform. */
+  double exactShare() const;
+
+  /*! Memory the table occupies, in bytes. */
+  size_t byteSize() const;
+
+private:
+  TSampler            FSampler;
+  int                 FGridSize;
+  std::vector<float>  FShaper;   // 16 bit input -> grid coordinate, 0..FGridSize-1
+  std::vector<float>  FNodes;    // FGridSize^3 nodes, red slowest, four floats each
+  std::vector<bool>   FExact;    // per cell, same order as the nodes
+};
+
+#endif // PTCOLORLUT_H
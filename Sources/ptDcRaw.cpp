@@ -34,9 +34,17 @@
 #include "ptError.h"
 #include "ptConstants.h"
 #include "ptCalloc.h"
+#include "ptRawIndex.h"
+
+#include <QDataStream>
 
 #include <cassert>
 
+#ifndef WIN32
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
 #define NO_JASPER
 #ifndef NO_JASPER
 #include <jasper/jasper.h>
@@ -55,7 +63,8 @@ assert(RV == (size_t) n);              \
 }
 #define ptfscanf(file,format,arg)      \
 {                                      \
-int RV = fscanf(file,format,arg);      \
+int RV = fscanf(InStdio(file),format,arg); \
+InStdioDone(file);                     \
 assert (RV == 1);                      \
 }
 #define ptfgets(str,num,file)   \
@@ -71,6 +80,132 @@ inline void VAppend(TImage8RawData &AVector, char* AArray, const int ALength) {
 
 // The class.
 #define CLASS ptDcRaw::
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// Memory mapped input
+//
+// Identify() maps the raw file. The stdio calls below on the mapped stream
+// then work on the mapping: a byte read is an array access, a seek sets an
+// index. Other streams (thumbnails, temporary files) go through stdio.
+// fscanf() and libjpeg need the real stream, InStdio() positions it.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void CLASS MapInput() {
+  UnmapInput();
+#ifndef WIN32
+  struct stat Stat;
+  int Fd = fileno(m_InputFile);
+  if (fstat(Fd, &Stat) || Stat.st_size <= 0) return;
+  void* Map = mmap(NULL, Stat.st_size, PROT_READ, MAP_PRIVATE, Fd, 0);
+  if (Map == MAP_FAILED) return;
+  // Decoders mostly run front to back through the file.
+  madvise(Map, Stat.st_size, MADV_SEQUENTIAL);
+  m_InputMap     = (const uint8_t*) Map;
+  m_InputMapSize = Stat.st_size;
+  m_InputMapPos  = (ftell)(m_InputFile);
+  m_InputMapEof  = 0;
+  m_MappedFile   = m_InputFile;
+#endif
+}
+
+void CLASS UnmapInput() {
+#ifndef WIN32
+  if (m_InputMap) munmap((void*) m_InputMap, m_InputMapSize);
+#endif
+  m_MappedFile   = NULL;
+  m_InputMap     = NULL;
+  m_InputMapSize = m_InputMapPos = 0;
+  m_InputMapEof  = 0;
+}
+
+inline int CLASS InGetc(FILE* f) {
+  if (f != m_MappedFile) return (fgetc)(f);
+  if (m_InputMapPos < m_InputMapSize) return m_InputMap[m_InputMapPos++];
+  m_InputMapEof = 1;
+  return EOF;
+}
+
+size_t CLASS InRead(void* ptr, size_t size, size_t n, FILE* f) {
+  if (f != m_MappedFile) return (fread)(ptr, size, n, f);
+  if (size == 0 || n == 0) return 0;
+  INT64 Left = m_InputMapSize - m_InputMapPos;
+  if (Left < 0) Left = 0;
+  size_t Bytes = size*n;
+  if ((INT64) Bytes > Left) {
+    // Like stdio the partial item is copied too.
+    Bytes = Left;
+    m_InputMapEof = 1;
+  }
+  memcpy(ptr, m_InputMap + m_InputMapPos, Bytes);
+  m_InputMapPos += Bytes;
+  return Bytes/size;
+}
+
+int CLASS InSeek(FILE* f, long offset, int whence) {
+  if (f != m_MappedFile) return (fseek)(f, offset, whence);
+  INT64 Pos = offset;
+  if (whence == SEEK_CUR) Pos += m_InputMapPos;
+  if (whence == SEEK_END) Pos += m_InputMapSize;
+  if (Pos < 0) {
+    errno = EINVAL;
+    return -1;
+  }
+  m_InputMapPos = Pos;
+  m_InputMapEof = 0;
+  return 0;
+}
+
+long CLASS InTell(FILE* f) {
+  if (f != m_MappedFile) return (ftell)(f);
+  return (long) m_InputMapPos;
+}
+
+int CLASS InEof(FILE* f) {
+  if (f != m_MappedFile) return (feof)(f);
+  return m_InputMapEof;
+}
+
+char* CLASS InGets(char* str, int num, FILE* f) {
+  if (f != m_MappedFile) return (fgets)(str, num, f);
+  int i = 0;
+  while (i < num-1) {
+    int c = InGetc(f);
+    if (c == EOF) break;
+    str[i++] = c;
+    if (c == '\n') break;
+  }
+  if (i == 0 || num <= 0) return NULL;
+  str[i] = 0;
+  return str;
+}
+
+// The real stream at the position of the mapping, for code that needs a FILE.
+FILE* CLASS InStdio(FILE* f) {
+  if (f == m_MappedFile) (fseek)(f, m_InputMapPos, SEEK_SET);
+  return f;
+}
+
+void CLASS InStdioDone(FILE* f) {
+  if (f == m_MappedFile) m_InputMapPos = (ftell)(f);
+}
+
+// From here on the stdio calls go through the mapping.
+#undef fgetc
+#undef getc
+#undef fread
+#undef fseek
+#undef ftell
+#undef feof
+#undef fgets
+#define fgetc(f)          InGetc(f)
+#define getc(f)           InGetc(f)
+#define fread(p,s,n,f)    InRead(p,s,n,f)
+#define fseek(f,o,w)      InSeek(f,o,w)
+#define ftell(f)          InTell(f)
+#define feof(f)           InEof(f)
+#define fgets(s,n,f)      InGets(s,n,f)
 CLASS ptDcRaw() {
   //printf("(%s,%d) '%s'\n",__FILE__,__LINE__,__PRETTY_FUNCTION__);
 
@@ -122,6 +257,8 @@ CLASS ptDcRaw() {
   // Safety settings to have NULL on uninitialized images.
   m_Image = NULL;
   m_Image_AfterPhase1 = NULL;
+  m_CfaImage = NULL;
+  m_CfaImage_AfterPhase1 = NULL;
   m_Image_AfterPhase2 = NULL;
   m_Image_AfterPhase3 = NULL;
   m_Image_AfterPhase4 = NULL;
@@ -129,6 +266,8 @@ CLASS ptDcRaw() {
   // Some other pointers that are in a dynamic environment better NULL.
   m_MetaData    = NULL;
   m_InputFile   = NULL;
+  m_MappedFile  = NULL;
+  m_InputMap    = NULL;
 
   m_Thumb.clear();
   ResetNonUserSettings();
@@ -150,8 +289,11 @@ CLASS ~ptDcRaw() {
   FREE(m_UserSetting_DarkFrameFileName);
   FREE(m_Image);
   FREE(m_Image_AfterPhase1);
+  FREE(m_CfaImage);
+  FREE(m_CfaImage_AfterPhase1);
   FREE(m_Image_AfterPhase2);
   FREE(m_Image_AfterPhase3);
+  UnmapInput();
   FCLOSE(m_InputFile);
   FREE(m_MetaData);
 }
@@ -171,6 +313,8 @@ void CLASS ResetNonUserSettings() {
   // FREE implies setting of the pointer to NULL
   FREE(m_Image);
   FREE(m_Image_AfterPhase1);
+  FREE(m_CfaImage);
+  FREE(m_CfaImage_AfterPhase1);
   FREE(m_Image_AfterPhase2);
   FREE(m_Image_AfterPhase3);
   FREE(m_Image_AfterPhase4);
@@ -178,6 +322,7 @@ void CLASS ResetNonUserSettings() {
   // Some other pointers that are in a dynamic environment better NULL.
   // Same remarks as above.
   FREE(m_MetaData);
+  UnmapInput();
   FCLOSE(m_InputFile);
 
   // This was originally in the identify code, but which is called
@@ -204,6 +349,7 @@ void CLASS ResetNonUserSettings() {
   m_PixelAspect = m_IsRaw = m_RawColor = 1; m_RawColorPhotivo = 0;
   m_TileWidth = m_TileLength = 0;
   m_Raw_Image = 0;
+  m_IdentifiedFromIndex = 0;
   memset (m_Mask, 0, sizeof m_Mask);
   for (int i=0; i < 4; i++) {
     short c;
@@ -305,6 +451,19 @@ void CLASS ResetNonUserSettings() {
 #define BAYER2(row,col) \
   m_Image[(row)*m_Width + (col)][fcol(row,col)]
 
+// The same on the one value per photosite buffer of Phase1, see m_CfaImage.
+#define CFA_BAYER(row,col) \
+  (m_CfaImage ? m_CfaImage[(row)*m_Width + (col)] : BAYER(row,col))
+
+#define CFA_BAYER2(row,col) \
+  (m_CfaImage ? m_CfaImage[(row)*m_Width + (col)] : BAYER2(row,col))
+
+// Channel c of a pixel as the 4 channel image has it: 0 unless it is the
+// colour of the photosite.
+#define CFA_CHANNEL(row,col,c) \
+  (m_CfaImage ? (FC(row,col) == (c) ? m_CfaImage[(row)*m_Width + (col)] : (uint16_t)0) \
+              : m_Image[(row)*m_Width + (col)][c])
+
 int CLASS fcol (int row, int col)
 {
   static const char filter[16][16] =
@@ -664,6 +823,18 @@ unsigned CLASS getbithuff(int nbits,uint16_t *huff)
   if (nbits == -1)
     return m_getbithuff_bitbuf = m_getbithuff_vbits = m_getbithuff_reset = 0;
   if (nbits == 0 || m_getbithuff_vbits < 0) return 0;
+  if (m_InputFile == m_MappedFile) {
+    // Straight from the mapping.
+    TBitReader r = { m_InputMapPos, m_getbithuff_bitbuf, m_getbithuff_vbits,
+                     m_getbithuff_reset, 0, zero_after_ff };
+    c = getbithuff(r, nbits, huff);
+    m_InputMapPos       = r.Pos;
+    m_getbithuff_bitbuf = r.BitBuf;
+    m_getbithuff_vbits  = r.VBits;
+    m_getbithuff_reset  = r.Reset;
+    if (r.Eof) m_InputMapEof = 1;
+    return c;
+  }
   while (!m_getbithuff_reset && m_getbithuff_vbits < nbits && (c = fgetc(m_InputFile)) != EOF &&
     !(m_getbithuff_reset = zero_after_ff && c == 0xff && fgetc(m_InputFile))) {
     m_getbithuff_bitbuf = (m_getbithuff_bitbuf << 8) + (uint8_t) c;
@@ -679,6 +850,44 @@ unsigned CLASS getbithuff(int nbits,uint16_t *huff)
   return c;
 }
 
+// The same as above on the mapped input, with the state in r.
+unsigned CLASS getbithuff(TBitReader &r, int nbits, uint16_t *huff)
+{
+  int c;
+
+  if (nbits == 0 || r.VBits < 0) return 0;
+  const uint8_t* Map  = m_InputMap;
+  const INT64    Size = m_InputMapSize;
+  INT64    Pos    = r.Pos;
+  unsigned BitBuf = r.BitBuf;
+  int      VBits  = r.VBits;
+  while (!r.Reset && VBits < nbits) {
+    if (Pos >= Size) {
+      r.Eof = 1;
+      break;
+    }
+    c = Map[Pos++];
+    if (r.ZeroAfterFF && c == 0xff) {
+      if (Pos >= Size) r.Eof = 1;
+      r.Reset = Pos < Size ? Map[Pos++] != 0 : 1;
+      if (r.Reset) break;
+    }
+    BitBuf = (BitBuf << 8) + c;
+    VBits += 8;
+  }
+  r.Pos    = Pos;
+  r.BitBuf = BitBuf;
+  c = BitBuf << (32-VBits) >> (32-nbits);
+  if (huff) {
+    VBits -= huff[c] >> 8;
+    c = (uint8_t) huff[c];
+  } else
+    VBits -= nbits;
+  r.VBits = VBits;
+  if (VBits < 0) derror();
+  return c;
+}
+
 #define getbits(n) getbithuff(n,0)
 #define gethuff(h) getbithuff(*h,h+1)
 
@@ -938,38 +1147,48 @@ void CLASS ljpeg_end (struct jhead *jh)
   FREE (jh->row);
 }
 
-int CLASS ljpeg_diff (uint16_t *huff)
+int CLASS ljpeg_diff (uint16_t *huff, TBitReader *r)
 {
   int len, diff;
 
-  len = gethuff(huff);
+  len = r ? getbithuff(*r,*huff,huff+1) : gethuff(huff);
 
   if (len == 16 && (!m_DNG_Version || m_DNG_Version >= 0x1010000))
     return -32768;
-  diff = getbits(len);
+  diff = r ? getbithuff(*r,len,0) : getbits(len);
   if ((diff & (1 << (len-1))) == 0)
     diff -= (1 << len) - 1;
   return diff;
 }
 
-uint16_t * CLASS ljpeg_row (int jrow, struct jhead *jh)
+// With r the row is read through that bit reader instead of the input stream.
+uint16_t * CLASS ljpeg_row (int jrow, struct jhead *jh, TBitReader *r)
 {
   int col, c, diff, pred, spred=0;
   uint16_t mark=0, *row[3];
 
   if (jrow * jh->wide % jh->restart == 0) {
     for (c=0;c<6;c++) jh->vpred[c] = 1 << (jh->bits-1);
-    if (jrow) {
-      fseek(m_InputFile,-2,SEEK_CUR);
-      do mark = (mark << 8) + (c = fgetc(m_InputFile));
-      while (c != EOF && mark >> 4 != 0xffd);
+    if (r) {
+      if (jrow) {
+        r->Pos -= 2;
+        do mark = (mark << 8) + (c = r->Pos < m_InputMapSize ? m_InputMap[r->Pos++] : EOF);
+        while (c != EOF && mark >> 4 != 0xffd);
+      }
+      r->BitBuf = r->VBits = r->Reset = 0;
+    } else {
+      if (jrow) {
+        fseek(m_InputFile,-2,SEEK_CUR);
+        do mark = (mark << 8) + (c = fgetc(m_InputFile));
+        while (c != EOF && mark >> 4 != 0xffd);
+      }
+      getbits(-1);
     }
-    getbits(-1);
   }
   for (c=0; c<3; c++) row[c] = jh->row + jh->wide*jh->clrs*((jrow+c) & 1);
   for (col=0; col < jh->wide; col++)
     for (c=0; c < jh->clrs; c++) {
-      diff = ljpeg_diff (jh->huff[c]);
+      diff = ljpeg_diff (jh->huff[c], r);
       if (jh->sraw && c <= jh->sraw && (col | c))
         pred = spred;
       else if (col) pred = row[0][-jh->clrs];
@@ -1002,6 +1221,55 @@ void CLASS lossless_jpeg_load_raw()
 
   TRACEKEYVALS("jh.high","%d",jh.high);
   TRACEKEYVALS("jwide","%d",jwide);
+
+  // The slices of a CR2 are one entropy coded stream and only come apart
+  // where it has restart markers. From the mapped file the restart intervals
+  // are decoded in parallel when they hold whole rows and every pixel only
+  // depends on its own row (psv 1), so that its position follows from jidx.
+  if (m_InputFile == m_MappedFile && jh.psv == 1 && jh.restart > 0 &&
+      jh.restart < INT_MAX && jh.restart % jh.wide == 0 &&
+      !(m_Load_Flags & 1) && (cr2_slice[0] || m_RawWidth != 3984)) {
+    const int RowsPer   = jh.restart / jh.wide;
+    const int Intervals = (jh.high + RowsPer - 1) / RowsPer;
+    std::vector<INT64> Starts(1, ftell(m_InputFile));
+    for (INT64 Pos = Starts[0]; Pos+1 < m_InputMapSize && (int) Starts.size() < Intervals; Pos++)
+      if (m_InputMap[Pos] == 0xff && m_InputMap[Pos+1] >> 4 == 0xd)
+        Starts.push_back(Pos += 2);
+    if ((int) Starts.size() == Intervals) {
+#pragma omp parallel for schedule(dynamic) private(jrow, jcol, val, jidx, i, j, row, col, rp)
+      for (int k=0; k < Intervals; k++) {
+        struct jhead Head = jh;
+        Head.row = (uint16_t *) CALLOC (jh.wide*jh.clrs, 4);
+        merror (Head.row, "lossless_jpeg_load_raw()");
+        TBitReader Reader = { Starts[k], 0, 0, 0, 0, 1 };
+        for (jrow=k*RowsPer; jrow < MIN((k+1)*RowsPer, jh.high); jrow++) {
+          rp = ljpeg_row (jrow, &Head, &Reader);
+          for (jcol=0; jcol < jwide; jcol++) {
+            val  = m_Curve[*rp++];
+            jidx = jrow*jwide + jcol;
+            if (cr2_slice[0]) {
+              i = jidx / (cr2_slice[1]*jh.high);
+              if ((j = i >= cr2_slice[0]))
+                i  = cr2_slice[0];
+              jidx -= i * (cr2_slice[1]*jh.high);
+              row = jidx / cr2_slice[1+j];
+              col = jidx % cr2_slice[1+j] + i*cr2_slice[1];
+              if (m_RawWidth == 3984 && (col -= 2) < 0)
+                col += (row--,m_RawWidth);
+            } else {
+              row = jidx / m_RawWidth;
+              col = jidx % m_RawWidth;
+            }
+            if (row >= 0 && row < m_RawHeight) RAW(row,col) = val;
+          }
+        }
+        FREE (Head.row);
+      }
+      ljpeg_end(&jh);
+      return;
+    }
+  }
+
   for (jrow=0; jrow < jh.high; jrow++) {
     rp = ljpeg_row (jrow, &jh);
     if (m_Load_Flags & 1)
@@ -1126,6 +1394,58 @@ void CLASS lossless_dng_load_raw()
   struct jhead jh;
   uint16_t *rp;
 
+  // Tiles are independent JPEG streams. From the mapped file they are decoded
+  // in parallel: the headers are read here a batch at a time, which bounds the
+  // memory of their decode tables, then every tile of the batch is decoded
+  // with its own bit reader.
+  if (m_InputFile == m_MappedFile && m_TileLength < INT_MAX) {
+    const unsigned CBatch = 64;
+    std::vector<jhead>      Heads;
+    std::vector<TBitReader> Readers;
+    std::vector<unsigned>   TileRows, TileCols;
+    int Done = 0;
+    while (!Done) {
+      Heads.clear();
+      Readers.clear();
+      TileRows.clear();
+      TileCols.clear();
+      while (trow < m_RawHeight && Heads.size() < CBatch) {
+        save = ftell(m_InputFile);
+        fseek (m_InputFile, get4(), SEEK_SET);
+        if (!ljpeg_start (&jh, 0)) {
+          Done = 1;
+          break;
+        }
+        TBitReader Reader = { ftell(m_InputFile), 0, 0, 0, 0, zero_after_ff };
+        Heads.push_back(jh);
+        Readers.push_back(Reader);
+        TileRows.push_back(trow);
+        TileCols.push_back(tcol);
+        fseek (m_InputFile, save+4, SEEK_SET);
+        if ((tcol += m_TileWidth) >= m_RawWidth)
+          trow += m_TileLength + (tcol = 0);
+      }
+      if (trow >= m_RawHeight) Done = 1;
+
+#pragma omp parallel for schedule(dynamic) private(jwide, jrow, jcol, row, col, rp)
+      for (int t=0; t < (int) Heads.size(); t++) {
+        jwide = Heads[t].wide;
+        if (m_Filters) jwide *= Heads[t].clrs;
+        jwide /= m_IsRaw;
+        for (row=col=jrow=0; jrow < (unsigned) Heads[t].high; jrow++) {
+          rp = ljpeg_row (jrow, &Heads[t], &Readers[t]);
+          for (jcol=0; jcol < jwide; jcol++) {
+            adobe_copy_pixel (TileRows[t]+row, TileCols[t]+col, &rp);
+            if (++col >= m_TileWidth || col >= m_RawWidth)
+              row += 1 + (col = 0);
+          }
+        }
+      }
+      for (unsigned t=0; t < Heads.size(); t++) ljpeg_end(&Heads[t]);
+    }
+    return;
+  }
+
   while (trow < m_RawHeight) {
     save = ftell(m_InputFile);
     if (m_TileLength < INT_MAX)
@@ -1155,6 +1475,40 @@ void CLASS packed_dng_load_raw()
   // int row, col;
   unsigned row, col;
 
+  // From the mapped file the rows are decoded in parallel, a block at a time.
+  // Each row starts at a fixed offset, as getbits(-1) realigns to a byte.
+  if (m_InputFile == m_MappedFile && !zero_after_ff) {
+    const unsigned CBlock    = 256;
+    const unsigned RowLength = m_RawWidth * m_Tiff_Samples;
+    const INT64    RowBytes  = ((INT64) RowLength * m_Tiff_bps + 7) / 8;
+    const INT64    Start     = ftell(m_InputFile);
+    const int      Swap      = (m_ByteOrder == 0x4949) == (ntohs(0x1234) == 0x1234);
+    pixel = (uint16_t *) CALLOC ((size_t) RowLength * CBlock, sizeof *pixel);
+    merror (pixel, "packed_dng_load_raw()");
+    for (unsigned Block=0; Block < m_RawHeight; Block += CBlock) {
+      const int Rows = MIN(CBlock, m_RawHeight - Block);
+#pragma omp parallel for schedule(static) private(row, col, rp)
+      for (int r=0; r < Rows; r++) {
+        row = Block + r;
+        rp  = pixel + (size_t) r * RowLength;
+        TBitReader Reader = { Start + row*RowBytes, 0, 0, 0, 0, 0 };
+        if (m_Tiff_bps == 16) {
+          INT64 Bytes = MIN(RowBytes, m_InputMapSize - Reader.Pos);
+          if (Bytes < RowBytes) derror();
+          if (Bytes > 0) memcpy (rp, m_InputMap + Reader.Pos, Bytes);
+          if (Swap) swab ((char *)rp, (char *)rp, RowLength*2);
+        } else {
+          for (col=0; col < RowLength; col++)
+            rp[col] = getbithuff(Reader, m_Tiff_bps, 0);
+        }
+        for (col=0; col < m_RawWidth; col++)
+          adobe_copy_pixel (row, col, &rp);
+      }
+    }
+    FREE (pixel);
+    return;
+  }
+
   pixel = (uint16_t *) CALLOC (m_RawWidth * m_Tiff_Samples, sizeof *pixel);
   merror (pixel, "packed_dng_load_raw()");
   for (row=0; row < m_RawHeight; row++) {
@@ -2196,7 +2550,7 @@ fill_input_buffer (j_decompress_ptr cinfo)
   size_t nbytes;
   ptDcRaw *data = (ptDcRaw*) cinfo->client_data;
 
-  nbytes = fread (jpeg_buffer, 1, 4096, data->m_InputFile);
+  nbytes = data->InRead (jpeg_buffer, 1, 4096, data->m_InputFile);
   swab ((char *)jpeg_buffer, (char *)jpeg_buffer, nbytes);
   cinfo->src->next_input_byte = jpeg_buffer;
   cinfo->src->bytes_in_buffer = nbytes;
@@ -2214,7 +2568,7 @@ void CLASS kodak_jpeg_load_raw()
   cinfo.client_data = this;
   cinfo.err = jpeg_std_error (&jerr);
   jpeg_create_decompress (&cinfo);
-  jpeg_stdio_src (&cinfo, m_InputFile);
+  jpeg_stdio_src (&cinfo, InStdio(m_InputFile));
   cinfo.src->fill_input_buffer = fill_input_buffer;
   jpeg_read_header (&cinfo, TRUE);
   jpeg_start_decompress (&cinfo);
@@ -2281,7 +2635,7 @@ void CLASS lossy_dng_load_raw()
     fseek (m_InputFile, save+=4, SEEK_SET);
     if (m_TileLength < INT_MAX)
       fseek (m_InputFile, get4(), SEEK_SET);
-    jpeg_stdio_src (&cinfo, m_InputFile);
+    jpeg_stdio_src (&cinfo, InStdio(m_InputFile));
     jpeg_read_header (&cinfo, TRUE);
     jpeg_start_decompress (&cinfo);
     buf = (*cinfo.mem->alloc_sarray)
@@ -3553,13 +3907,13 @@ void CLASS crop_masked_pixels()
     c = row + ((col+1) >> 1);
   }
   if (r < m_Height && c < m_Width)
-    BAYER(r,c) = RAW(row+m_TopMargin,col+m_LeftMargin);
+    CFA_BAYER(r,c) = RAW(row+m_TopMargin,col+m_LeftMargin);
       }
     }
   } else {
     for (row=0; row < m_Height; row++)
       for (col=0; col < m_Width; col++)
-  BAYER2(row,col) = RAW(row+m_TopMargin,col+m_LeftMargin);
+  CFA_BAYER2(row,col) = RAW(row+m_TopMargin,col+m_LeftMargin);
   }
   if (m_Mask[0][3]) goto mask_set;
   if (m_LoadRawFunction == &CLASS canon_load_raw ||
@@ -3608,14 +3962,14 @@ void CLASS remove_zeroes()
 
   for (row=0; row < m_Height; row++)
     for (col=0; col < m_Width; col++)
-      if (BAYER(row,col) == 0) {
+      if (CFA_BAYER(row,col) == 0) {
   tot = n = 0;
   for (r = row-2; r <= row+2; r++)
     for (c = col-2; c <= col+2; c++)
       if (r < m_Height && c < m_Width &&
-    FC(r,c) == FC(row,col) && BAYER(r,c))
-        tot += (n++,BAYER(r,c));
-  if (n) BAYER(row,col) = tot/n;
+    FC(r,c) == FC(row,col) && CFA_BAYER(r,c))
+        tot += (n++,CFA_BAYER(r,c));
+  if (n) CFA_BAYER(row,col) = tot/n;
       }
 }
 
@@ -3670,10 +4024,10 @@ void CLASS bad_pixels (const char *cfname)
   for (c = col-rad; c <= col+rad; c++)
     if ((unsigned) r < m_Height && (unsigned) c < m_Width &&
     (r != row || c != col) && fcol(r,c) == fcol(row,col)) {
-      tot += BAYER2(r,c);
+      tot += CFA_BAYER2(r,c);
       n++;
     }
-    BAYER2(row,col) = tot/n;
+    CFA_BAYER2(row,col) = tot/n;
     TRACEKEYVALS("Fixed dead pixel at column","%d",col);
     TRACEKEYVALS("Fixed dead pixel at row","%d",row);
   }
@@ -3714,7 +4068,7 @@ void CLASS subtract (const char *fname)
   for (row=0; row < m_Height; row++) {
     ptfread (pixel, 2, m_Width, fp);
     for (col=0; col < m_Width; col++)
-      BAYER(row,col) = MAX (BAYER(row,col) - ntohs(pixel[col]), 0);
+      CFA_BAYER(row,col) = MAX (CFA_BAYER(row,col) - ntohs(pixel[col]), 0);
   }
   FREE (pixel);
   FCLOSE (fp);
@@ -3896,7 +4250,7 @@ void CLASS ptScaleColors() {
             for (c=0; c < 4; c++) {
               if (m_Filters) {
             c = fcol(y,x);
-            val = BAYER2(y,x);
+            val = CFA_BAYER2(y,x);
               } else
                 val = m_Image[y*m_Width+x][c];
               if ((unsigned) val > m_WhiteLevel-25) goto skip_block;
@@ -3948,7 +4302,11 @@ void CLASS ptScaleColors() {
 
   // Denoising before color scaling and interpolation.
   // Remark m_BlackLevel and m_WhiteLevel migth be changed.
-  if (m_UserSetting_DenoiseThreshold) ptWaveletDenoise();
+  // It works on whole channel planes, so it needs the 4 channel image.
+  if (m_UserSetting_DenoiseThreshold) {
+    ptExpandCfa();
+    ptWaveletDenoise();
+  }
 
   for (dmin=DBL_MAX, dmax=c=0; c < 4; c++) {
     if (dmin > VALUE(m_PreMultipliers[c]))
@@ -4010,6 +4368,17 @@ void CLASS ptScaleColors() {
     }
   }
 
+  if (m_CfaImage) {
+#pragma omp parallel for schedule(static)
+    for (uint16_t Row = 0; Row < m_Height; Row++) {
+      for (uint16_t Col = 0; Col < m_Width; Col++) {
+        uint16_t &Value = m_CfaImage[Row*m_Width + Col];
+        Value = LUT[Value][FC(Row,Col)];
+      }
+    }
+    return;
+  }
+
   uint32_t Size = m_OutHeight*m_OutWidth;
 #pragma omp parallel for schedule(static)
   for (uint32_t i = 0; i < Size; i++) {
@@ -4372,10 +4741,9 @@ void CLASS vng_interpolate()
     +1,-1,+1,+1,0,0x88, +1,+0,+1,+2,0,0x08, +1,+0,+2,-1,0,0x40,
     +1,+0,+2,+1,0,0x10
   }, chood[] = { -1,-1, -1,0, -1,+1, 0,+1, +1,+1, +1,0, +1,-1, 0,-1 };
-  uint16_t (*brow[5])[4], *pix;
-  int prow=8, pcol=2, *ip, *code[16][16], gval[8], gmin, gmax, sum[4];
+  int prow=8, pcol=2, *ip, *code[16][16];
   int row, col, x, y, x1, x2, y1, y2, t, weight, grads, color, diag;
-  int g, diff, thold, num, c;
+  int g;
 
   lin_interpolate();
 
@@ -4416,12 +4784,38 @@ void CLASS vng_interpolate()
       }
     }
 
+  // The rows are done in bands of CBand in parallel. Within a band the
+  // results are written back two rows late as before, so that only the
+  // original values are read. The first and last two rows of a band are
+  // read by the neighbouring bands as well, they are held back until all
+  // bands are done.
+  const int CBand  = 64;
+  const int Bands  = (m_Height-4 + CBand-1) / CBand;
+  uint16_t (*Held)[4] = (uint16_t (*)[4]) CALLOC ((size_t) Bands*4*m_Width, sizeof *m_Image);
+  merror (Held, "vng_interpolate()");
+  int *HeldRow = (int *) MALLOC (Bands*4*sizeof *HeldRow);
+  merror (HeldRow, "vng_interpolate()");
+  for (t=0; t < Bands*4; t++) HeldRow[t] = -1;
+
+#pragma omp parallel
+{
+  uint16_t (*brow[5])[4], *pix;
+  int *ip, gval[8], gmin, gmax, sum[4];
+  int row, col, t, color, g, diff, thold, num, c;
+
   brow[4] = (uint16_t (*)[4]) CALLOC (m_Width*3, sizeof **brow);
   merror (brow[4], "vng_interpolate()");
+
+#pragma omp for schedule(dynamic)
+  for (int Band=0; Band < Bands; Band++) {
+  const int First = 2 + Band*CBand;
+  const int Last  = MIN(First+CBand, m_Height-2);
+  uint16_t (*BandHeld)[4] = Held + (size_t) Band*4*m_Width;
+  int *BandHeldRow = HeldRow + Band*4;
   for (row=0; row < 3; row++)
     brow[row] = brow[4] + row*m_Width;
 
-  for (row=2; row < m_Height-2; row++) {    /* Do VNG interpolation */
+  for (row=First; row < Last; row++) {    /* Do VNG interpolation */
     for (col=2; col < m_Width-2; col++) {
       pix = m_Image[row*m_Width+col];
       ip = code[row % prow][col % pcol];
@@ -4465,14 +4859,30 @@ void CLASS vng_interpolate()
   brow[2][col][c] = CLIP(t);
       }
     }
-    if (row > 3)        /* Write buffer to image */
+    if (row-2 >= First+2)   /* Write buffer to image */
       memcpy (m_Image[(row-2)*m_Width+2], brow[0]+2, (m_Width-4)*sizeof *m_Image);
+    else if (row-2 >= First) {
+      memcpy (BandHeld + (row-2-First)*m_Width, brow[0], m_Width*sizeof *m_Image);
+      BandHeldRow[row-2-First] = row-2;
+    }
     for (g=0; g < 4; g++)
       brow[(g-1) & 3] = brow[g];
   }
-  memcpy (m_Image[(row-2)*m_Width+2], brow[0]+2, (m_Width-4)*sizeof *m_Image);
-  memcpy (m_Image[(row-1)*m_Width+2], brow[1]+2, (m_Width-4)*sizeof *m_Image);
+  for (t=0; t < 2; t++) {
+    if (row-2+t < First) continue;
+    memcpy (BandHeld + (2+t)*m_Width, brow[t], m_Width*sizeof *m_Image);
+    BandHeldRow[2+t] = row-2+t;
+  }
+  }
   FREE (brow[4]);
+}
+
+  for (t=0; t < Bands*4; t++)
+    if (HeldRow[t] >= 0)
+      memcpy (m_Image[HeldRow[t]*m_Width+2], Held + (size_t) t*m_Width + 2,
+              (m_Width-4)*sizeof *m_Image);
+  FREE (HeldRow);
+  FREE (Held);
   FREE (code[0][0]);
 }
 
@@ -8489,10 +8899,146 @@ void CLASS jpeg_thumb ()
 //
 ////////////////////////////////////////////////////////////////////////////////
 
-short CLASS Identify(const QString NewInputFile) {
+// The identify results kept in the ptRawIndex: what is read between
+// Identify() and RunDcRaw_Phase1() and what thumbnail() needs for jpeg and
+// ppm thumbnails. Bump IndexRecordVersion whenever TIndexRecord changes.
+
+static const qint32 IndexRecordVersion = 1;
+
+struct TIndexRecord {
+  unsigned  IsRaw, Filters, BlackLevel, WhiteLevel, RawColor, RawColorPhotivo;
+  unsigned  ThumbLength;
+  int       Flip;
+  INT64     ThumbOffset, DataOffset, TimeStamp;
+  uint16_t  Width, Height, RawWidth, RawHeight, TopMargin, FujiWidth, IsFuji;
+  uint16_t  ThumbWidth, ThumbHeight;
+  short     LeftMargin, Colors, ThumbKind;  // 1 jpeg_thumb, 2 ppm_thumb, 0 other
+  float     IsoSpeed, Shutter, Aperture, FocalLength, PixelAspect;
+  float     CameraMultipliers[4], PreMultipliers[4], D65Multipliers[4];
+  float     cmatrix[3][4], MatrixCamRGBToSRGB[3][4];
+  char      CameraMake[64], CameraModel[64], CameraModelBis[64];
+  char      CameraAdobeIdentification[128], Artist[64], Description[512];
+  char      ColorDescriptor[5];
+};
+
+QByteArray CLASS IndexRecord() {
+  TIndexRecord r;
+  memset (&r, 0, sizeof r);
+  r.IsRaw           = m_IsRaw;
+  r.Filters         = m_Filters;
+  r.BlackLevel      = m_BlackLevel;
+  r.WhiteLevel      = m_WhiteLevel;
+  r.RawColor        = m_RawColor;
+  r.RawColorPhotivo = m_RawColorPhotivo;
+  r.ThumbLength     = m_ThumbLength;
+  r.Flip            = m_Flip;
+  r.ThumbOffset     = m_ThumbOffset;
+  r.DataOffset      = m_Data_Offset;
+  r.TimeStamp       = m_TimeStamp;
+  r.Width           = m_Width;
+  r.Height          = m_Height;
+  r.RawWidth        = m_RawWidth;
+  r.RawHeight       = m_RawHeight;
+  r.TopMargin       = m_TopMargin;
+  r.FujiWidth       = m_Fuji_Width;
+  r.IsFuji          = m_IsFuji;
+  r.ThumbWidth      = m_ThumbWidth;
+  r.ThumbHeight     = m_ThumbHeight;
+  r.LeftMargin      = m_LeftMargin;
+  r.Colors          = m_Colors;
+  r.ThumbKind       = m_WriteThumb == &CLASS jpeg_thumb ? 1 :
+                      m_WriteThumb == &CLASS ppm_thumb  ? 2 : 0;
+  r.IsoSpeed        = m_IsoSpeed;
+  r.Shutter         = m_Shutter;
+  r.Aperture        = m_Aperture;
+  r.FocalLength     = m_FocalLength;
+  r.PixelAspect     = m_PixelAspect;
+  for (int c=0; c<4; c++) {
+    r.CameraMultipliers[c] = VALUE(m_CameraMultipliers[c]);
+    r.PreMultipliers[c]    = VALUE(m_PreMultipliers[c]);
+    r.D65Multipliers[c]    = VALUE(m_D65Multipliers[c]);
+  }
+  memcpy (r.cmatrix, m_cmatrix, sizeof r.cmatrix);
+  memcpy (r.MatrixCamRGBToSRGB, m_MatrixCamRGBToSRGB, sizeof r.MatrixCamRGBToSRGB);
+  memcpy (r.CameraMake, m_CameraMake, sizeof r.CameraMake);
+  memcpy (r.CameraModel, m_CameraModel, sizeof r.CameraModel);
+  memcpy (r.CameraModelBis, m_CameraModelBis, sizeof r.CameraModelBis);
+  memcpy (r.CameraAdobeIdentification, m_CameraAdobeIdentification,
+          sizeof r.CameraAdobeIdentification);
+  memcpy (r.Artist, m_Artist, sizeof r.Artist);
+  memcpy (r.Description, m_Description, sizeof r.Description);
+  memcpy (r.ColorDescriptor, m_ColorDescriptor, sizeof r.ColorDescriptor);
+
+  QByteArray Record;
+  QDataStream Stream(&Record, QIODevice::WriteOnly);
+  Stream << IndexRecordVersion << (qint32) sizeof r;
+  Stream.writeRawData((const char*) &r, sizeof r);
+  return Record;
+}
+
+// Restores the identification from a record of IndexRecord().
+// Expects a fresh ResetNonUserSettings(). Returns 0 on success.
+short CLASS FromIndexRecord(const QByteArray &Record) {
+  TIndexRecord r;
+  qint32 Version = 0, Size = 0;
+  QDataStream Stream(Record);
+  Stream >> Version >> Size;
+  if (Version != IndexRecordVersion || Size != (qint32) sizeof r ||
+      Stream.readRawData((char*) &r, sizeof r) != (int) sizeof r)
+    return 1;
+
+  m_IsRaw           = r.IsRaw;
+  m_Filters         = r.Filters;
+  m_BlackLevel      = r.BlackLevel;
+  m_WhiteLevel      = r.WhiteLevel;
+  m_RawColor        = r.RawColor;
+  m_RawColorPhotivo = r.RawColorPhotivo;
+  m_ThumbLength     = r.ThumbLength;
+  m_Flip            = r.Flip;
+  m_ThumbOffset     = r.ThumbOffset;
+  m_Data_Offset     = r.DataOffset;
+  m_TimeStamp       = r.TimeStamp;
+  m_Width           = r.Width;
+  m_Height          = r.Height;
+  m_RawWidth        = r.RawWidth;
+  m_RawHeight       = r.RawHeight;
+  m_TopMargin       = r.TopMargin;
+  m_Fuji_Width      = r.FujiWidth;
+  m_IsFuji          = r.IsFuji;
+  m_ThumbWidth      = r.ThumbWidth;
+  m_ThumbHeight     = r.ThumbHeight;
+  m_LeftMargin      = r.LeftMargin;
+  m_Colors          = r.Colors;
+  m_WriteThumb      = r.ThumbKind == 1 ? &CLASS jpeg_thumb :
+                      r.ThumbKind == 2 ? &CLASS ppm_thumb  : 0;
+  m_IsoSpeed        = r.IsoSpeed;
+  m_Shutter         = r.Shutter;
+  m_Aperture        = r.Aperture;
+  m_FocalLength     = r.FocalLength;
+  m_PixelAspect     = r.PixelAspect;
+  for (int c=0; c<4; c++) {
+    ASSIGN(m_CameraMultipliers[c], r.CameraMultipliers[c]);
+    ASSIGN(m_PreMultipliers[c], r.PreMultipliers[c]);
+    ASSIGN(m_D65Multipliers[c], r.D65Multipliers[c]);
+  }
+  memcpy (m_cmatrix, r.cmatrix, sizeof r.cmatrix);
+  memcpy (m_MatrixCamRGBToSRGB, r.MatrixCamRGBToSRGB, sizeof r.MatrixCamRGBToSRGB);
+  memcpy (m_CameraMake, r.CameraMake, sizeof r.CameraMake);
+  memcpy (m_CameraModel, r.CameraModel, sizeof r.CameraModel);
+  memcpy (m_CameraModelBis, r.CameraModelBis, sizeof r.CameraModelBis);
+  memcpy (m_CameraAdobeIdentification, r.CameraAdobeIdentification,
+          sizeof r.CameraAdobeIdentification);
+  memcpy (m_Artist, r.Artist, sizeof r.Artist);
+  memcpy (m_Description, r.Description, sizeof r.Description);
+  memcpy (m_ColorDescriptor, r.ColorDescriptor, sizeof r.ColorDescriptor);
+  return 0;
+}
+
+short CLASS Identify(const QString NewInputFile, const short UseIndex) {
 
   // This is here to support multiple calls.
   ResetNonUserSettings();
+  UnmapInput();
   FCLOSE(m_InputFile);
 
   if (NewInputFile != "") {
@@ -8502,14 +9048,23 @@ short CLASS Identify(const QString NewInputFile) {
     strcpy(m_UserSetting_InputFileName, NewInputFile.toLocal8Bit().data());
   }
 
+  const QString IndexName = QString::fromLocal8Bit(m_UserSetting_InputFileName);
+  if (UseIndex && !FromIndexRecord(ptRawIndex::instance()->find(IndexName))) {
+    m_IdentifiedFromIndex = 1;
+    return !m_IsRaw;
+  }
+
   if (!(m_InputFile = fopen (m_UserSetting_InputFileName, "rb"))) {
     perror (m_UserSetting_InputFileName);
     return -1;
   }
+  MapInput();
 
   identify();
+  ptRawIndex::instance()->insert(IndexName, IndexRecord());
 
   if (!m_IsRaw) {
+    UnmapInput();
     FCLOSE(m_InputFile);
   }
   return !m_IsRaw;
@@ -8530,6 +9085,9 @@ short CLASS Identify(const QString NewInputFile) {
 
 short CLASS RunDcRaw_Phase1() {
 
+  // Loading needs the decoder state the index does not keep.
+  if (m_IdentifiedFromIndex && Identify()) return -1;
+
   // TODO foveon for the moment not in. Need study material
   // to have this +/- right.
   assert (!m_IsFoveon);
@@ -8585,6 +9143,7 @@ short CLASS RunDcRaw_Phase1() {
 
   // Allocation is depending on m_Raw_Image below.
   FREE(m_Image);
+  FREE(m_CfaImage);
 
   if (m_MetaLength) {
     FREE(m_MetaData);
@@ -8614,9 +9173,15 @@ short CLASS RunDcRaw_Phase1() {
   (*this.*m_LoadRawFunction)();
 
   if (m_Raw_Image) {
-    // Basic image memory allocation @ 4 int per pixel happens here.
-    m_Image = (uint16_t (*)[4]) CALLOC (m_OutHeight*m_OutWidth, sizeof *m_Image);
-    merror (m_Image, "main()");
+    if (m_Filters) {
+      // Bayer data: one value per photosite up to Phase2.
+      m_CfaImage = (uint16_t *) CALLOC (m_OutHeight*m_OutWidth, sizeof *m_CfaImage);
+      merror (m_CfaImage, "main()");
+    } else {
+      // Basic image memory allocation @ 4 int per pixel happens here.
+      m_Image = (uint16_t (*)[4]) CALLOC (m_OutHeight*m_OutWidth, sizeof *m_Image);
+      merror (m_Image, "main()");
+    }
     crop_masked_pixels();
     FREE (m_Raw_Image);
   }
@@ -8674,11 +9239,18 @@ short CLASS RunDcRaw_Phase1() {
   TRACEKEYVALS("Flip","%x",m_Flip);
 
   // Cache the image after Phase1.
+  // Bayer data is not copied, its buffer becomes the cache.
   FREE(m_Image_AfterPhase1);
-  m_Image_AfterPhase1 =
-    (uint16_t (*)[4]) CALLOC (m_OutHeight*m_OutWidth, sizeof *m_Image);
-  merror (m_Image_AfterPhase1, "main()");
-  memcpy(m_Image_AfterPhase1,m_Image,m_OutHeight*m_OutWidth*sizeof(*m_Image));
+  FREE(m_CfaImage_AfterPhase1);
+  if (m_CfaImage) {
+    m_CfaImage_AfterPhase1 = m_CfaImage;
+    m_CfaImage = NULL;
+  } else {
+    m_Image_AfterPhase1 =
+      (uint16_t (*)[4]) CALLOC (m_OutHeight*m_OutWidth, sizeof *m_Image);
+    merror (m_Image_AfterPhase1, "main()");
+    memcpy(m_Image_AfterPhase1,m_Image,m_OutHeight*m_OutWidth*sizeof(*m_Image));
+  }
   // Some other stuff to cache.
   m_Filters_AfterPhase1 = m_Filters;
   m_BlackLevel_AfterPhase1 = m_BlackLevel;
@@ -8705,18 +9277,36 @@ short CLASS RunDcRaw_Phase1() {
 short CLASS RunDcRaw_Phase2(const short NoCache) {
 
   // Make sure we are starting from the right image.
-  if (NoCache) {
+  if (NoCache && !m_CfaImage_AfterPhase1) {
     FREE(m_Image_AfterPhase1);
   } else {
     FREE(m_Image);
+    FREE(m_CfaImage);
     m_Width = m_Width_AfterPhase1;
     m_Height = m_Height_AfterPhase1;
     m_OutWidth = m_OutWidth_AfterPhase1;
     m_OutHeight = m_OutHeight_AfterPhase1;
-    m_Image =
-      (uint16_t (*)[4]) CALLOC (m_OutHeight*m_OutWidth, sizeof *m_Image);
-    merror (m_Image, "main()");
-    memcpy(m_Image,m_Image_AfterPhase1,m_OutHeight*m_OutWidth*sizeof(*m_Image));
+    if (m_CfaImage_AfterPhase1) {
+      // Bayer data stays one value per photosite up to the interpolation.
+      if (NoCache) {
+        m_CfaImage = m_CfaImage_AfterPhase1;
+        m_CfaImage_AfterPhase1 = NULL;
+      } else {
+        // With room for ptExpandCfa(), which then needs no second buffer.
+        m_CfaImage = (uint16_t *) MALLOC (m_OutHeight*m_OutWidth*sizeof *m_Image);
+        merror (m_CfaImage, "main()");
+        memcpy(m_CfaImage,m_CfaImage_AfterPhase1,m_OutHeight*m_OutWidth*sizeof *m_CfaImage);
+      }
+      // The steps up to the interpolation take the colour from FC(). The
+      // 16x16 and 6x6 patterns (m_Filters 1 and 2) need the 4 channels.
+      m_Filters = m_Filters_AfterPhase1;
+      if (m_Filters < 1000) ptExpandCfa();
+    } else {
+      m_Image =
+        (uint16_t (*)[4]) CALLOC (m_OutHeight*m_OutWidth, sizeof *m_Image);
+      merror (m_Image, "main()");
+      memcpy(m_Image,m_Image_AfterPhase1,m_OutHeight*m_OutWidth*sizeof(*m_Image));
+    }
     // Restore some other cached values.
     m_Filters    = m_Filters_AfterPhase1;
     m_BlackLevel = m_BlackLevel_AfterPhase1;
@@ -8798,6 +9388,9 @@ short CLASS RunDcRaw_Phase2(const short NoCache) {
 
   TRACEKEYVALS("Colors","%d",m_Colors);
 
+  // From here on the 4 channel image.
+  ptExpandCfa();
+
   // not 1:1 pipe, use FC marco instead of interpolation
   uint16_t    (*TempImage)[4];
   if (m_Shrink && m_Filters != 2) { // -> preinterpolate will set m_Filters = 0 if != 2
@@ -9130,6 +9723,40 @@ void CLASS ptHotpixelReductionBayer() {
   uint16_t Width = m_OutWidth;
   uint16_t Height = m_OutHeight;
 
+  if (m_CfaImage) {
+    // One value per photosite, the other channels of the 4 channel loop below
+    // are 0. Only the colour of the photosite can be hot, and no photosite is
+    // cold: the minimum over the channels of its neighbours is always 0.
+#pragma omp parallel for schedule(static)
+    for (uint16_t Row=0; Row<Height; Row++) {
+      for (uint16_t Col=0; Col<Width; Col++) {
+        uint16_t &Value = m_CfaImage[Row*Width+Col];
+        if (Value <= HotpixelThreshold) continue;
+        const int Color = FC(Row,Col);
+        uint16_t TempValue = 0;
+        if (Row > 2) TempValue = MAX(CFA_CHANNEL(Row-2,Col,Color),TempValue);
+        if (Row < Height-2) TempValue = MAX(CFA_CHANNEL(Row+2,Col,Color),TempValue);
+        if (Col > 2) TempValue = MAX(CFA_CHANNEL(Row,Col-2,Color),TempValue);
+        if (Col < Width-2) TempValue = MAX(CFA_CHANNEL(Row,Col+2,Color),TempValue);
+        if (TempValue+Threshold >= Value) continue;
+        if (Row > 1) {
+          TempValue = MAX(m_CfaImage[(Row-1)*Width+Col],TempValue);
+          if (Col > 1) TempValue = MAX(m_CfaImage[(Row-1)*Width+Col-1],TempValue);
+          if (Col < Width-1) TempValue = MAX(m_CfaImage[(Row-1)*Width+Col+1],TempValue);
+        }
+        if (Row < Height-1) {
+          TempValue = MAX(m_CfaImage[(Row+1)*Width+Col],TempValue);
+          if (Col > 1) TempValue = MAX(m_CfaImage[(Row+1)*Width+Col-1],TempValue);
+          if (Col < Width-1) TempValue = MAX(m_CfaImage[(Row+1)*Width+Col+1],TempValue);
+        }
+        if (Col > 1) TempValue = MAX(m_CfaImage[Row*Width+Col-1],TempValue);
+        if (Col < Width-1) TempValue = MAX(m_CfaImage[Row*Width+Col+1],TempValue);
+        if (TempValue+Threshold < Value) Value = TempValue;
+      }
+    }
+    return;
+  }
+
 #pragma omp parallel for schedule(static)
   for (uint16_t Row=0; Row<Height; Row++) {
     for (uint16_t Col=0; Col<Width; Col++) {
@@ -9227,31 +9854,89 @@ void CLASS ptCrop() {
     SWAP(CropW, CropH);
     SWAP(CropX, CropY);
   }
+  // Bayer data is cropped as it is when every photosite keeps its colour.
+  short KeepsPattern = 1;
+  for (short row=0; row < 8; row++)
+    for (short col=0; col < 2; col++)
+      if (FC(row+CropY,col+CropX) != FC(row,col)) KeepsPattern = 0;
+  if (!KeepsPattern) ptExpandCfa();
+
   m_OutHeight = CropH;
   m_OutWidth  = CropW;
-  TempImage = (uint16_t (*)[4]) CALLOC (m_OutHeight*m_OutWidth, sizeof *TempImage);
-  merror (TempImage, "Temp for detail view");
+  if (m_CfaImage) {
+    // With room for ptExpandCfa() like in RunDcRaw_Phase2().
+    uint16_t *TempCfa = (uint16_t *) CALLOC (m_OutHeight*m_OutWidth, sizeof *m_Image);
+    merror (TempCfa, "Temp for detail view");
+#pragma omp parallel for schedule(static)
+    for (uint16_t row=0; row < m_OutHeight; row++) {
+      memcpy(TempCfa + row*m_OutWidth, m_CfaImage + (row+CropY)*m_Width + CropX,
+             m_OutWidth*sizeof *TempCfa);
+    }
+    FREE(m_CfaImage);
+    m_CfaImage = TempCfa;
+  } else {
+    TempImage = (uint16_t (*)[4]) CALLOC (m_OutHeight*m_OutWidth, sizeof *TempImage);
+    merror (TempImage, "Temp for detail view");
 
 #pragma omp parallel for schedule(static)
-  for (uint16_t row=0; row < m_OutHeight; row++) {
-    for (uint16_t col=0; col < m_OutWidth; col++) {
-      for (short c=0; c<4; c++) {
-        TempImage[row *m_OutWidth + col][c] =
-          m_Image[(row+CropY)*m_Width + (col+CropX)][c];
+    for (uint16_t row=0; row < m_OutHeight; row++) {
+      for (uint16_t col=0; col < m_OutWidth; col++) {
+        for (short c=0; c<4; c++) {
+          TempImage[row *m_OutWidth + col][c] =
+            m_Image[(row+CropY)*m_Width + (col+CropX)][c];
+        }
       }
     }
+    FREE(m_Image);
+    m_Image = TempImage;
   }
 
   m_Width = m_OutWidth;
   m_Height = m_OutHeight;
-  FREE(m_Image);
-  m_Image = TempImage;
   TRACEKEYVALS("Phase2 detail view Width","%d",m_Width);
   TRACEKEYVALS("Phase2 detail view Height","%d",m_Height);
   TRACEKEYVALS("Phase2 detail view OutWidth","%d",m_OutWidth);
   TRACEKEYVALS("Phase2 detail view OutHeight","%d",m_OutHeight);
 }
 
+////////////////////////////////////////////////////////////////////////////////
+//
+// ExpandCfa
+// Turns m_CfaImage into the 4 channel m_Image, the values go into the
+// channels crop_masked_pixels() chose. Nothing to do without m_CfaImage.
+//
+// The buffer is grown and expanded in place, so the peak stays at the size
+// of the 4 channel image. Row r is written over the values of rows 4r to
+// 4r+3: rows from (Hi+3)/4 up to Hi only overwrite rows that are done and
+// can go in parallel, then the next quarter follows. Row 0 overlaps itself
+// and is expanded back to front.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void CLASS ptExpandCfa() {
+  if (!m_CfaImage) return;
+
+  FREE(m_Image);
+  uint16_t *Cfa = (uint16_t *) REALLOC (m_CfaImage, m_OutHeight*m_OutWidth*sizeof *m_Image);
+  merror (Cfa, "ptExpandCfa()");
+  m_CfaImage = NULL;
+  m_Image = (uint16_t (*)[4]) Cfa;
+
+  for (int Hi = m_Height; Hi > 0; ) {
+    const int Lo = Hi > 1 ? (Hi+3)/4 : 0;
+#pragma omp parallel for schedule(static)
+    for (int row=Lo; row < Hi; row++) {
+      for (int col=m_Width-1; col >= 0; col--) {
+        const uint16_t Value = Cfa[row*m_Width + col];
+        uint16_t *Pixel = m_Image[row*m_Width + col];
+        Pixel[0] = Pixel[1] = Pixel[2] = Pixel[3] = 0;
+        Pixel[m_IsFuji ? FC(row,col) : fcol(row,col)] = Value;
+      }
+    }
+    Hi = Lo;
+  }
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 //
 // MedianFilter
@@ -9635,7 +10320,17 @@ void CLASS CamToLab(uint16_t Cam[4], double Lab[3]) {
 TImage8RawData ptDcRaw::thumbnail() {
   m_Thumb.clear();
 
-  if(m_InputFile && m_LoadRawFunction) {
+  // After an identify from the index jpeg and ppm thumbnails are read right
+  // away, the other writers need the full identify.
+  if (m_IdentifiedFromIndex && m_IsRaw) {
+    if (!m_WriteThumb) {
+      Identify();
+    } else if (!m_InputFile && (m_InputFile = fopen (m_UserSetting_InputFileName, "rb"))) {
+      MapInput();
+    }
+  }
+
+  if(m_InputFile && (m_LoadRawFunction || m_IdentifiedFromIndex)) {
     fseek (m_InputFile, m_ThumbOffset, SEEK_SET);
     (this->*m_WriteThumb)();
   }
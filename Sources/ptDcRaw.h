@@ -43,6 +43,7 @@
 #include "ptDefines.h"
 
 #include <QString>
+#include <QByteArray>
 
 #define _USE_MATH_DEFINES
 #include <vector>
@@ -287,7 +288,10 @@ public:
 
   // Identify the input file, the camera parameters etc.
   // See further for stuff that can be read afterwards.
-  short  Identify(const QString NewInputFile = "");
+  // With UseIndex the result may come from the ptRawIndex without parsing
+  // the file. The identification members and thumbnail() are then available
+  // as usual, RunDcRaw_Phase1() does the full identify itself.
+  short  Identify(const QString NewInputFile = "", const short UseIndex = 0);
 
   // Do the raw processing up to the image available.
   short  RunDcRaw_Phase1(); //Load,bad pxs,darkframe.
@@ -311,6 +315,7 @@ public:
   void  ptRebuildHighlights(const short Effort);
   void  ptBlendHighlights();
   void  ptCrop();
+  void  ptExpandCfa();
   TImage8RawData thumbnail();
 
 
@@ -327,6 +332,12 @@ public:
   // The image !
   uint16_t    (*m_Image)[4];
   uint16_t    (*m_Image_AfterPhase1)[4];  // Cached one.
+  // Bayer files keep one value per photosite from loading up to the
+  // interpolation in Phase2, which expands them into m_Image (ptExpandCfa).
+  // Then m_Image_AfterPhase1 is NULL and m_CfaImage_AfterPhase1 is the cache.
+  // m_CfaImage is the working buffer until the expansion.
+  uint16_t    *m_CfaImage;
+  uint16_t    *m_CfaImage_AfterPhase1;
   uint16_t    (*m_Image_AfterPhase2)[4];  // Cached one.
   uint16_t    (*m_Image_AfterPhase3)[4];  // Cached one.
   uint16_t    (*m_Image_AfterPhase4)[4];  // Cached one.
@@ -430,6 +441,15 @@ public:
   char      m_ColorDescriptor[5];
   short     m_ByteOrder;  // 0x4949 ("II") means little-endian.
   FILE*     m_InputFile;
+  // Memory mapping of the raw file, see MapInput(). The stdio calls in ptDcRaw.cpp
+  // read from m_InputMap while they get the stream in m_MappedFile.
+  FILE*           m_MappedFile;
+  const uint8_t*  m_InputMap;
+  INT64           m_InputMapSize;
+  INT64           m_InputMapPos;
+  int             m_InputMapEof;
+  // Set while the identification comes from the ptRawIndex, see Identify().
+  short     m_IdentifiedFromIndex;
   FILE*     m_OutputFile;
   char*     m_MetaData;
   unsigned  m_ThumbMisc;
@@ -508,6 +528,17 @@ public:
   unsigned    m_getbithuff_bitbuf;
   int         m_getbithuff_reset;
   int         m_getbithuff_vbits;
+  // Bit reader with its own position in the mapped input, so that independent
+  // tiles or segments of a file can be decoded at the same time. The members
+  // above are the one of the serial decoders.
+  struct TBitReader {
+    INT64     Pos;
+    unsigned  BitBuf;
+    int       VBits;
+    int       Reset;
+    int       Eof;
+    unsigned  ZeroAfterFF;
+  };
   uint64_t    m_ph1_bithuffbitbuf;
   int         m_ph1_bithuffvbits;
   uint8_t     m_pana_bits_buf[0x4000];
@@ -675,9 +706,9 @@ public:
   void  adobe_copy_pixel(unsigned row, unsigned col, uint16_t **rp);
   void  canon_sraw_load_raw();
   void  lossless_jpeg_load_raw();
-  uint16_t * ljpeg_row(int jrow,struct jhead *jh);
+  uint16_t * ljpeg_row(int jrow,struct jhead *jh,TBitReader *r = NULL);
   void  ljpeg_end (struct jhead *jh);
-  int   ljpeg_diff (uint16_t *huff);
+  int   ljpeg_diff (uint16_t *huff,TBitReader *r = NULL);
   int   ljpeg_start(struct jhead *jh,int info_only);
   void  canon_compressed_load_raw();
   int   canon_has_lowbits();
@@ -687,6 +718,19 @@ public:
   unsigned  getbits(int nbits);
   void  canon_a5_load_raw();
   unsigned getbithuff(int nbits,uint16_t *huff);
+  unsigned getbithuff(TBitReader &r,int nbits,uint16_t *huff);
+  void  MapInput();
+  void  UnmapInput();
+  QByteArray IndexRecord();
+  short FromIndexRecord(const QByteArray &Record);
+  int   InGetc(FILE* f);
+  size_t InRead(void* ptr, size_t size, size_t n, FILE* f);
+  int   InSeek(FILE* f, long offset, int whence);
+  long  InTell(FILE* f);
+  int   InEof(FILE* f);
+  char* InGets(char* str, int num, FILE* f);
+  FILE* InStdio(FILE* f);
+  void  InStdioDone(FILE* f);
   int   canon_s2is();
   void  remove_zeroes();
   void  canon_600_load_raw();
@@ -97,7 +97,9 @@ namespace pt {
 
 typedef std::array<uint16_t, 3> TPixel16;
 typedef std::array<uint8_t,  4> TPixel8;
+typedef std::array<float,    3> TPixelF;
 typedef std::vector<TPixel16>   TImage16Data;
+typedef std::vector<TPixelF>    TImageFData;
 typedef std::vector<TPixel8>    TImage8Data;
 typedef std::vector<uint8_t>    TImage8RawData;
 using TChannelMatrix = TMatrix<float,3,3>;
@@ -154,6 +156,7 @@ inline const T &ptBound(const T &min, const T &val, const T &max)
   #define CALLOC2(Num,Size) ptCalloc(Num,Size,__FILE__,__LINE__,NULL)
   #define MALLOC(Size)      ptCalloc(1,Size,__FILE__,__LINE__,this)
   #define MALLOC2(Size)     ptCalloc(1,Size,__FILE__,__LINE__,NULL)
+  #define REALLOC(x,Size)   ptRealloc(x,Size,__FILE__,__LINE__,this)
   #define FREE(x)           {ptFree(x,__FILE__,__LINE__,this); x=NULL;}
   #define FREE2(x)          {ptFree(x,__FILE__,__LINE__,NULL); x=NULL;}
   #define ALLOCATED(x)      ptAllocated(x,__FILE__,__LINE__)
@@ -164,6 +167,7 @@ inline const T &ptBound(const T &min, const T &val, const T &max)
   #define CALLOC2(Num,Size) ptCalloc_Ex(Num,Size)
   #define MALLOC(Size) malloc(Size)
   #define MALLOC2(Size) malloc(Size)
+  #define REALLOC(x,Size) ptRealloc_Ex(x,Size)
   // Remark free(NULL) is valid nop !
   #define FREE(x) {free(x); x=NULL; }
   #define FREE2(x) {free(x); x=NULL; }
@@ -24,6 +24,7 @@
 #include "ptDcRaw.h"
 
 #include "ptCalloc.h"
+#include "ptCmsTransformCache.h"
 #include "ptConstants.h"
 #include "ptError.h"
 #include "ptInfo.h"
@@ -32,6 +33,7 @@
 #include "ptResizeFilters.h"
 #include "ptCurve.h"
 #include "ptKernel.h"
+#include "ptLabKernels.h"
 #include "ptConstants.h"
 #include "ptRefocusMatrix.h"
 #include "ptCimg.h"
@@ -47,6 +49,7 @@
 // std stuff needs to be declared apparently for jpeglib
 // which seems a bug in the jpeglib header ?
 #include <cstdlib>
+#include <mm_malloc.h>
 #include <cstdio>
 
 #include <functional>
@@ -79,6 +82,7 @@ extern cmsCIExyY       D50;
 
 extern cmsHPROFILE PreviewColorProfile;
 extern cmsHTRANSFORM ToPreviewTransform;
+extern ptCmsLut      ToPreviewLut;
 
 // Lut
 extern float    ToFloatTable[0x10000];
@@ -116,6 +120,63 @@ inline float ToHue(const float ADiffA, const float ADiffB) {
 
 //==============================================================================
 
+// Pixels per call of the polar kernels in the hue filters below.
+const int32_t CPolarChunk = 0x1000;
+
+// Runs AFunc(Index, Chroma, Hue) over Lab pixels, chroma and hue taken around
+// ANeutral with the vectorised kernels (hue in [0,2pi), 0 for grey). With
+// AWriteBack the possibly changed chroma and hue go back into a and b.
+template <typename TFunc>
+inline void ForEachPolar(uint16_t (*AImage)[3],
+                         const int32_t ASize,
+                         const float   ANeutral,
+                         const bool    AWriteBack,
+                         TFunc         AFunc)
+{
+#pragma omp parallel
+  {
+    std::vector<float> hChroma(CPolarChunk);
+    std::vector<float> hHue(CPolarChunk);
+#pragma omp for schedule(static)
+    for (int32_t i = 0; i < ASize; i += CPolarChunk) {
+      const int32_t hCount = qMin(CPolarChunk, ASize - i);
+      ptLabKernels::labToPolar(&AImage[i], hCount, ANeutral, hChroma.data(), hHue.data());
+      for (int32_t k = 0; k < hCount; k++)
+        AFunc(i + k, hChroma[k], hHue[k]);
+      if (AWriteBack)
+        ptLabKernels::polarToLab(&AImage[i], hCount, ANeutral, hChroma.data(), hHue.data());
+    }
+  }
+}
+
+// Hue after a shift, back in [0,2pi) for the LCh planes.
+inline float WrapHue(const float AHue) {
+  float hHue = fmodf(AHue, pt2PI);
+  if (hHue < 0.0f) hHue += pt2PI;
+  return hHue;
+}
+
+//==============================================================================
+
+// Calls AApply(Weighted) for the eight hue sectors of LumaAdjust() and SatAdjust()
+// that contain AHue, in order, red again above 7/4 pi. Weighted is the sector's
+// adjustment times 1 at its center falling to 0 at the neighbouring centers.
+template <typename TFunc>
+inline void ForHueSectors(const double AAdjust[8], const float AHue, TFunc AApply) {
+  const float IQPI = 4/ptPI;
+  for (int s = 0; s <= 8; s++) {
+    const double Adjust = AAdjust[s & 7];
+    if (Adjust == 0) continue;
+    const float Center = s*ptPI/4;
+    const float Low    = s == 0 ? -0.1f      : Center - ptPI/4;
+    const float High   = s == 8 ? ptPI*2.1f  : Center + ptPI/4;
+    if (AHue > Low && AHue < High)
+      AApply((1.0f - fabsf(AHue - Center)*IQPI)*Adjust);
+  }
+}
+
+//==============================================================================
+
 inline uint16_t Sigmoidal_4_Value(const uint16_t AValue, const float APosContrast) {
   float hContrastHalfExp = exp(0.5f*APosContrast);
   float hOffset          = -1.0f/(1.0f + hContrastHalfExp);
@@ -220,84 +281,24 @@ ptImage* ptImage::lcmsRGBToRGB(const short To,
 
   if ((m_ColorSpace == To) && !EvenIfEqual) return this;
 
-  cmsToneCurve* Gamma = cmsBuildGamma(NULL, 1.0);
-  cmsToneCurve* Gamma3[3];
-  Gamma3[0] = Gamma3[1] = Gamma3[2] = Gamma;
-
-  cmsHPROFILE InProfile = 0;
-
-  cmsCIExyY       DFromReference;
-
-  switch (m_ColorSpace) {
-    case ptSpace_sRGB_D65 :
-    case ptSpace_AdobeRGB_D65 :
-      DFromReference = D65;
-      break;
-    case ptSpace_WideGamutRGB_D50 :
-    case ptSpace_ProPhotoRGB_D50 :
-      DFromReference = D50;
-      break;
-    default:
-      assert(0);
-  }
-
-  InProfile = cmsCreateRGBProfile(&DFromReference,
-                                  (cmsCIExyYTRIPLE*)&RGBPrimaries[m_ColorSpace],
-                                  Gamma3);
-
-  if (!InProfile) {
-    ptLogError(ptError_Profile,"Could not open InProfile profile.");
-    return NULL;
-  }
-
-  cmsHPROFILE OutProfile = 0;
-
-  cmsCIExyY       DToReference;
-
-  switch (To) {
-    case ptSpace_sRGB_D65 :
-    case ptSpace_AdobeRGB_D65 :
-      DToReference = D65;
-      break;
-    case ptSpace_WideGamutRGB_D50 :
-    case ptSpace_ProPhotoRGB_D50 :
-      DToReference = D50;
-      break;
-    default:
-      assert(0);
-  }
-
-  OutProfile = cmsCreateRGBProfile(&DToReference,
-                                   (cmsCIExyYTRIPLE*)&RGBPrimaries[To],
-                                   Gamma3);
-
-  if (!OutProfile) {
-    ptLogError(ptError_Profile,"Could not open OutProfile profile.");
-    cmsCloseProfile (InProfile);
+  ptCmsTransform Transform =
+    ptCmsTransformCache::instance()->get(ptCmsEnd::workspace(m_ColorSpace), TYPE_RGB_16,
+                                         ptCmsEnd::workspace(To), TYPE_RGB_16,
+                                         Intent,
+                                         cmsFLAGS_NOOPTIMIZE | cmsFLAGS_BLACKPOINTCOMPENSATION);
+  if (!Transform) {
+    ptLogError(ptError_Profile,"Could not create colour transform.");
     return NULL;
   }
 
-  cmsFreeToneCurve(Gamma);
-
-  cmsHTRANSFORM Transform;
-  Transform = cmsCreateTransform(InProfile,
-                                 TYPE_RGB_16,
-                                 OutProfile,
-                                 TYPE_RGB_16,
-                                 Intent,
-                                 cmsFLAGS_NOOPTIMIZE | cmsFLAGS_BLACKPOINTCOMPENSATION);
-
   int32_t Size = m_Width*m_Height;
   int32_t Step = 100000;
 #pragma omp parallel for schedule(static)
   for (int32_t i = 0; i < Size; i+=Step) {
     int32_t Length = (i+Step)<Size ? Step : Size - i;
     uint16_t* Tile = &(m_Image[i][0]);
-    cmsDoTransform(Transform,Tile,Tile,Length);
+    cmsDoTransform(Transform.get(),Tile,Tile,Length);
   }
-  cmsDeleteTransform(Transform);
-  cmsCloseProfile(OutProfile);
-  cmsCloseProfile(InProfile);
 
   m_ColorSpace = To;
 
@@ -325,69 +326,47 @@ ptImage* ptImage::lcmsRGBToRGB(cmsHPROFILE OutProfile,
   assert (3 == m_Colors);
   assert (OutProfile);
 
-  cmsToneCurve* Gamma = cmsBuildGamma(NULL, 1.0);
-  cmsToneCurve* Gamma3[3];
-  Gamma3[0] = Gamma3[1] = Gamma3[2] = Gamma;
-
-  cmsHPROFILE InProfile = 0;
-
-  cmsCIExyY DFromReference;
+  int32_t Size = m_Width*m_Height;
+  int32_t Step = 10000;
 
-  switch (m_ColorSpace) {
-    case ptSpace_sRGB_D65 :
-    case ptSpace_AdobeRGB_D65 :
-      DFromReference = D65;
-      break;
-    case ptSpace_WideGamutRGB_D50 :
-    case ptSpace_ProPhotoRGB_D50 :
-      DFromReference = D50;
-      break;
-    default:
-      assert(0);
+  // Apart from "no optimization" the transform is baked into a lookup table,
+  // which makes the conversion of large images a plain memory bound pass.
+  if (Quality != ptCMQuality_NoOptimize) {
+    ptCmsLut Lut =
+      ptCmsTransformCache::instance()->lut(ptCmsEnd::workspace(m_ColorSpace),
+                                           ptCmsEnd::profile(OutProfile),
+                                           Intent,
+                                           cmsFLAGS_NOOPTIMIZE | cmsFLAGS_BLACKPOINTCOMPENSATION);
+    if (!Lut) {
+      ptLogError(ptError_Profile,"Could not create colour transform.");
+      return NULL;
+    }
+#pragma omp parallel for schedule(static)
+    for (int32_t i = 0; i < Size; i+=Step) {
+      int32_t Length = (i+Step)<Size ? Step : Size - i;
+      Lut->apply(&m_Image[i],Length);
+    }
+    m_ColorSpace = ptSpace_Profiled;
+    return this;
   }
 
-  InProfile = cmsCreateRGBProfile(&DFromReference,
-                                  (cmsCIExyYTRIPLE*)&RGBPrimaries[m_ColorSpace],
-                                  Gamma3);
-
-  if (!InProfile) {
-    ptLogError(ptError_Profile,"Could not open InProfile profile.");
+  ptCmsTransform Transform =
+    ptCmsTransformCache::instance()->get(ptCmsEnd::workspace(m_ColorSpace), TYPE_RGB_16,
+                                         ptCmsEnd::profile(OutProfile), TYPE_RGB_16,
+                                         Intent,
+                                         cmsFLAGS_NOOPTIMIZE | cmsFLAGS_BLACKPOINTCOMPENSATION);
+  if (!Transform) {
+    ptLogError(ptError_Profile,"Could not create colour transform.");
     return NULL;
   }
 
-  cmsFreeToneCurve(Gamma);
-
-  cmsHTRANSFORM Transform;
-  if (Quality == ptCMQuality_HighResPreCalc) {
-    Transform =
-      cmsCreateTransform(InProfile,
-                         TYPE_RGB_16,
-                         OutProfile,
-                         TYPE_RGB_16,
-                         Intent,
-                         cmsFLAGS_HIGHRESPRECALC | cmsFLAGS_BLACKPOINTCOMPENSATION);
-  } else { // fast sRGB preview also uses the not optimized profile for output
-    Transform =
-      cmsCreateTransform(InProfile,
-                         TYPE_RGB_16,
-                         OutProfile,
-                         TYPE_RGB_16,
-                         Intent,
-                         cmsFLAGS_NOOPTIMIZE | cmsFLAGS_BLACKPOINTCOMPENSATION);
-  }
-
-  int32_t Size = m_Width*m_Height;
-  int32_t Step = 10000;
 #pragma omp parallel for schedule(static)
   for (int32_t i = 0; i < Size; i+=Step) {
     int32_t Length = (i+Step)<Size ? Step : Size - i;
     uint16_t* Image = &m_Image[i][0];
-    cmsDoTransform(Transform,Image,Image,Length);
+    cmsDoTransform(Transform.get(),Image,Image,Length);
   }
 
-  cmsDeleteTransform(Transform);
-  cmsCloseProfile(InProfile);
-
   m_ColorSpace = ptSpace_Profiled;
 
   return this;
@@ -416,8 +395,12 @@ ptImage* ptImage::lcmsRGBToPreviewRGB(const bool Fast /* = false */){
   #pragma omp parallel for schedule(static)
     for (int32_t i = 0; i < Size; i+=Step) {
       int32_t Length = (i+Step)<Size ? Step : Size - i;
-      uint16_t* Image = &m_Image[i][0];
-      cmsDoTransform(ToPreviewTransform,Image,Image,Length);
+      if (ToPreviewLut) {
+        ToPreviewLut->apply(&m_Image[i],Length);
+      } else {
+        uint16_t* Image = &m_Image[i][0];
+        cmsDoTransform(ToPreviewTransform,Image,Image,Length);
+      }
     }
   }
   m_ColorSpace = ptSpace_Profiled;
@@ -467,67 +450,24 @@ ptImage* ptImage::lcmsRGBToXYZ(const int Intent) {
 
   assert ((m_ColorSpace>0) && (m_ColorSpace<5));
 
-  cmsToneCurve* Gamma = cmsBuildGamma(NULL, 1.0);
-  cmsToneCurve* Gamma3[3];
-  Gamma3[0] = Gamma3[1] = Gamma3[2] = Gamma;
-
-  cmsHPROFILE InProfile = 0;
-
-  cmsCIExyY       DFromReference;
-
-  switch (m_ColorSpace) {
-    case ptSpace_sRGB_D65 :
-    case ptSpace_AdobeRGB_D65 :
-      DFromReference = D65;
-      break;
-    case ptSpace_WideGamutRGB_D50 :
-    case ptSpace_ProPhotoRGB_D50 :
-      DFromReference = D50;
-      break;
-    default:
-      assert(0);
-  }
-
-  InProfile = cmsCreateRGBProfile(&DFromReference,
-                                  (cmsCIExyYTRIPLE*)&RGBPrimaries[m_ColorSpace],
-                                  Gamma3);
-
-  if (!InProfile) {
-    ptLogError(ptError_Profile,"Could not open InProfile profile.");
-    return NULL;
-  }
-
-  cmsHPROFILE OutProfile = 0;
-
-  OutProfile = cmsCreateXYZProfile();
-
-  if (!OutProfile) {
-    ptLogError(ptError_Profile,"Could not open OutProfile profile.");
-    cmsCloseProfile (InProfile);
+  ptCmsTransform Transform =
+    ptCmsTransformCache::instance()->get(ptCmsEnd::workspace(m_ColorSpace), TYPE_RGB_16,
+                                         ptCmsEnd::xyz(), TYPE_XYZ_16,
+                                         Intent,
+                                         cmsFLAGS_NOOPTIMIZE | cmsFLAGS_BLACKPOINTCOMPENSATION);
+  if (!Transform) {
+    ptLogError(ptError_Profile,"Could not create colour transform.");
     return NULL;
   }
 
-  cmsFreeToneCurve(Gamma);
-
-  cmsHTRANSFORM Transform;
-  Transform = cmsCreateTransform(InProfile,
-                                 TYPE_RGB_16,
-                           OutProfile,
-                                 TYPE_XYZ_16,
-                                 Intent,
-                                 cmsFLAGS_NOOPTIMIZE | cmsFLAGS_BLACKPOINTCOMPENSATION);
-
   int32_t Size = m_Width*m_Height;
   int32_t Step = 100000;
 #pragma omp parallel for schedule(static)
   for (int32_t i = 0; i < Size; i+=Step) {
     int32_t Length = (i+Step)<Size ? Step : Size - i;
     uint16_t* Tile = &(m_Image[i][0]);
-    cmsDoTransform(Transform,Tile,Tile,Length);
+    cmsDoTransform(Transform.get(),Tile,Tile,Length);
   }
-  cmsDeleteTransform(Transform);
-  cmsCloseProfile(OutProfile);
-  cmsCloseProfile(InProfile);
 
   m_ColorSpace = ptSpace_XYZ;
 
@@ -580,66 +520,24 @@ ptImage* ptImage::lcmsXYZToRGB(const short To,
   assert ((To>0) && (To<5));
   assert (m_ColorSpace = ptSpace_XYZ);
 
-  cmsToneCurve* Gamma = cmsBuildGamma(NULL, 1.0);
-  cmsToneCurve* Gamma3[3];
-  Gamma3[0] = Gamma3[1] = Gamma3[2] = Gamma;
-
-  cmsHPROFILE InProfile = 0;
-
-  InProfile = cmsCreateXYZProfile();
-
-  if (!InProfile) {
-    ptLogError(ptError_Profile,"Could not open InProfile profile.");
-    return NULL;
-  }
-
-  cmsHPROFILE OutProfile = 0;
-
-  cmsCIExyY       DToReference;
-
-  switch (To) {
-    case ptSpace_sRGB_D65 :
-    case ptSpace_AdobeRGB_D65 :
-      DToReference = D65;
-      break;
-    case ptSpace_WideGamutRGB_D50 :
-    case ptSpace_ProPhotoRGB_D50 :
-      DToReference = D50;
-      break;
-    default:
-      assert(0);
-  }
-
-  OutProfile = cmsCreateRGBProfile(&DToReference,
-                                   (cmsCIExyYTRIPLE*)&RGBPrimaries[To],
-                                   Gamma3);
-  if (!OutProfile) {
-    ptLogError(ptError_Profile,"Could not open OutProfile profile.");
-    cmsCloseProfile (InProfile);
+  ptCmsTransform Transform =
+    ptCmsTransformCache::instance()->get(ptCmsEnd::xyz(), TYPE_XYZ_16,
+                                         ptCmsEnd::workspace(To), TYPE_RGB_16,
+                                         Intent,
+                                         cmsFLAGS_NOOPTIMIZE | cmsFLAGS_BLACKPOINTCOMPENSATION);
+  if (!Transform) {
+    ptLogError(ptError_Profile,"Could not create colour transform.");
     return NULL;
   }
 
-  cmsFreeToneCurve(Gamma);
-
-  cmsHTRANSFORM Transform;
-  Transform = cmsCreateTransform(InProfile,
-                                 TYPE_XYZ_16,
-                           OutProfile,
-                                 TYPE_RGB_16,
-                                 Intent,
-                                 cmsFLAGS_NOOPTIMIZE | cmsFLAGS_BLACKPOINTCOMPENSATION);
-
   int32_t Size = m_Width*m_Height;
   int32_t Step = 100000;
 #pragma omp parallel for schedule(static)
   for (int32_t i = 0; i < Size; i+=Step) {
     int32_t Length = (i+Step)<Size ? Step : Size - i;
     uint16_t* Tile = &(m_Image[i][0]);
-    cmsDoTransform(Transform,Tile,Tile,Length);
+    cmsDoTransform(Transform.get(),Tile,Tile,Length);
   }
-  cmsDeleteTransform(Transform);
-  cmsCloseProfile(OutProfile);
-  cmsCloseProfile(InProfile);
 
   m_ColorSpace = To;
 
@@ -653,11 +551,6 @@ ptImage* ptImage::lcmsXYZToRGB(const short To,
 //
 ////////////////////////////////////////////////////////////////////////////////
 
-// A lookup table used for this purpose.
-// Initialized at the first call.
-static double ToLABFunctionTable[0x20000];
-static short  ToLABFunctionInited = 0;
-
 ptImage* ptImage::RGBToLab() {
 
   if (m_ColorSpace == ptSpace_Lab) return this;
@@ -682,35 +575,18 @@ ptImage* ptImage::RGBToLab() {
       assert(0);
   }
 
-  // First go to XYZ
-  double xyz[3];
-#pragma omp parallel for private(xyz)
-  for (uint32_t i=0; i < (uint32_t)m_Width*m_Height; i++) {
-    xyz[0] = MatrixRGBToXYZ[m_ColorSpace][0][0] * m_Image[i][0] +
-             MatrixRGBToXYZ[m_ColorSpace][0][1] * m_Image[i][1] +
-             MatrixRGBToXYZ[m_ColorSpace][0][2] * m_Image[i][2] ;
-    xyz[1] = MatrixRGBToXYZ[m_ColorSpace][1][0] * m_Image[i][0] +
-             MatrixRGBToXYZ[m_ColorSpace][1][1] * m_Image[i][1] +
-             MatrixRGBToXYZ[m_ColorSpace][1][2] * m_Image[i][2] ;
-    xyz[2] = MatrixRGBToXYZ[m_ColorSpace][2][0] * m_Image[i][0] +
-             MatrixRGBToXYZ[m_ColorSpace][2][1] * m_Image[i][1] +
-             MatrixRGBToXYZ[m_ColorSpace][2][2] * m_Image[i][2] ;
-
-    // Reference White
-    xyz[0] /= DReference[0];
-    xyz[1] /= DReference[1];
-    xyz[2] /= DReference[2];
-
-    // Then to Lab
-    xyz[0] = ToLABFunctionTable[ (int32_t) MAX(0.0,xyz[0]+0.5) ];
-    xyz[1] = ToLABFunctionTable[ (int32_t) MAX(0.0,xyz[1]+0.5) ];
-    xyz[2] = ToLABFunctionTable[ (int32_t) MAX(0.0,xyz[2]+0.5) ];
-
-    // L in 0 , a in 1, b in 2
-    m_Image[i][0] = CLIP((int32_t) (0xffff*(116.0/100.0 * xyz[1] - 16.0/100.0)));
-    m_Image[i][1] = CLIP((int32_t) (0x101*(128.0+500.0*(xyz[0]-xyz[1]))));
-    m_Image[i][2] = CLIP((int32_t) (0x101*(128.0+200.0*(xyz[1]-xyz[2]))));
+  // RGB to XYZ relative to the reference white, in one matrix for the kernel.
+  float ToXyz[3][3];
+  for (short c=0; c<3; c++)
+    for (short k=0; k<3; k++)
+      ToXyz[c][k] = MatrixRGBToXYZ[m_ColorSpace][c][k]/(DReference[c]*ptWP);
 
+  int32_t Size = m_Width*m_Height;
+  int32_t Step = 0x10000;
+#pragma omp parallel for schedule(static)
+  for (int32_t i = 0; i < Size; i+=Step) {
+    int32_t Length = (i+Step)<Size ? Step : Size - i;
+    ptLabKernels::rgbToLab(&m_Image[i], Length, ToXyz);
   }
 
   // And that's it.
@@ -731,67 +607,24 @@ ptImage* ptImage::lcmsRGBToLab(const int Intent) {
   assert (3 == m_Colors);
   assert ((m_ColorSpace>0) && (m_ColorSpace<5));
 
-  cmsToneCurve* Gamma = cmsBuildGamma(NULL, 1.0);
-  cmsToneCurve* Gamma3[3];
-  Gamma3[0] = Gamma3[1] = Gamma3[2] = Gamma;
-
-  cmsHPROFILE InProfile = 0;
-
-  cmsCIExyY       DFromReference;
-
-  switch (m_ColorSpace) {
-    case ptSpace_sRGB_D65 :
-    case ptSpace_AdobeRGB_D65 :
-      DFromReference = D65;
-      break;
-    case ptSpace_WideGamutRGB_D50 :
-    case ptSpace_ProPhotoRGB_D50 :
-      DFromReference = D50;
-      break;
-    default:
-      assert(0);
-  }
-
-  InProfile = cmsCreateRGBProfile(&DFromReference,
-                                  (cmsCIExyYTRIPLE*)&RGBPrimaries[m_ColorSpace],
-                                  Gamma3);
-
-  if (!InProfile) {
-    ptLogError(ptError_Profile,"Could not open InProfile profile.");
+  ptCmsTransform Transform =
+    ptCmsTransformCache::instance()->get(ptCmsEnd::workspace(m_ColorSpace), TYPE_RGB_16,
+                                         ptCmsEnd::lab(), TYPE_Lab_16,
+                                         Intent,
+                                         cmsFLAGS_NOOPTIMIZE | cmsFLAGS_BLACKPOINTCOMPENSATION);
+  if (!Transform) {
+    ptLogError(ptError_Profile,"Could not create colour transform.");
     return NULL;
   }
 
-  cmsHPROFILE OutProfile = 0;
-
-  OutProfile = cmsCreateLab4Profile(NULL);
-
-  if (!OutProfile) {
-    ptLogError(ptError_Profile,"Could not open OutProfile profile.");
-    cmsCloseProfile (InProfile);
-    return NULL;
-  }
-
-  cmsFreeToneCurve(Gamma);
-
-  cmsHTRANSFORM Transform;
-  Transform = cmsCreateTransform(InProfile,
-                                 TYPE_RGB_16,
-                                 OutProfile,
-                                 TYPE_Lab_16,
-                                 Intent,
-                                 cmsFLAGS_NOOPTIMIZE | cmsFLAGS_BLACKPOINTCOMPENSATION);
-
   int32_t Size = m_Width*m_Height;
   int32_t Step = 100000;
 #pragma omp parallel for schedule(static)
   for (int32_t i = 0; i < Size; i+=Step) {
     int32_t Length = (i+Step)<Size ? Step : Size - i;
     uint16_t* Tile = &(m_Image[i][0]);
-    cmsDoTransform(Transform,Tile,Tile,Length);
+    cmsDoTransform(Transform.get(),Tile,Tile,Length);
   }
-  cmsDeleteTransform(Transform);
-  cmsCloseProfile(OutProfile);
-  cmsCloseProfile(InProfile);
 
   // And that's it.
   m_ColorSpace = ptSpace_Lab;
@@ -836,51 +669,25 @@ ptImage* ptImage::LabToRGB(const short To) {
       assert(0);
   }
 
-  // This code has been tweaked with performance in mind.
-  // Probably some of it could be detected by compiler, but overall I
-  // still gain something like going from 167 to 35 clockticks.
-  // (especially avoiding the stupid pow(x,3.0) -> x*x*x !
-
-  double xyz[3];
-  double fx,fy,fz;
-  double xr,yr,zr;
-  const double epsilon = 216.0/24389.0;
-  const double kappa   = 24389.0/27.0;
-
-  const uint32_t NrPixels = m_Width*m_Height;
-#pragma omp parallel for private(xyz,fx,fy,fz,xr,yr,zr)
-  for (uint32_t i=0; i < NrPixels ; i++) {
-
-    const double L = ToFloatTable[m_Image[i][0]]*100.0;
-    const double a = (m_Image[i][1]-0x8080) /((double)0x8080/128.0) ;
-    const double b = (m_Image[i][2]-0x8080) /((double)0x8080/128.0) ;
-
-    const double Tmp1 = (L+16.0)/116.0;
-
-    yr = (L<=kappa*epsilon)?
-       (L/kappa):(Tmp1*Tmp1*Tmp1);
-    fy = (yr<=epsilon) ? ((kappa*yr+16.0)/116.0) : Tmp1;
-    fz = fy - b/200.0;
-    fx = a/500.0 + fy;
-    const double fz3 = fz*fz*fz;
-    const double fx3 = fx*fx*fx;
-    zr = (fz3<=epsilon) ? ((116.0*fz-16.0)/kappa) : fz3;
-    xr = (fx3<=epsilon) ? ((116.0*fx-16.0)/kappa) : fx3;
-
-    xyz[0] = xr*DReference[0]*65535.0 - 0.5;
-    xyz[1] = yr*DReference[1]*65535.0 - 0.5;
-    xyz[2] = zr*DReference[2]*65535.0 - 0.5;
-
-    // And finally to RGB via the matrix.
-    for (short c=0; c<3; c++) {
-      double Value = 0;
-      Value += MatrixXYZToRGB[To][c][0] * xyz[0];
-      Value += MatrixXYZToRGB[To][c][1] * xyz[1];
-      Value += MatrixXYZToRGB[To][c][2] * xyz[2];
-      m_Image[i][c] = (uint16_t) CLIP((int32_t)(Value));
+  // Reference white and 16 bit scale folded into the XYZ->RGB matrix.
+  float ToRgb[3][3];
+  float Offset[3];
+  for (short c=0; c<3; c++) {
+    Offset[c] = 0.0f;
+    for (short k=0; k<3; k++) {
+      ToRgb[c][k] = MatrixXYZToRGB[To][c][k]*DReference[k]*ptWP;
+      Offset[c]  -= 0.5f*MatrixXYZToRGB[To][c][k];
     }
   }
 
+  int32_t Size = m_Width*m_Height;
+  int32_t Step = 0x10000;
+#pragma omp parallel for schedule(static)
+  for (int32_t i = 0; i < Size; i+=Step) {
+    int32_t Length = (i+Step)<Size ? Step : Size - i;
+    ptLabKernels::labToRgb(&m_Image[i], Length, ToRgb, Offset);
+  }
+
   // And that's it.
 
   m_ColorSpace = To;
@@ -902,67 +709,24 @@ ptImage* ptImage::lcmsLabToRGB(const short To,
   assert ((To>0) && (To<5));
   assert (m_ColorSpace == ptSpace_Lab);
 
-  cmsToneCurve* Gamma = cmsBuildGamma(NULL, 1.0);
-  cmsToneCurve* Gamma3[3];
-  Gamma3[0] = Gamma3[1] = Gamma3[2] = Gamma;
-
-  cmsHPROFILE InProfile = 0;
-
-  InProfile = cmsCreateLab4Profile(NULL);
-
-  if (!InProfile) {
-    ptLogError(ptError_Profile,"Could not open InProfile profile.");
-    return NULL;
-  }
-
-  cmsHPROFILE OutProfile = 0;
-
-  cmsCIExyY       DToReference;
-
-  switch (To) {
-    case ptSpace_sRGB_D65 :
-    case ptSpace_AdobeRGB_D65 :
-      DToReference = D65;
-      break;
-    case ptSpace_WideGamutRGB_D50 :
-    case ptSpace_ProPhotoRGB_D50 :
-      DToReference = D50;
-      break;
-    default:
-      assert(0);
-  }
-
-  OutProfile = cmsCreateRGBProfile(&DToReference,
-                                   (cmsCIExyYTRIPLE*)&RGBPrimaries[To],
-                                   Gamma3);
-
-  if (!OutProfile) {
-    ptLogError(ptError_Profile,"Could not open OutProfile profile.");
-    cmsCloseProfile (InProfile);
+  ptCmsTransform Transform =
+    ptCmsTransformCache::instance()->get(ptCmsEnd::lab(), TYPE_Lab_16,
+                                         ptCmsEnd::workspace(To), TYPE_RGB_16,
+                                         Intent,
+                                         cmsFLAGS_NOOPTIMIZE | cmsFLAGS_BLACKPOINTCOMPENSATION);
+  if (!Transform) {
+    ptLogError(ptError_Profile,"Could not create colour transform.");
     return NULL;
   }
 
-  cmsFreeToneCurve(Gamma);
-
-  cmsHTRANSFORM Transform;
-  Transform = cmsCreateTransform(InProfile,
-                                 TYPE_Lab_16,
-                                 OutProfile,
-                                 TYPE_RGB_16,
-                                 Intent,
-                                 cmsFLAGS_NOOPTIMIZE | cmsFLAGS_BLACKPOINTCOMPENSATION);
-
   int32_t Size = m_Width*m_Height;
   int32_t Step = 100000;
 #pragma omp parallel for schedule(static)
   for (int32_t i = 0; i < Size; i+=Step) {
     int32_t Length = (i+Step)<Size ? Step : Size - i;
     uint16_t* Tile = &(m_Image[i][0]);
-    cmsDoTransform(Transform,Tile,Tile,Length);
+    cmsDoTransform(Transform.get(),Tile,Tile,Length);
   }
-  cmsDeleteTransform(Transform);
-  cmsCloseProfile(OutProfile);
-  cmsCloseProfile(InProfile);
 
   // And that's it.
 
@@ -1010,20 +774,18 @@ ptImage *ptImage::LabToLch()
   if (m_ColorSpace == ptSpace_LCH) return this;
 
   assert (m_ColorSpace == ptSpace_Lab);
+  toUInt16()->toInterleaved();
 
   uint32_t hSize = (uint32_t)m_Width*m_Height;
 
   ResizeLCH(hSize);
 
-  float hValueA = 0.0f;
-  float hValueB = 0.0f;
-#pragma omp parallel for schedule(static) private(hValueA, hValueB)
-  for (uint32_t i = 0; i < hSize; i++) {
-    hValueA        = ToFloatABNeutral[m_Image[i][1]];
-    hValueB        = ToFloatABNeutral[m_Image[i][2]];
-    m_ImageL.at(i) = m_Image[i][0];
-    m_ImageH.at(i) = ToHue(hValueA, hValueB);
-    m_ImageC.at(i) = powf(hValueA*hValueA + hValueB*hValueB, 0.5f);
+#pragma omp parallel for schedule(static)
+  for (uint32_t i = 0; i < hSize; i += CPolarChunk) {
+    const uint32_t hCount = qMin((uint32_t)CPolarChunk, hSize - i);
+    for (uint32_t k = i; k < i + hCount; k++)
+      m_ImageL[k] = m_Image[k][0];
+    ptLabKernels::labToPolar(&m_Image[i], hCount, ptWPHLab, &m_ImageC[i], &m_ImageH[i]);
   }
 
   setSize(0);
@@ -1035,6 +797,11 @@ ptImage *ptImage::LabToLch()
 
 ptImage *ptImage::toRGB()
 {
+  if (m_ColorSpace == ptSpace_LCH) LchToLab();
+
+  // The color space conversions only exist for interleaved 16 bit data.
+  if (m_ColorSpace == ptSpace_Lab || m_ColorSpace == ptSpace_XYZ) toUInt16()->toInterleaved();
+
   if      (m_ColorSpace == ptSpace_Lab)      LabToRGB(getCurrentRGB());
   else if (m_ColorSpace == ptSpace_XYZ)      XYZToRGB(getCurrentRGB());
   else if (m_ColorSpace == ptSpace_Profiled) GInfo->Raise("Cannot transform color space!");
@@ -1047,7 +814,10 @@ ptImage *ptImage::toRGB()
 ptImage *ptImage::toLab()
 {
   if      (m_ColorSpace == ptSpace_Lab)      return this;
-  else if (m_ColorSpace == ptSpace_XYZ)      XYZToRGB(getCurrentRGB());
+  else if (m_ColorSpace == ptSpace_LCH)      return LchToLab();
+
+  toUInt16()->toInterleaved();
+  if      (m_ColorSpace == ptSpace_XYZ)      XYZToRGB(getCurrentRGB());
   else if (m_ColorSpace == ptSpace_Profiled) GInfo->Raise("Cannot transform color space!");
 
   RGBToLab();
@@ -1067,10 +837,11 @@ ptImage *ptImage::LchToLab() {
   setSize((size_t)hSize);
 
 #pragma omp parallel for schedule(static)
-  for (uint32_t i = 0; i < hSize; i++) {
-    m_Image[i][0] = m_ImageL.at(i);
-    m_Image[i][1] = CLIP((int32_t)(cosf(m_ImageH.at(i))*m_ImageC.at(i) + ptWPHLab));
-    m_Image[i][2] = CLIP((int32_t)(sinf(m_ImageH.at(i))*m_ImageC.at(i) + ptWPHLab));
+  for (uint32_t i = 0; i < hSize; i += CPolarChunk) {
+    const uint32_t hCount = qMin((uint32_t)CPolarChunk, hSize - i);
+    for (uint32_t k = i; k < i + hCount; k++)
+      m_Image[k][0] = m_ImageL[k];
+    ptLabKernels::polarToLab(&m_Image[i], hCount, ptWPHLab, &m_ImageC[i], &m_ImageH[i]);
   }
 
   ResizeLCH(0);
@@ -1091,23 +862,10 @@ ptImage::ptImage() {
   m_Image              = nullptr;
   m_Colors             = 0;
   m_ColorSpace         = ptSpace_sRGB_D65;
-  m_Data.clear();
+  m_Data               = std::make_shared<TImage16Data>();
+  m_PlaneStride        = 0;
   ResizeLCH(0);
 
-  // Initialize the lookup table for the RGB->LAB function
-  // if this would be the first time.
-  if (!ToLABFunctionInited) {
-    // Remark : we extend the table well beyond r>1.0 for numerical
-    // stability purposes. XYZ>1.0 occurs sometimes and this way
-    // it stays stable (srgb->lab->srgb correct within 0.02%)
-#pragma omp parallel for
-    for (uint32_t i=0; i<0x20000; i++) {
-      double r = (double)(i) / ptWP;
-      ToLABFunctionTable[i] = r > 216.0/24389.0 ? pow(r,1/3.0) : (24389.0/27.0*r + 16.0)/116.0;
-    }
-  ToLABFunctionInited = 1;
-  }
-
   // Some lcsm initialization.
   //cmsErrorAction (LCMS_ERROR_SHOW);
   cmsWhitePointFromTemp(&D65, 6503);
@@ -1127,9 +885,177 @@ ptImage::~ptImage() {
 //==============================================================================
 
 void ptImage::setSize(size_t Size) {
-  m_Data.resize(Size);
-  m_Data.shrink_to_fit();
-  m_Image = (uint16_t (*)[3]) m_Data.data();
+  if (isShared()) {
+    // The old content is about to be overwritten anyway.
+    m_Data = std::make_shared<TImage16Data>(Size);
+  } else {
+    m_Data->resize(Size);
+    m_Data->shrink_to_fit();
+  }
+  m_Image = (uint16_t (*)[3]) m_Data->data();
+  TImageFData().swap(m_DataF);
+  m_Planes.reset();
+}
+
+// -----------------------------------------------------------------------------
+
+void ptImage::detach() {
+  if (!isShared()) return;
+
+  m_Data  = std::make_shared<TImage16Data>(*m_Data);
+  m_Image = (uint16_t (*)[3]) m_Data->data();
+}
+
+// -----------------------------------------------------------------------------
+
+ptImage* ptImage::toFloat() {
+  if (isFloat() || isNull()) return this;
+  toInterleaved();
+
+  const TImage16Data &Source = *m_Data;
+  m_DataF.resize(Source.size());
+#pragma omp parallel for
+  for (size_t i=0; i<Source.size(); i++) {
+    for (short c=0; c<3; c++) m_DataF[i][c] = ToFloatTable[Source[i][c]];
+  }
+
+  m_Data  = std::make_shared<TImage16Data>();
+  m_Image = nullptr;
+  return this;
+}
+
+// -----------------------------------------------------------------------------
+
+ptImage* ptImage::toUInt16() {
+  if (!isFloat()) return this;
+
+  auto Data = std::make_shared<TImage16Data>(m_DataF.size());
+#pragma omp parallel for
+  for (size_t i=0; i<m_DataF.size(); i++) {
+    for (short c=0; c<3; c++)
+      (*Data)[i][c] = CLIP((int32_t)(ptBound(-1.0f, m_DataF[i][c], 2.0f)*ptWPf));
+  }
+
+  m_Data  = Data;
+  m_Image = (uint16_t (*)[3]) m_Data->data();
+  TImageFData().swap(m_DataF);
+  return this;
+}
+
+// -----------------------------------------------------------------------------
+
+void ptImage::getChannel(const short Channel, float *Dest) const {
+  const size_t Size = size();
+  if (isFloat()) {
+#pragma omp parallel for
+    for (size_t i=0; i<Size; i++) Dest[i] = m_DataF[i][Channel];
+  } else if (isPlanar()) {
+#pragma omp parallel for
+    for (int32_t Row=0; Row<m_Height; Row++) {
+      const uint16_t *Plane = planeRow(Channel, Row);
+      float          *Out   = Dest + (size_t)Row*m_Width;
+      for (uint16_t Col=0; Col<m_Width; Col++) Out[Col] = ToFloatTable[Plane[Col]];
+    }
+  } else {
+#pragma omp parallel for
+    for (size_t i=0; i<Size; i++) Dest[i] = ToFloatTable[m_Image[i][Channel]];
+  }
+}
+
+// -----------------------------------------------------------------------------
+
+void ptImage::putChannel(const short Channel, const float *Source) {
+  const size_t Size = size();
+  if (isFloat()) {
+#pragma omp parallel for
+    for (size_t i=0; i<Size; i++) m_DataF[i][Channel] = Source[i];
+  } else if (isPlanar()) {
+#pragma omp parallel for
+    for (int32_t Row=0; Row<m_Height; Row++) {
+      uint16_t    *Plane = planeRow(Channel, Row);
+      const float *In    = Source + (size_t)Row*m_Width;
+      for (uint16_t Col=0; Col<m_Width; Col++) Plane[Col] = CLIP((int32_t)(In[Col]*ptWPf));
+    }
+  } else {
+#pragma omp parallel for
+    for (size_t i=0; i<Size; i++) m_Image[i][Channel] = CLIP((int32_t)(Source[i]*ptWPf));
+  }
+}
+
+// -----------------------------------------------------------------------------
+
+// Planes are handed to SIMD loops, so they get 32 byte alignment.
+static std::shared_ptr<uint16_t> AllocPlanes(const size_t Samples) {
+  uint16_t *Planes = (uint16_t*) _mm_malloc(Samples*sizeof(uint16_t), 32);
+  ptMemoryError(Planes,__FILE__,__LINE__);
+  return std::shared_ptr<uint16_t>(Planes, _mm_free);
+}
+
+// -----------------------------------------------------------------------------
+
+ptImage* ptImage::toPlanar() {
+  if (isPlanar() || isFloat() || isNull()) return this;
+
+  m_PlaneStride = (m_Width + 15) & ~15;
+  m_Planes      = AllocPlanes((size_t)3*m_Height*m_PlaneStride);
+
+#pragma omp parallel for
+  for (int32_t Row=0; Row<m_Height; Row++) {
+    const uint16_t (*Pixel)[3] = m_Image + (size_t)Row*m_Width;
+    uint16_t *P0 = planeRow(0, Row);
+    uint16_t *P1 = planeRow(1, Row);
+    uint16_t *P2 = planeRow(2, Row);
+    for (uint16_t Col=0; Col<m_Width; Col++) {
+      P0[Col] = Pixel[Col][0];
+      P1[Col] = Pixel[Col][1];
+      P2[Col] = Pixel[Col][2];
+    }
+  }
+
+  m_Data  = std::make_shared<TImage16Data>();
+  m_Image = nullptr;
+  return this;
+}
+
+// -----------------------------------------------------------------------------
+
+ptImage* ptImage::toInterleaved() {
+  if (!isPlanar()) return this;
+
+  auto Data = std::make_shared<TImage16Data>((size_t)m_Width*m_Height);
+#pragma omp parallel for
+  for (int32_t Row=0; Row<m_Height; Row++) {
+    TPixel16 *Pixel = Data->data() + (size_t)Row*m_Width;
+    const uint16_t *P0 = planeRow(0, Row);
+    const uint16_t *P1 = planeRow(1, Row);
+    const uint16_t *P2 = planeRow(2, Row);
+    for (uint16_t Col=0; Col<m_Width; Col++) {
+      Pixel[Col][0] = P0[Col];
+      Pixel[Col][1] = P1[Col];
+      Pixel[Col][2] = P2[Col];
+    }
+  }
+
+  m_Data  = Data;
+  m_Image = (uint16_t (*)[3]) m_Data->data();
+  m_Planes.reset();
+  return this;
+}
+
+// -----------------------------------------------------------------------------
+
+// Planes are never shared, so writing to them needs no detach().
+void ptImage::CopyPlanes(const ptImage *Origin) {
+  if (!Origin->isPlanar()) {
+    m_Planes.reset();
+    return;
+  }
+
+  const size_t Samples = (size_t)3*m_Height*Origin->m_PlaneStride;
+  m_PlaneStride = Origin->m_PlaneStride;
+  m_Planes      = AllocPlanes(Samples);
+  std::copy(Origin->m_Planes.get(), Origin->m_Planes.get() + Samples, m_Planes.get());
+  m_Image       = nullptr;
 }
 
 // -----------------------------------------------------------------------------
@@ -1371,7 +1297,7 @@ ptImage* ptImage::Set(const ptDcRaw*  DcRawObject,
       if (DcRawObject->m_Flip & 2) OriginRow = m_Height-1-OriginRow;
       if (DcRawObject->m_Flip & 1) OriginCol = m_Width-1-OriginCol;
       for (short c=0; c<3; c++) {
-        m_Data[TargetRow*TargetWidth+TargetCol][c] =
+        (*m_Data)[TargetRow*TargetWidth+TargetCol][c] =
           PreFlip[OriginRow*m_Width+OriginCol][c];
       }
     }
@@ -1442,7 +1368,7 @@ ptImage* ptImage::Set(const ptDcRaw*  DcRawObject,
       if (DcRawObject->m_Flip & 2) OriginRow = m_Height-1-OriginRow;
       if (DcRawObject->m_Flip & 1) OriginCol = m_Width-1-OriginCol;
       for (short c=0; c<3; c++) {
-        m_Data[TargetRow*TargetWidth+TargetCol][c] =
+        (*m_Data)[TargetRow*TargetWidth+TargetCol][c] =
           PreFlip[OriginRow*m_Width+OriginCol][c];
       }
     }
@@ -1490,7 +1416,33 @@ ptImage* ptImage::Set(const ptImage *Origin) { // Always deep
   m_Colors     = Origin->m_Colors;
   m_ColorSpace = Origin->m_ColorSpace;
   setSize((size_t)m_Width*m_Height);
+  *m_Data      = *Origin->m_Data;
+  m_DataF      = Origin->m_DataF;
+  if (isFloat()) m_Image = nullptr;
+  CopyPlanes(Origin);
+
+  return this;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// Share
+//
+////////////////////////////////////////////////////////////////////////////////
+
+ptImage* ptImage::Share(const ptImage *Origin) { // Shallow, see detach()
+
+  assert(NULL != Origin);
+
+  m_Width      = Origin->m_Width;
+  m_Height     = Origin->m_Height;
+  m_Colors     = Origin->m_Colors;
+  m_ColorSpace = Origin->m_ColorSpace;
   m_Data       = Origin->m_Data;
+  m_Image      = (uint16_t (*)[3]) m_Data->data();
+  m_DataF      = Origin->m_DataF;   // float and planar images are not shared
+  if (isFloat()) m_Image = nullptr;
+  CopyPlanes(Origin);
 
   return this;
 }
@@ -1513,7 +1465,7 @@ ptImage* ptImage::SetScaled(const ptImage *Origin,
 
   if (ScaleFactor == 0) {
     setSize((int32_t)m_Width*m_Height);
-    m_Data     = Origin->m_Data;
+    *m_Data    = *Origin->m_Data;
   } else {
     m_Width  >>= ScaleFactor;
     m_Height >>= ScaleFactor;
@@ -1532,12 +1484,12 @@ ptImage* ptImage::SetScaled(const ptImage *Origin,
           for (uint8_t sCol=0; sCol < Step; sCol++) {
             int32_t index = (Row*Step+sRow)*Origin->m_Width+Col*Step+sCol;
             for (short c=0; c < 3; c++) {
-              PixelValue[c] += Origin->m_Data[index][c];
+              PixelValue[c] += (*Origin->m_Data)[index][c];
             }
           }
         }
         for (short c=0; c < 3; c++) {
-          m_Data[Row*m_Width+Col][c]
+          (*m_Data)[Row*m_Width+Col][c]
             = (int32_t) (PixelValue[c] * InvAverage);
         }
       }
@@ -1718,7 +1670,7 @@ ptImage* ptImage::ApplyCurve(const ptCurve *Curve,
   if (ChannelMask & 1) Channel.push_back(0);
   if (ChannelMask & 2) Channel.push_back(1);
   if (ChannelMask & 4) Channel.push_back(2);
-  __gnu_parallel::for_each (m_Data.begin(), m_Data.end(), [&](TPixel16 &Pixel) {
+  __gnu_parallel::for_each (m_Data->begin(), m_Data->end(), [&](TPixel16 &Pixel) {
     std::for_each (Channel.begin(), Channel.end(), [&](const short &Value){
       Pixel[Value] = Curve->Curve[ Pixel[Value] ];
     });
@@ -1729,38 +1681,53 @@ ptImage* ptImage::ApplyCurve(const ptCurve *Curve,
 
 ////////////////////////////////////////////////////////////////////////////////
 //
-// Apply L by Hue Curve
+// Per channel lookup tables
 //
 ////////////////////////////////////////////////////////////////////////////////
 
-ptImage* ptImage::ApplyLByHueCurve(const ptCurve *Curve) {
+ptImage* ptImage::SetIdentityLut(const short ColorSpace) {
 
-// Best solution would be to use the Lab <-> Lch conversion from lcms.
-// This should be faster without sacrificing much quality.
+  m_Width      = 0x100;
+  m_Height     = 0x100;
+  m_Colors     = 3;
+  m_ColorSpace = ColorSpace;
+  setSize(0x10000);
 
-  assert (m_ColorSpace == ptSpace_Lab);
-  // neutral value for a* and b* channel
-  const float WPH = 0x8080;
+  for (uint32_t i=0; i<0x10000; i++) {
+    m_Image[i][0] = m_Image[i][1] = m_Image[i][2] = i;
+  }
 
-  __gnu_parallel::for_each (m_Data.begin(), m_Data.end(), [&](TPixel16 &Pixel) {
-    // Factor by hue
-    float ValueA = (float)Pixel[1]-WPH;
-    float ValueB = (float)Pixel[2]-WPH;
-    float Hue = 0;
-    if (ValueA == 0.0 && ValueB == 0.0) {
-      Hue = 0;   // value for grey pixel
-    } else {
-      Hue = atan2f(ValueB,ValueA);
-    }
-    while (Hue < 0) Hue += 2.*ptPI;
+  return this;
+}
 
-    float Factor = Curve->Curve[CLIP((int32_t)(Hue/ptPI*WPH))]/(float)0x7fff - 1.0f;
-    if (Factor != 0.0) {
-      float Col = powf(ValueA * ValueA + ValueB * ValueB, 0.25) / (float) 0xb5;
-      Factor = powf(2.0f, 3.0f*Factor*Col);
+ptImage* ptImage::ApplyLut(const ptImage *Lut) {
+
+  assert (m_Colors == 3);
+  assert (Lut->m_Width*Lut->m_Height == 0x10000);
+  assert ((m_ColorSpace == ptSpace_Lab) == (Lut->m_ColorSpace == ptSpace_Lab));
 
-      Pixel[0] = CLIP((int32_t)(Pixel[0] * Factor));
+  const uint16_t (*Table)[3] = Lut->m_Image;
+
+  if (isPlanar()) {
+    // Only touch the planes the table changes, e.g. just L for L curves.
+    for (short c=0; c<3; c++) {
+      uint32_t i = 0;
+      while (i<0x10000 && Table[i][c] == i) i++;
+      if (i == 0x10000) continue;
+
+#pragma omp parallel for schedule(static)
+      for (int32_t Row=0; Row<m_Height; Row++) {
+        uint16_t *Plane = planeRow(c, Row);
+        for (uint16_t Col=0; Col<m_Width; Col++) Plane[Col] = Table[ Plane[Col] ][c];
+      }
     }
+    return this;
+  }
+
+  __gnu_parallel::for_each (m_Data->begin(), m_Data->end(), [&](TPixel16 &Pixel) {
+    Pixel[0] = Table[ Pixel[0] ][0];
+    Pixel[1] = Table[ Pixel[1] ][1];
+    Pixel[2] = Table[ Pixel[2] ][2];
   });
 
   return this;
@@ -1768,64 +1735,75 @@ ptImage* ptImage::ApplyLByHueCurve(const ptCurve *Curve) {
 
 ////////////////////////////////////////////////////////////////////////////////
 //
-// Apply Hue Curve
+// Apply L by Hue Curve
 //
 ////////////////////////////////////////////////////////////////////////////////
 
-ptImage* ptImage::ApplyHueCurve(const ptCurve *Curve) {
+ptImage* ptImage::ApplyLByHueCurve(const ptCurve *Curve) {
 
-  assert (m_ColorSpace == ptSpace_Lab);
   // neutral value for a* and b* channel
   const float WPH = 0x8080;
-  const float ScalePi = ptPI / 0x7fff;
-  const float InvScalePi = 0x7fff / ptPI;
+  const int32_t Size = m_Width*m_Height;
 
-  float ValueA = 0.0;
-  float ValueB = 0.0;
-  float Col = 0.0;
-  float Hue = 0.0;
+  // L factor by hue, weighted by chroma; 1 leaves the pixel alone
+  auto LFactor = [Curve, WPH](const float Chroma, const float Hue) {
+    float Factor = Curve->Curve[CLIP((int32_t)(Hue/ptPI*WPH))]/(float)0x7fff - 1.0f;
+    if (Factor == 0.0f) return 1.0f;
+    float Col = sqrtf(Chroma) / (float) 0xb5;
+    return powf(2.0f, 3.0f*Factor*Col);
+  };
 
-  if (Curve->mask() == ptCurve::ChromaMask) { // by chroma
-#pragma omp parallel for schedule(static) private(ValueA, ValueB, Col, Hue)
-      for(uint32_t i = 0; i < (uint32_t) m_Width*m_Height; i++) {
+  if (m_ColorSpace == ptSpace_LCH) {
+#pragma omp parallel for schedule(static)
+    for (int32_t i = 0; i < Size; i++) {
+      float Factor = LFactor(m_ImageC[i], m_ImageH[i]);
+      if (Factor != 1.0f) m_ImageL[i] = CLIP((int32_t)(m_ImageL[i] * Factor));
+    }
+    return this;
+  }
 
-        ValueA = (float)m_Image[i][1]-WPH;
-        ValueB = (float)m_Image[i][2]-WPH;
+  assert (m_ColorSpace == ptSpace_Lab);
+  ForEachPolar(m_Image, Size, WPH, false, [&](const int32_t i, float &Chroma, float &Hue) {
+    float Factor = LFactor(Chroma, Hue);
+    if (Factor != 1.0f) m_Image[i][0] = CLIP((int32_t)(m_Image[i][0] * Factor));
+  });
 
-        if (ValueA == 0.0 && ValueB == 0.0) {
-          Hue = 0;   // value for grey pixel
-        } else {
-          Hue = atan2f(ValueB,ValueA);
-        }
-        while (Hue < 0) Hue += 2.*ptPI;
-        Col = powf(ValueA * ValueA + ValueB * ValueB, 0.5);
+  return this;
+}
 
-        Hue += ((float)Curve->Curve[CLIP((int32_t)(Hue*InvScalePi))]-(float)0x7fff)*ScalePi;
+////////////////////////////////////////////////////////////////////////////////
+//
+// Apply Hue Curve
+//
+////////////////////////////////////////////////////////////////////////////////
 
-        m_Image[i][1] = CLIP((int32_t)((cosf(Hue)*Col)+WPH));
-        m_Image[i][2] = CLIP((int32_t)((sinf(Hue)*Col)+WPH));
-      }
+ptImage* ptImage::ApplyHueCurve(const ptCurve *Curve) {
 
-  } else { // by luma
-#pragma omp parallel for schedule(static) private(ValueA, ValueB, Col, Hue)
-    for(uint32_t i = 0; i < (uint32_t) m_Width*m_Height; i++) {
+  // neutral value for a* and b* channel
+  const float WPH = 0x8080;
+  const float ScalePi = ptPI / 0x7fff;
+  const float InvScalePi = 0x7fff / ptPI;
+  const int32_t Size = m_Width*m_Height;
+  const bool ByChroma = Curve->mask() == ptCurve::ChromaMask;
 
-      ValueA = (float)m_Image[i][1]-WPH;
-      ValueB = (float)m_Image[i][2]-WPH;
+  // hue shift by hue (chroma mask) or by luma
+  auto Shift = [Curve, ByChroma, ScalePi, InvScalePi](const uint16_t L, const float Hue) {
+    uint16_t Index = ByChroma ? CLIP((int32_t)(Hue*InvScalePi)) : L;
+    return ((float)Curve->Curve[Index]-(float)0x7fff)*ScalePi;
+  };
 
-      if (ValueA == 0.0 && ValueB == 0.0) {
-        Hue = 0;   // value for grey pixel
-      } else {
-        Hue = atan2f(ValueB,ValueA);
-      }
-      Col = powf(ValueA * ValueA + ValueB * ValueB, 0.5);
+  if (m_ColorSpace == ptSpace_LCH) {
+#pragma omp parallel for schedule(static)
+    for (int32_t i = 0; i < Size; i++)
+      m_ImageH[i] = WrapHue(m_ImageH[i] + Shift(m_ImageL[i], m_ImageH[i]));
+    return this;
+  }
 
-      Hue += ((float)Curve->Curve[m_Image[i][0]]-(float)0x7fff)*ScalePi;
+  assert (m_ColorSpace == ptSpace_Lab);
+  ForEachPolar(m_Image, Size, WPH, true, [&](const int32_t i, float &, float &Hue) {
+    Hue += Shift(m_Image[i][0], Hue);
+  });
 
-      m_Image[i][1] = CLIP((int32_t)((cosf(Hue)*Col)+WPH));
-      m_Image[i][2] = CLIP((int32_t)((sinf(Hue)*Col)+WPH));
-    }
-  }
   return this;
 }
 
@@ -1838,79 +1816,47 @@ ptImage* ptImage::ApplyHueCurve(const ptCurve *Curve) {
 ptImage* ptImage::ApplySaturationCurve(const ptCurve *Curve,
                                        const short Mode) {
 
-// Best solution would be to use the Lab <-> Lch conversion from lcms.
-// This should be faster without sacrificing much quality.
-
-  assert (m_ColorSpace == ptSpace_Lab);
   // neutral value for a* and b* channel
   const float WPH = 0x8080;
   const float InvScalePi = 0x7fff / ptPI;
+  const int32_t Size = m_Width*m_Height;
+  const bool ByChroma = Curve->mask() == ptCurve::ChromaMask;
+
+  // chroma multiplier by hue (chroma mask) or by luma; 1 leaves the pixel alone
+  auto Multiplier = [Curve, Mode, ByChroma, InvScalePi](const uint16_t L,
+                                                        const float Chroma,
+                                                        const float Hue) {
+    float Factor = Curve->Curve[ByChroma ? CLIP((int32_t)(Hue*InvScalePi)) : L]/(float)0x7fff;
+    if (Factor == 1.0f) return 1.0f;
+    Factor *= Factor;
+    if (Mode != 1) return Factor;
+
+    float Col = sqrtf(sqrtf(Chroma));
+    Col /= 0xd; // normalizing to 0..1
+
+    if (Factor > 1)
+      // work more on desaturated pixels
+      return Factor*(1-Col)+Col;
+    else
+      // work more on saturated pixels
+      return Factor*Col+(1-Col);
+  };
 
-  float ValueA = 0.0;
-  float ValueB = 0.0;
-
-  if (Curve->mask() == ptCurve::ChromaMask) { // by chroma
-#pragma omp parallel for schedule(static) private(ValueA, ValueB)
-    for(uint32_t i = 0; i < (uint32_t) m_Width*m_Height; i++) {
-      // Factor by hue
-      ValueA = (float)m_Image[i][1]-WPH;
-      ValueB = (float)m_Image[i][2]-WPH;
-      float Hue = 0;
-      if (ValueA == 0.0 && ValueB == 0.0) {
-        Hue = 0;   // value for grey pixel
-      } else {
-        Hue = atan2f(ValueB,ValueA);
-      }
-      while (Hue < 0) Hue += 2.*ptPI;
+  if (m_ColorSpace == ptSpace_LCH) {
+#pragma omp parallel for schedule(static)
+    for (int32_t i = 0; i < Size; i++)
+      m_ImageC[i] *= Multiplier(m_ImageL[i], m_ImageC[i], m_ImageH[i]);
+    return this;
+  }
 
-      float Factor = Curve->Curve[CLIP((int32_t)(Hue*InvScalePi))]/(float)0x7fff;
-      if (Factor == 1.0) continue;
-      Factor *= Factor;
-      float m = 0;
-      if (Mode == 1) {
-        float Col = powf(ValueA * ValueA + ValueB * ValueB, 0.125);
-        Col /= 0xd; // normalizing to 0..1
-
-        if (Factor > 1)
-          // work more on desaturated pixels
-          m = Factor*(1-Col)+Col;
-        else
-          // work more on saturated pixels
-          m = Factor*Col+(1-Col);
-      } else {
-        m = Factor;
-      }
-      m_Image[i][1] = CLIP((int32_t)(m_Image[i][1] * m + WPH * (1.0 - m)));
-      m_Image[i][2] = CLIP((int32_t)(m_Image[i][2] * m + WPH * (1.0 - m)));
-    }
+  assert (m_ColorSpace == ptSpace_Lab);
+  ForEachPolar(m_Image, Size, WPH, false, [&](const int32_t i, float &Chroma, float &Hue) {
+    float m = Multiplier(m_Image[i][0], Chroma, Hue);
+    if (m == 1.0f) return;
+    m_Image[i][1] = CLIP((int32_t)(m_Image[i][1] * m + WPH * (1.0f - m)));
+    m_Image[i][2] = CLIP((int32_t)(m_Image[i][2] * m + WPH * (1.0f - m)));
+  });
 
-  } else { // by luma
-#pragma omp parallel for schedule(static) private(ValueA, ValueB)
-    for(uint32_t i = 0; i < (uint32_t) m_Width*m_Height; i++) {
-      // Factor by luminance
-      float Factor = Curve->Curve[m_Image[i][0]]/(float)0x7fff;
-      if (Factor == 1.0) continue;
-      Factor *= Factor;
-      float m = 0;
-      if (Mode == 1) {
-        ValueA = (float)m_Image[i][1]-WPH;
-        ValueB = (float)m_Image[i][2]-WPH;
-        float Col = powf(ValueA * ValueA + ValueB * ValueB, 0.125);
-        Col /= 0xd; // normalizing to 0..1
-
-        if (Factor > 1)
-          // work more on desaturated pixels
-          m = Factor*(1-Col)+Col;
-        else
-          // work more on saturated pixels
-          m = Factor*Col+(1-Col);
-      } else {
-        m = Factor;
-      }
-      m_Image[i][1] = CLIP((int32_t)(m_Image[i][1] * m + WPH * (1.0 - m)));
-      m_Image[i][2] = CLIP((int32_t)(m_Image[i][2] * m + WPH * (1.0 - m)));
-    }
-  }
   return this;
 }
 
@@ -2033,19 +1979,111 @@ ptImage* ptImage::Crop(const uint16_t X,
 #pragma omp parallel for
   for (uint16_t Row=0;Row<H;Row++) {
     for (uint16_t Column=0;Column<W;Column++) {
-      hCroppedImage.m_Data[Row*W+Column] = m_Data[(Y+Row)*m_Width+X+Column];
+      (*hCroppedImage.m_Data)[Row*W+Column] = (*m_Data)[(Y+Row)*m_Width+X+Column];
     }
   }
 
-  setSize((size_t) W*H);
-
   m_Data   = hCroppedImage.m_Data;
+  m_Image  = (uint16_t (*)[3]) m_Data->data();
   m_Width  = W;
   m_Height = H;
 
   return this;
 }
 
+////////////////////////////////////////////////////////////////////////////////
+//
+// Row bands, used by the processor for strip-wise processing
+//
+////////////////////////////////////////////////////////////////////////////////
+
+ptImage* ptImage::SetRows(const ptImage *Origin,
+                          const uint16_t FirstRow,
+                          const uint16_t NrRows) {
+
+  assert(NULL != Origin);
+  assert(FirstRow+NrRows <= Origin->m_Height);
+
+  m_Width      = Origin->m_Width;
+  m_Height     = NrRows;
+  m_Colors     = Origin->m_Colors;
+  m_ColorSpace = Origin->m_ColorSpace;
+  setSize((size_t)m_Width*m_Height);
+
+  std::copy(Origin->m_Data->begin() + (size_t)FirstRow*m_Width,
+            Origin->m_Data->begin() + (size_t)(FirstRow+NrRows)*m_Width,
+            m_Data->begin());
+
+  return this;
+}
+
+ptImage* ptImage::PutRows(const ptImage *Strip,
+                          const uint16_t StripRow,
+                          const uint16_t DestRow,
+                          const uint16_t NrRows) {
+
+  assert(NULL != Strip);
+  assert(Strip->m_Width == m_Width);
+  assert(StripRow+NrRows <= Strip->m_Height);
+  assert(DestRow+NrRows <= m_Height);
+
+  detach();
+  std::copy(Strip->m_Data->begin() + (size_t)StripRow*m_Width,
+            Strip->m_Data->begin() + (size_t)(StripRow+NrRows)*m_Width,
+            m_Data->begin() + (size_t)DestRow*m_Width);
+
+  return this;
+}
+
+ptImage* ptImage::SetRect(const ptImage *Origin,
+                          const uint16_t X,
+                          const uint16_t Y,
+                          const uint16_t W,
+                          const uint16_t H) {
+
+  assert(NULL != Origin);
+  assert(X+W <= Origin->m_Width);
+  assert(Y+H <= Origin->m_Height);
+
+  m_Width      = W;
+  m_Height     = H;
+  m_Colors     = Origin->m_Colors;
+  m_ColorSpace = Origin->m_ColorSpace;
+  setSize((size_t)m_Width*m_Height);
+
+#pragma omp parallel for
+  for (int32_t Row=0; Row<H; Row++) {
+    auto Source = Origin->m_Data->begin() + (size_t)(Y+Row)*Origin->m_Width + X;
+    std::copy(Source, Source + W, m_Data->begin() + (size_t)Row*W);
+  }
+
+  return this;
+}
+
+ptImage* ptImage::PutRect(const ptImage *Tile,
+                          const uint16_t TileX,
+                          const uint16_t TileY,
+                          const uint16_t X,
+                          const uint16_t Y,
+                          const uint16_t W,
+                          const uint16_t H) {
+
+  assert(NULL != Tile);
+  assert(TileX+W <= Tile->m_Width);
+  assert(TileY+H <= Tile->m_Height);
+  assert(X+W <= m_Width);
+  assert(Y+H <= m_Height);
+
+  detach();
+#pragma omp parallel for
+  for (int32_t Row=0; Row<H; Row++) {
+    auto Source = Tile->m_Data->begin() + (size_t)(TileY+Row)*Tile->m_Width + TileX;
+    std::copy(Source, Source + W, m_Data->begin() + (size_t)(Y+Row)*m_Width + X);
+  }
+
+  return this;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 //
 // Overlay
@@ -2782,44 +2820,31 @@ ptImage* ptImage::LumaAdjust(const double LC1, // 8 colors for L
                           const double LC7,
                             const double LC8)
 {
-  assert (m_ColorSpace == ptSpace_Lab);
-  float WPH = 0x7fff;
-  float IQPI = 4/ptPI;
+  // neutral value for a* and b* channel
+  const float WPH = 0x7fff;
+  const int32_t Size = m_Width*m_Height;
+  const double Adjust[8] = {LC1, LC2, LC3, LC4, LC5, LC6, LC7, LC8};
 
-#pragma omp parallel for schedule(static)
-  for(uint32_t i = 0; i < (uint32_t) m_Width*m_Height; i++) {
-    float Col = powf(((float)m_Image[i][1]-WPH)*((float)m_Image[i][1]-WPH) +
-          ((float)m_Image[i][2]-WPH)*((float)m_Image[i][2]-WPH), 0.25);
+  auto Apply = [&Adjust](uint16_t &L, const float Chroma, const float Hue) {
+    float Col = sqrtf(Chroma);
     Col /= 0xb5; // normalizing to 0..1, sqrt(0x7fff)
-    float Hue = 0;
-    if (m_Image[i][1] == WPH && m_Image[i][2] == WPH) {
-      Hue = 0;   // value for grey pixel
-    } else {
-      Hue = atan2f((float)m_Image[i][2]-WPH,
-      (float)m_Image[i][1]-WPH);
-    }
-    while (Hue < 0) Hue += 2.*ptPI;
-
-    if ( LC1 != 0 && Hue > -.1 && Hue < ptPI/4)
-      m_Image[i][0] = CLIP((int32_t)(m_Image[i][0] * powf(2,(1.-fabsf(Hue-0)*IQPI)*LC1*Col)));
-    if ( LC2 != 0 && Hue > 0 && Hue < ptPI/2)
-      m_Image[i][0] = CLIP((int32_t)(m_Image[i][0] * powf(2,(1.-fabsf(Hue-ptPI/4)*IQPI)*LC2*Col)));
-    if ( LC3 != 0 && Hue > ptPI/4 && Hue < ptPI*3/4)
-      m_Image[i][0] = CLIP((int32_t)(m_Image[i][0] * powf(2,(1.-fabsf(Hue-ptPI/2)*IQPI)*LC3*Col)));
-    if ( LC4 != 0 && Hue > ptPI/2 && Hue < ptPI)
-      m_Image[i][0] = CLIP((int32_t)(m_Image[i][0] * powf(2,(1.-fabsf(Hue-ptPI*3/4)*IQPI)*LC4*Col)));
-    if ( LC5 != 0 && Hue > ptPI*3/4 && Hue < ptPI*5/4)
-      m_Image[i][0] = CLIP((int32_t)(m_Image[i][0] * powf(2,(1.-fabsf(Hue-ptPI)*IQPI)*LC5*Col)));
-    if ( LC6 != 0 && Hue > ptPI && Hue < ptPI*6/4)
-      m_Image[i][0] = CLIP((int32_t)(m_Image[i][0] * powf(2,(1.-fabsf(Hue-ptPI*5/4)*IQPI)*LC6*Col)));
-    if ( LC7 != 0 && Hue > ptPI*5/4 && Hue < ptPI*7/4)
-      m_Image[i][0] = CLIP((int32_t)(m_Image[i][0] * powf(2,(1.-fabsf(Hue-ptPI*6/4)*IQPI)*LC7*Col)));
-    if ( LC8 != 0 && Hue > ptPI*6/4 && Hue < ptPI*8/4)
-      m_Image[i][0] = CLIP((int32_t)(m_Image[i][0] * powf(2,(1.-fabsf(Hue-ptPI*7/4)*IQPI)*LC8*Col)));
-    if ( LC1 != 0 && Hue > ptPI*7/4 && Hue < ptPI*2.1)
-      m_Image[i][0] = CLIP((int32_t)(m_Image[i][0] * powf(2,(1.-fabsf(Hue-ptPI*2)*IQPI)*LC1*Col)));
+    ForHueSectors(Adjust, Hue, [&](const float Weighted) {
+      L = CLIP((int32_t)(L * powf(2, Weighted*Col)));
+    });
+  };
+
+  if (m_ColorSpace == ptSpace_LCH) {
+#pragma omp parallel for schedule(static)
+    for (int32_t i = 0; i < Size; i++)
+      Apply(m_ImageL[i], m_ImageC[i], m_ImageH[i]);
+    return this;
   }
 
+  assert (m_ColorSpace == ptSpace_Lab);
+  ForEachPolar(m_Image, Size, WPH, false, [&](const int32_t i, float &Chroma, float &Hue) {
+    Apply(m_Image[i][0], Chroma, Hue);
+  });
+
   return this;
 }
 
@@ -2834,72 +2859,34 @@ ptImage* ptImage::SatAdjust(const double SC1, // 8 colors for saturation
                             const double SC7,
                             const double SC8)
 {
-  assert (m_ColorSpace == ptSpace_Lab);
-  float WPH = 0x7fff;
-  float IQPI = 4/ptPI;
+  // neutral value for a* and b* channel
+  const float WPH = 0x7fff;
+  const int32_t Size = m_Width*m_Height;
+  const double Adjust[8] = {SC1, SC2, SC3, SC4, SC5, SC6, SC7, SC8};
 
+  if (m_ColorSpace == ptSpace_LCH) {
 #pragma omp parallel for schedule(static)
-  for(uint32_t i = 0; i < (uint32_t) m_Width*m_Height; i++) {
-    float Col = powf(((float)m_Image[i][1]-WPH)*((float)m_Image[i][1]-WPH) +
-          ((float)m_Image[i][2]-WPH)*((float)m_Image[i][2]-WPH), 0.25);
-    Col /= 0xb5; // normalizing to 0..1, sqrt(0x7fff)
-    float Hue = 0;
-    if (m_Image[i][1] == WPH && m_Image[i][2] == WPH) {
-      Hue = 0;   // value for grey pixel
-    } else {
-      Hue = atan2f((float)m_Image[i][2]-WPH,
-      (float)m_Image[i][1]-WPH);
-    }
-    while (Hue < 0) Hue += 2.*ptPI;
-
-    float m = 0;
-    if ( SC1 != 0 && Hue > -.1 && Hue < ptPI/4) {
-      m = powf(8,(1.-fabsf(Hue-0)*IQPI)*SC1*Col);
-      m_Image[i][1] = CLIP((int32_t)(m_Image[i][1] * m + WPH * (1. - m)));
-      m_Image[i][2] = CLIP((int32_t)(m_Image[i][2] * m + WPH * (1. - m)));
-    }
-    if ( SC2 != 0 && Hue > 0 && Hue < ptPI/2) {
-      m = powf(8,(1.-fabsf(Hue-ptPI/4)*IQPI)*SC2*Col);
-      m_Image[i][1] = CLIP((int32_t)(m_Image[i][1] * m + WPH * (1. - m)));
-      m_Image[i][2] = CLIP((int32_t)(m_Image[i][2] * m + WPH * (1. - m)));
-    }
-    if ( SC3 != 0 && Hue > ptPI/4 && Hue < ptPI*3/4) {
-      m = powf(8,(1.-fabsf(Hue-ptPI/2)*IQPI)*SC3*Col);
-      m_Image[i][1] = CLIP((int32_t)(m_Image[i][1] * m + WPH * (1. - m)));
-      m_Image[i][2] = CLIP((int32_t)(m_Image[i][2] * m + WPH * (1. - m)));
-    }
-    if ( SC4 != 0 && Hue > ptPI/2 && Hue < ptPI) {
-      m = powf(8,(1.-fabsf(Hue-ptPI*3/4)*IQPI)*SC4*Col);
-      m_Image[i][1] = CLIP((int32_t)(m_Image[i][1] * m + WPH * (1. - m)));
-      m_Image[i][2] = CLIP((int32_t)(m_Image[i][2] * m + WPH * (1. - m)));
-    }
-    if ( SC5 != 0 && Hue > ptPI*3/4 && Hue < ptPI*5/4) {
-      m = powf(8,(1.-fabsf(Hue-ptPI)*IQPI)*SC5*Col);
-      m_Image[i][1] = CLIP((int32_t)(m_Image[i][1] * m + WPH * (1. - m)));
-      m_Image[i][2] = CLIP((int32_t)(m_Image[i][2] * m + WPH * (1. - m)));
-    }
-    if ( SC6 != 0 && Hue > ptPI && Hue < ptPI*6/4) {
-      m = powf(8,(1.-fabsf(Hue-ptPI*5/4)*IQPI)*SC6*Col);
-      m_Image[i][1] = CLIP((int32_t)(m_Image[i][1] * m + WPH * (1. - m)));
-      m_Image[i][2] = CLIP((int32_t)(m_Image[i][2] * m + WPH * (1. - m)));
-    }
-    if ( SC7 != 0 && Hue > ptPI*5/4 && Hue < ptPI*7/4) {
-      m = powf(8,(1.-fabsf(Hue-ptPI*6/4)*IQPI)*SC7*Col);
-      m_Image[i][1] = CLIP((int32_t)(m_Image[i][1] * m + WPH * (1. - m)));
-      m_Image[i][2] = CLIP((int32_t)(m_Image[i][2] * m + WPH * (1. - m)));
-    }
-    if ( SC8 != 0 && Hue > ptPI*6/4 && Hue < ptPI*8/4) {
-      m = powf(8,(1.-fabsf(Hue-ptPI*7/4)*IQPI)*SC8*Col);
-      m_Image[i][1] = CLIP((int32_t)(m_Image[i][1] * m + WPH * (1. - m)));
-      m_Image[i][2] = CLIP((int32_t)(m_Image[i][2] * m + WPH * (1. - m)));
-    }
-    if ( SC1 != 0 && Hue > ptPI*7/4 && Hue < ptPI*2.1) {
-      m = powf(8,(1.-fabsf(Hue-ptPI*2)*IQPI)*SC1*Col);
-      m_Image[i][1] = CLIP((int32_t)(m_Image[i][1] * m + WPH * (1. - m)));
-      m_Image[i][2] = CLIP((int32_t)(m_Image[i][2] * m + WPH * (1. - m)));
+    for (int32_t i = 0; i < Size; i++) {
+      float Col = sqrtf(m_ImageC[i]);
+      Col /= 0xb5; // normalizing to 0..1, sqrt(0x7fff)
+      ForHueSectors(Adjust, m_ImageH[i], [&](const float Weighted) {
+        m_ImageC[i] *= powf(8, Weighted*Col);
+      });
     }
+    return this;
   }
 
+  assert (m_ColorSpace == ptSpace_Lab);
+  ForEachPolar(m_Image, Size, WPH, false, [&](const int32_t i, float &Chroma, float &Hue) {
+    float Col = sqrtf(Chroma);
+    Col /= 0xb5; // normalizing to 0..1, sqrt(0x7fff)
+    ForHueSectors(Adjust, Hue, [&](const float Weighted) {
+      float m = powf(8, Weighted*Col);
+      m_Image[i][1] = CLIP((int32_t)(m_Image[i][1] * m + WPH * (1.0f - m)));
+      m_Image[i][2] = CLIP((int32_t)(m_Image[i][2] * m + WPH * (1.0f - m)));
+    });
+  });
+
   return this;
 }
 
@@ -5457,61 +5444,33 @@ ptImage* ptImage::SpecialPreview(const short Mode, const int Intent) {
       Mode == ptSpecialPreview_A ||
       Mode == ptSpecialPreview_B) {
     int InColorSpace = m_ColorSpace;
-    cmsHPROFILE InternalProfile = 0;
-    if (InColorSpace != ptSpace_Profiled) {
-      // linear case
-      cmsToneCurve* Gamma = cmsBuildGamma(NULL, 1.0);
-      cmsToneCurve* Gamma3[3];
-      Gamma3[0] = Gamma3[1] = Gamma3[2] = Gamma;
-
-      cmsCIExyY       DFromReference;
-
-      switch (m_ColorSpace) {
-        case ptSpace_sRGB_D65 :
-        case ptSpace_AdobeRGB_D65 :
-          DFromReference = D65;
-          break;
-        case ptSpace_WideGamutRGB_D50 :
-        case ptSpace_ProPhotoRGB_D50 :
-          DFromReference = D50;
-          break;
-        default:
-          assert(0);
-      }
-
-      InternalProfile = cmsCreateRGBProfile(&DFromReference,
-                                      (cmsCIExyYTRIPLE*)&RGBPrimaries[m_ColorSpace],
-                                      Gamma3);
-
-      if (!InternalProfile) {
-        ptLogError(ptError_Profile,"Could not open InternalProfile profile.");
-        return this;
-      }
-
-      cmsFreeToneCurve(Gamma);
-    } else {
-      // profiled case
-      InternalProfile = PreviewColorProfile;
+    // linear working space or the profiled preview
+    ptCmsEnd InternalEnd = (InColorSpace != ptSpace_Profiled) ?
+                           ptCmsEnd::workspace(m_ColorSpace) :
+                           ptCmsEnd::profile(PreviewColorProfile);
+    ptCmsTransform ToLab =
+      ptCmsTransformCache::instance()->get(InternalEnd, TYPE_RGB_16,
+                                           ptCmsEnd::lab(), TYPE_Lab_16,
+                                           Intent,
+                                           cmsFLAGS_NOOPTIMIZE | cmsFLAGS_BLACKPOINTCOMPENSATION);
+    ptCmsTransform FromLab =
+      ptCmsTransformCache::instance()->get(ptCmsEnd::lab(), TYPE_Lab_16,
+                                           InternalEnd, TYPE_RGB_16,
+                                           Intent,
+                                           cmsFLAGS_NOOPTIMIZE | cmsFLAGS_BLACKPOINTCOMPENSATION);
+    if (!ToLab || !FromLab) {
+      ptLogError(ptError_Profile,"Could not create colour transform.");
+      return this;
     }
 
-    cmsHPROFILE LabProfile = 0;
-    LabProfile = cmsCreateLab4Profile(NULL);
     // to Lab
-    cmsHTRANSFORM Transform;
-    Transform = cmsCreateTransform(InternalProfile,
-                                   TYPE_RGB_16,
-                                   LabProfile,
-                                   TYPE_Lab_16,
-                                   Intent,
-                                   cmsFLAGS_NOOPTIMIZE | cmsFLAGS_BLACKPOINTCOMPENSATION);
-
     int32_t Size = m_Width*m_Height;
     int32_t Step = 100000;
   #pragma omp parallel for schedule(static)
     for (int32_t i = 0; i < Size; i+=Step) {
       int32_t Length = (i+Step)<Size ? Step : Size - i;
       uint16_t* Tile = &(m_Image[i][0]);
-      cmsDoTransform(Transform,Tile,Tile,Length);
+      cmsDoTransform(ToLab.get(),Tile,Tile,Length);
     }
     m_ColorSpace = ptSpace_Lab;
     // ViewLAB
@@ -5520,24 +5479,13 @@ ptImage* ptImage::SpecialPreview(const short Mode, const int Intent) {
     if (Mode == ptSpecialPreview_B) ViewLab(TViewLabChannel::b);
 
     // to RGB
-    Transform = cmsCreateTransform(LabProfile,
-                                   TYPE_Lab_16,
-                                   InternalProfile,
-                                   TYPE_RGB_16,
-                                   Intent,
-                                   cmsFLAGS_NOOPTIMIZE | cmsFLAGS_BLACKPOINTCOMPENSATION);
-
   #pragma omp parallel for schedule(static)
     for (int32_t i = 0; i < Size; i+=Step) {
       int32_t Length = (i+Step)<Size ? Step : Size - i;
       uint16_t* Tile = &(m_Image[i][0]);
-      cmsDoTransform(Transform,Tile,Tile,Length);
+      cmsDoTransform(FromLab.get(),Tile,Tile,Length);
     }
 
-    cmsDeleteTransform(Transform);
-    cmsCloseProfile(LabProfile);
-    if (InColorSpace != ptSpace_Profiled)
-      cmsCloseProfile(InternalProfile);
     m_ColorSpace = InColorSpace;
   } else if (Mode==ptSpecialPreview_Structure) {
 #pragma omp parallel for default(shared) schedule(static)
@@ -5796,7 +5744,6 @@ ptImage* ptImage::WaveletDenoise(const uint8_t  ChannelMask,
   if (WithMask) assert(m_ColorSpace == ptSpace_Lab);
   uint32_t Size = m_Width*m_Height;
 
-  const float WP = 0xffff;
   float stdev[5];
   uint32_t samples[5];
 
@@ -5811,10 +5758,7 @@ ptImage* ptImage::WaveletDenoise(const uint8_t  ChannelMask,
     if  (! (ChannelMask & (1<<Channel))) continue;
 
     // algorithm works between 0..1
-#pragma omp parallel for default(shared)
-    for (uint32_t i=0; i<Size; i++) {
-      fImage[i] = ToFloatTable[m_Image[i][Channel]];
-    }
+    getChannel(Channel, fImage);
 
     uint32_t lpass;
     uint32_t hpass = 0;
@@ -5969,18 +5913,28 @@ ptImage* ptImage::WaveletDenoise(const uint8_t  ChannelMask,
     if (Channel==0 && WithMask && (Sharpness || (Anisotropy > 0.5))) {
       ptImage *MaskLayer = new ptImage;
       MaskLayer->Set(this);
+      MaskLayer->toUInt16();
       ptCimgEdgeTensors(MaskLayer,Sharpness,Anisotropy,Alpha,Sigma);
+      if (isFloat()) {
 #pragma omp parallel for default(shared)
-      for (uint32_t i=0; i<Size; i++) {
-        m_Image[i][Channel] = CLIP((int32_t)((fImage[i] + fImage[lpass+i])*MaskLayer->m_Image[i][0]+
-                                             m_Image[i][Channel]*(1-(float)MaskLayer->m_Image[i][0]/(float)0xffff)));
+        for (uint32_t i=0; i<Size; i++) {
+          const float Mask = ToFloatTable[MaskLayer->m_Image[i][0]];
+          m_DataF[i][Channel] = (fImage[i] + fImage[lpass+i])*Mask + m_DataF[i][Channel]*(1-Mask);
+        }
+      } else {
+#pragma omp parallel for default(shared)
+        for (uint32_t i=0; i<Size; i++) {
+          m_Image[i][Channel] = CLIP((int32_t)((fImage[i] + fImage[lpass+i])*MaskLayer->m_Image[i][0]+
+                                               m_Image[i][Channel]*(1-(float)MaskLayer->m_Image[i][0]/(float)0xffff)));
+        }
       }
       delete MaskLayer;
     } else {
 #pragma omp parallel for default(shared)
       for (uint32_t i=0; i<Size; i++) {
-        m_Image[i][Channel] = CLIP((int32_t)((fImage[i] + fImage[lpass+i])*WP));
+        fImage[i] += fImage[lpass+i];
       }
+      putChannel(Channel, fImage);
     }
   }
 
@@ -6068,11 +6022,21 @@ ptImage* ptImage::fastBilateralChannel(
   for (short Channel = 0; Channel<3; Channel++) {
     // Is it a channel we are supposed to handle ?
     if  (! (ChannelMask & (1<<Channel))) continue;
+    if (isPlanar()) {
+#pragma omp parallel for default(shared) schedule(static)
+      for (uint16_t Row=0; Row<m_Height; Row++) {
+        const uint16_t *Plane = planeRow(Channel, Row);
+        for (uint16_t Col=0; Col<m_Width; Col++) {
+          InImage(Col,Row) = ToFloatTable[Plane[Col]];
+        }
+      }
+    } else {
 #pragma omp parallel for default(shared) schedule(static) private(hIdx)
-    for (uint16_t Row=0; Row<m_Height; Row++) {
-      hIdx = Row*Width;
-      for (uint16_t Col=0; Col<m_Width; Col++) {
-        InImage(Col,Row) = ToFloatTable[m_Image[hIdx+Col][Channel]];
+      for (uint16_t Row=0; Row<m_Height; Row++) {
+        hIdx = Row*Width;
+        for (uint16_t Col=0; Col<m_Width; Col++) {
+          InImage(Col,Row) = ToFloatTable[m_Image[hIdx+Col][Channel]];
+        }
       }
     }
 
@@ -6082,11 +6046,21 @@ ptImage* ptImage::fastBilateralChannel(
            1,
            &FilteredImage,&FilteredImage);
 
+    if (isPlanar()) {
+#pragma omp parallel for default(shared) schedule(static)
+      for (uint16_t Row=0; Row<m_Height; Row++) {
+        uint16_t *Plane = planeRow(Channel, Row);
+        for (uint16_t Col=0; Col<m_Width; Col++) {
+          Plane[Col] = CLIP((int32_t)(FilteredImage(Col,Row)*0xffff));
+        }
+      }
+    } else {
 #pragma omp parallel for default(shared) schedule(static) private(hIdx)
-    for (uint16_t Row=0; Row<m_Height; Row++) {
-      hIdx = Row*Width;
-      for (uint16_t Col=0; Col<m_Width; Col++) {
-        m_Image[hIdx+Col][Channel] = CLIP((int32_t)(FilteredImage(Col,Row)*0xffff));
+      for (uint16_t Row=0; Row<m_Height; Row++) {
+        hIdx = Row*Width;
+        for (uint16_t Col=0; Col<m_Width; Col++) {
+          m_Image[hIdx+Col][Channel] = CLIP((int32_t)(FilteredImage(Col,Row)*0xffff));
+        }
       }
     }
   }
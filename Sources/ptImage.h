@@ -32,6 +32,7 @@
 
 #include <vector>
 #include <array>
+#include <memory>
 
 //==============================================================================
 
@@ -75,11 +76,24 @@ public:
   // [0] = R
   // [1] = G
   // [2] = B
-  TImage16Data m_Data;
+  // The buffer is shared between images after Share() and copied on the
+  // first write, see detach().
+  std::shared_ptr<TImage16Data> m_Data;
 
   // Pointer to the data buffer, since most algorithms still use that.
   uint16_t (*m_Image)[3];
 
+  // Optional float32 representation, same 0..1 scale as ToFloatTable but not
+  // clipped. While it holds the pixels (isFloat()) m_Data is empty and m_Image
+  // is NULL, so only kernels that check isFloat() may work on such an image.
+  TImageFData m_DataF;
+
+  // Optional planar 16 bit layout: one plane per channel, rows of
+  // m_PlaneStride samples that start on 32 byte boundaries. While it holds the
+  // pixels (isPlanar()) m_Data is empty and m_Image is NULL, see toPlanar().
+  std::shared_ptr<uint16_t> m_Planes;
+  int32_t                   m_PlaneStride;
+
   // LCH image data, m_Image is NULL when the image is in ptSpace_LCH
   std::vector<uint16_t> m_ImageL;
   std::vector<float>    m_ImageC;
@@ -112,12 +126,40 @@ public:
   // Destructor
   ~ptImage();
 
-  // Allocates m_Data and sets m_Image to the buffer
+  // Allocates m_Data and sets m_Image to the buffer. A buffer shared with
+  // another image is not touched, a fresh one is allocated instead.
   void setSize(size_t Size);
-  size_t size() const { return m_Data.size(); }
+  size_t size() const { return isFloat()  ? m_DataF.size() :
+                               isPlanar() ? (size_t)m_Width*m_Height : m_Data->size(); }
 
   void clear();
-  bool isNull() const { return m_Data.size() == 0; }
+  bool isNull() const { return size() == 0; }
+
+  // Switch between the 16 bit and the float32 representation (see m_DataF).
+  // toUInt16() is where values get clipped again.
+  bool isFloat() const { return !m_DataF.empty(); }
+  ptImage* toFloat();
+  ptImage* toUInt16();
+
+  // Switch between the interleaved and the planar layout (see m_Planes).
+  // Float images stay interleaved, toPlanar() leaves them alone.
+  bool isPlanar() const { return m_Planes != nullptr; }
+  ptImage* toPlanar();
+  ptImage* toInterleaved();
+  uint16_t* planeRow(const short Channel, const uint16_t Row) const {
+    return m_Planes.get() + ((size_t)Channel*m_Height + Row)*m_PlaneStride;
+  }
+
+  // One channel as 0..1 floats, in any representation. putChannel() only
+  // clips when the image is 16 bit.
+  void getChannel(const short Channel, float *Dest) const;
+  void putChannel(const short Channel, const float *Source);
+
+  // Makes the buffer private to this image, copying it when it is shared.
+  // Must be called before writing to m_Image of an image that may share
+  // its buffer (see Share()).
+  void detach();
+  bool isShared() const { return m_Data.use_count() > 1; }
 
   // Initialize it via dcraw (from a DcRawObject).
   // By the way , the copying is always deep (and
@@ -139,6 +181,10 @@ public:
   // Copying is always deep (so including copying the image).
   ptImage* Set(const ptImage *Origin);
 
+  // Initialize it from another image without copying the pixels.
+  // Both images use the same buffer until one of them calls detach().
+  ptImage* Share(const ptImage *Origin);
+
   // Copy from another image and scale to pipe size.
   ptImage* SetScaled(const ptImage *Origin,
                      const short ScaleFactor);
@@ -152,6 +198,33 @@ public:
                 const uint16_t W,
                 const uint16_t H);
 
+  // Initialize it from a band of full rows of another image.
+  ptImage* SetRows(const ptImage *Origin,
+                   const uint16_t FirstRow,
+                   const uint16_t NrRows);
+
+  // Copy NrRows rows of Strip (starting at StripRow) back into the image at DestRow.
+  ptImage* PutRows(const ptImage *Strip,
+                   const uint16_t StripRow,
+                   const uint16_t DestRow,
+                   const uint16_t NrRows);
+
+  // Initialize it from the W x H rectangle at X,Y of another image.
+  ptImage* SetRect(const ptImage *Origin,
+                   const uint16_t X,
+                   const uint16_t Y,
+                   const uint16_t W,
+                   const uint16_t H);
+
+  // Copy the W x H rectangle at TileX,TileY of Tile back into the image at X,Y.
+  ptImage* PutRect(const ptImage *Tile,
+                   const uint16_t TileX,
+                   const uint16_t TileY,
+                   const uint16_t X,
+                   const uint16_t Y,
+                   const uint16_t W,
+                   const uint16_t H);
+
   // A bunch of color space conversion functions.
   // lcms ones are going via the lcms library, the others via matrices.
   // The origin space is implicit in the class.
@@ -160,6 +233,7 @@ public:
   ptImage* lcmsRGBToRGB(const short To,
                         const short EvenIfEqual = 0,
                         const int   Intent = INTENT_PERCEPTUAL);
+  // Except for ptCMQuality_NoOptimize this goes through a lookup table, see ptColorLut.
   ptImage* lcmsRGBToRGB(cmsHPROFILE OutProfile, //with ICC profile
                         const int   Intent = INTENT_PERCEPTUAL,
                         const short Quality = ptCMQuality_HighResPreCalc);
@@ -543,6 +617,15 @@ ptImage* MaskedColorAdjust(const int       Ax,
   ptImage* ApplyCurve(const ptCurve *Curve,
                       const uint8_t ChannelMask);
 
+  // Per channel lookup tables. SetIdentityLut() makes a 256x256 image whose
+  // pixel i is (i,i,i) in the given color space. Point operations run on it
+  // turn it into three 1D tables that ApplyLut() applies in one pass.
+  ptImage* SetIdentityLut(const short ColorSpace);
+  ptImage* ApplyLut(const ptImage *Lut);
+
+  // The hue based filters below (LumaAdjust, SatAdjust, ApplyLByHueCurve,
+  // ApplyHueCurve, ApplySaturationCurve) take Lab or LCh images and leave
+  // them in that space, so a run of them needs only one LabToLch().
   ptImage* ApplyLByHueCurve(const ptCurve *Curve);
 
   ptImage* ApplyHueCurve(const ptCurve *Curve);
@@ -723,6 +806,7 @@ ptImage* MaskedColorAdjust(const int       Ax,
 
 private:
   void ResizeLCH(size_t ASize);
+  void CopyPlanes(const ptImage *Origin);
 };
 
 #endif
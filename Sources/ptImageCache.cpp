@@ -0,0 +1,101 @@
+/*******************************************************************************
+**
+** Photivo
+**
+** Copyright (C) 2026 agent <agent@local>
+**
+** This file is part of Photivo.
+**
+** Photivo is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License version 3
+** as published by the Free Software Foundation.
+**
+** Photivo is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with Photivo.  If not, see <http://www.gnu.org/licenses/>.
+**
+*******************************************************************************/
+
+#include "ptImageCache.h"
+#include "ptImage.h"
+
+//------------------------------------------------------------------------------
+ptImageCache::ptImageCache(size_t AMaxSizeBytes):
+  FCapacity(AMaxSizeBytes),
+  FOccupancy(0)
+{}
+
+//------------------------------------------------------------------------------
+
+ptImageCache::~ptImageCache() {}
+
+//------------------------------------------------------------------------------
+/*! Immediately empties the entire cache. */
+void ptImageCache::clear() {
+  FAccess.clear();
+  FCache.clear();
+  FCache.squeeze();
+  FOccupancy = 0;
+}
+
+//------------------------------------------------------------------------------
+/*!
+  Returns the image stored for AKey, or an empty TImagePtr if there is none.
+  The returned image must not be modified.
+*/
+TImagePtr ptImageCache::find(const QByteArray &AKey) {
+  auto hDataIter = FCache.find(AKey);
+
+  if (hDataIter == FCache.end())
+    return TImagePtr();
+
+  FAccess.erase(hDataIter->AccessIter);
+  hDataIter->AccessIter = FAccess.insert(FAccess.end(), AKey);
+  return hDataIter->Data;
+}
+
+//------------------------------------------------------------------------------
+/*! Stores AImage under AKey. Nothing happens when AKey is already present.
+    The pixel buffer is shared with AImage, it is only copied when AImage is written to
+    again (see ptImage::detach()).
+ */
+void ptImageCache::insert(const QByteArray &AKey, const ptImage *AImage) {
+  const size_t hSize = AImage->size()*sizeof(TPixel16);
+
+  if (FCache.contains(AKey) || (hSize > FCapacity))
+    return;
+
+  FOccupancy += hSize;
+  this->evict();
+
+  auto hCopy = std::make_shared<ptImage>();
+  hCopy->Share(AImage);
+  FCache.insert(AKey, {hCopy, hSize, FAccess.insert(FAccess.end(), AKey)});
+}
+
+//------------------------------------------------------------------------------
+/*! Changes the capacity of the cache. Surplus items are evicted immediately. */
+void ptImageCache::setCapacity(size_t AMaxSizeBytes) {
+  FCapacity = AMaxSizeBytes;
+  this->evict();
+}
+
+//------------------------------------------------------------------------------
+// Removes least-recently-used items until the cache is at or below capacity again.
+void ptImageCache::evict() {
+  while (FOccupancy > FCapacity) {
+    if (FAccess.isEmpty()) {
+      FOccupancy = 0;
+      return;
+    }
+
+    auto hDataIter = FCache.find(FAccess.first());
+    FOccupancy -= hDataIter->Size;
+    FCache.erase(hDataIter);
+    FAccess.removeFirst();
+  }
+}
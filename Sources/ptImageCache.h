@@ -0,0 +1,71 @@
+/*******************************************************************************
+**
+** Photivo
+**
+** Copyright (C) 2026 agent <agent@local>
+**
+** This file is part of Photivo.
+**
+** Photivo is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License version 3
+** as published by the Free Software Foundation.
+**
+** Photivo is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with Photivo.  If not, see <http://www.gnu.org/licenses/>.
+**
+*******************************************************************************/
+
+#ifndef PTIMAGECACHE_H
+#define PTIMAGECACHE_H
+
+#include <QByteArray>
+#include <QHash>
+#include <QLinkedList>
+
+#include <memory>
+
+class ptImage;
+
+typedef std::shared_ptr<ptImage> TImagePtr;
+
+//==============================================================================
+
+/*! ptImageCache implements a least-recently-used cache for intermediate pipe images.
+    The processor uses it to remember filter results keyed by a hash of the filter chain and
+    configs that produced them (see \c ptFilterBase::cacheKey()). Works the same way as
+    \c ptThumbCache.
+ */
+class ptImageCache {
+public:
+  explicit ptImageCache(size_t AMaxSizeBytes);
+  ~ptImageCache();
+
+  void      clear();
+  TImagePtr find(const QByteArray &AKey);
+  void      insert(const QByteArray &AKey, const ptImage *AImage);
+  void      setCapacity(size_t AMaxSizeBytes);
+  size_t    occupancy() const { return FOccupancy; }
+
+private:
+  typedef QLinkedList<QByteArray> TAccessTracker;
+
+  struct TCacheValue {
+    TImagePtr                 Data;
+    size_t                    Size;
+    TAccessTracker::iterator  AccessIter;
+  };
+
+  void evict();
+
+  TAccessTracker                   FAccess;
+  QHash<QByteArray, TCacheValue>   FCache;
+  size_t                           FCapacity;  // in bytes
+  size_t                           FOccupancy; // in bytes
+};
+
+#endif // PTIMAGECACHE_H
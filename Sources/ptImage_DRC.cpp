@@ -52,8 +52,6 @@ So for example a pixel at (-1, y) is equal to a pixel at (0, y) by definition.
   #include <omp.h>
 #endif
 
-extern float ToFloatTable[0x10000];
-
 //Stores derivative of I into (Ix, Iy). Note that this is backward difference by shifting coordinates.
 void ForwardDifferenceGradient(float *Ix, float *Iy, uint32_t w, uint32_t h, float *I){
   uint32_t x, y;
@@ -729,13 +727,27 @@ ptImage* ptImage::DRC(const float alpha,
   uint16_t w = m_Width;
   uint16_t h = m_Height;
 
-#pragma omp parallel for schedule(static)
-  for (int32_t i = 0; i < m_Width*m_Height; i++) {
-    In[i] = ToFloatTable[m_Image[i][0]];
-  }
+  getChannel(0, In);
 
   CompressDynamicRange(In, w, h, pow(alpha,5.0), beta, 1);
 
+  if (isFloat()) {
+    const float WPH = (float)0x8080/0xffff; // Neutral in Lab A and B
+#pragma omp parallel for schedule(static)
+    for (int32_t i = 0; i < m_Width*m_Height; i++) {
+      if (color != 0) { // Chromatic adaption, as below without the quantization.
+        if (m_DataF[i][0] <= 0.0f) continue;
+        const float Factor = MIN(2*powf(In[i]/m_DataF[i][0],0.5f),100.f);
+        for (short c = 1; c < 3; c++) {
+          m_DataF[i][c] = (m_DataF[i][c]*Factor + WPH*(1.f-Factor))*color + m_DataF[i][c]*(1-color);
+        }
+      }
+      m_DataF[i][0] = In[i];
+    }
+    FREE (In);
+    return this;
+  }
+
   float Factor = 0.0;
   uint16_t Value = 0;
 
@@ -256,8 +256,6 @@ void dt_iop_equalizer_iwtf(float *buf, float **weight_a, const int l, const int
 #undef gbuf
 #undef gweight
 
-extern float ToFloatTable[0x10000];
-
 ptImage* ptImage::EAWChannel(const double scaling,
                              const double level1,
                              const double level2,
@@ -274,10 +272,7 @@ ptImage* ptImage::EAWChannel(const double scaling,
   float (*out) = (float (*)) CALLOC2(w*h,sizeof(*out));
   ptMemoryError(out,__FILE__,__LINE__);
 
-#pragma omp parallel for schedule(static)
-  for (int32_t i = 0; i < m_Width*m_Height; i++) {
-    out[i] = ToFloatTable[m_Image[i][0]];
-  }
+  getChannel(0, out);
 
   const int width = w;
   const int height = h;
@@ -373,10 +368,7 @@ ptImage* ptImage::EAWChannel(const double scaling,
 #endif
 
 
-#pragma omp parallel for schedule(static)
-  for (int32_t i = 0; i < m_Width*m_Height; i++) {
-    m_Image[i][0] = CLIP((int32_t)(out[i]*0xffff));
-  }
+  putChannel(0, out);
 
   FREE (out);
   return this;
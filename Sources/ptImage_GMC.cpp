@@ -167,7 +167,7 @@ bool ptImage::DumpImage(const char* FileName) const {
   MagickSetImageDepth(mw,16);
   MagickSetImageType(mw,TrueColorType);
 
-  MagickSetImagePixels(mw,0,0,Width,Height,"RGB",ShortPixel,(unsigned char*) m_Data.data());
+  MagickSetImagePixels(mw,0,0,Width,Height,"RGB",ShortPixel,(unsigned char*) m_Data->data());
 
   MagickSetImageDepth(mw,8);
 
@@ -334,7 +334,7 @@ ptImage* ptImage::ptGMCOpenImage(const char*        FileName,
     for (int32_t i = 0; i < Size; i+=Step) {
       int32_t Length = (i+Step)<Size ? Step : Size - i;
       float* Buffer = &NewImage[i][0];
-      uint16_t* Image = &m_Data[i][0];
+      uint16_t* Image = &(*m_Data)[i][0];
       cmsDoTransform(Transform,
                      Buffer,
                      Image,
@@ -118,8 +118,8 @@ ptImage* ptImage::Lensfun(const int LfunActions, const lfModifier* LfunData) {
 
 
     if (LfunSuccess) {
-      m_Data.swap(TempData);
-      m_Image = (uint16_t (*)[3]) m_Data.data();
+      m_Data  = std::make_shared<TImage16Data>(std::move(TempData));
+      m_Image = (uint16_t (*)[3]) m_Data->data();
     } else {
       ptLogError(ptError_Lensfun, "Could not apply geometry/distortion correction.");
     }
@@ -0,0 +1,501 @@
+/*******************************************************************************
+**
+** Photivo
+**
+** Copyright (C) 2026 agent <agent@local>
+**
+** This file is part of Photivo.
+**
+** Photivo is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License version 3
+** as published by the Free Software Foundation.
+**
+** Photivo is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with Photivo.  If not, see <http://www.gnu.org/licenses/>.
+**
+*******************************************************************************/
+
+#include "ptLabKernels.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+//==============================================================================
+
+namespace ptLabKernels {
+
+namespace {
+
+const float CEpsilon = 216.0f/24389.0f;
+const float CKappa   = 24389.0f/27.0f;
+const float CPi      = 3.14159265358979f;
+
+// The kernels are written once for N lanes: four for the SSE2 baseline build,
+// eight (one register) for the AVX2 build.
+template <int N>
+struct TVec {
+  typedef float   F __attribute__((vector_size(N*sizeof(float))));
+  typedef int32_t I __attribute__((vector_size(N*sizeof(int32_t))));
+};
+
+// All helpers are inlined and take their vectors by reference, so no vector ever
+// crosses a call boundary. The by value returns still make GCC warn about the AVX ABI.
+#pragma GCC diagnostic ignored "-Wpsabi"
+#define PT_KERNEL inline __attribute__((always_inline))
+
+template <int N>
+PT_KERNEL typename TVec<N>::F vSplat(const float AValue) {
+  return typename TVec<N>::F{} + AValue;
+}
+
+template <int N>
+PT_KERNEL typename TVec<N>::F vSelect(const typename TVec<N>::I &AMask,
+                                      const typename TVec<N>::F &AYes,
+                                      const typename TVec<N>::F &ANo)
+{
+  typedef typename TVec<N>::F F;
+  typedef typename TVec<N>::I I;
+  return (F)(((I)AYes & AMask) | ((I)ANo & ~AMask));
+}
+
+template <int N>
+PT_KERNEL typename TVec<N>::F vClamp(const typename TVec<N>::F &AValue,
+                                     const float ALow, const float AHigh)
+{
+  const typename TVec<N>::F hLow  = vSplat<N>(ALow);
+  const typename TVec<N>::F hHigh = vSplat<N>(AHigh);
+  const typename TVec<N>::F hTmp  = vSelect<N>(AValue < hLow, hLow, AValue);
+  return vSelect<N>(hTmp > hHigh, hHigh, hTmp);
+}
+
+// Lane wise, the compilers turn this into one sqrtps.
+template <int N>
+PT_KERNEL typename TVec<N>::F vSqrt(const typename TVec<N>::F &AValue) {
+  typename TVec<N>::F hResult;
+  for (int i = 0; i < N; ++i) hResult[i] = sqrtf(AValue[i]);
+  return hResult;
+}
+
+//------------------------------------------------------------------------------
+// Cube root for values >= CEpsilon. The seed divides the exponent by three on the
+// bit pattern (about 3% off), two Halley steps bring that below 1e-7 relative,
+// far below the 16 bit quantisation of the results. The division by three is done
+// with shifts (x/4 * 4/3 as a product of (1 + 4^-2^k)), SSE2 has no vector division.
+template <int N>
+PT_KERNEL typename TVec<N>::F vCbrt(const typename TVec<N>::F &AValue) {
+  typedef typename TVec<N>::F F;
+  typedef typename TVec<N>::I I;
+  I hBits = (I)AValue >> 2;
+  hBits += hBits >> 2;
+  hBits += hBits >> 4;
+  hBits += hBits >> 8;
+  hBits += hBits >> 16;
+  F hRoot = (F)(hBits + 0x2a512ce3);
+  for (int i = 0; i < 2; ++i) {
+    const F hCube = hRoot*hRoot*hRoot;
+    hRoot = hRoot*(hCube + 2.0f*AValue)/(2.0f*hCube + AValue);
+  }
+  return hRoot;
+}
+
+//------------------------------------------------------------------------------
+
+template <int N>
+PT_KERNEL typename TVec<N>::F vLabF(const typename TVec<N>::F &AValue) {
+  typedef typename TVec<N>::F F;
+  const F hValue  = vSelect<N>(AValue < 0.0f, vSplat<N>(0.0f), AValue);
+  const F hLinear = (CKappa*hValue + 16.0f)*(1.0f/116.0f);
+  const F hRoot   = vCbrt<N>(vSelect<N>(hValue > CEpsilon, hValue, vSplat<N>(CEpsilon)));
+  return vSelect<N>(hValue > CEpsilon, hRoot, hLinear);
+}
+
+template <int N>
+PT_KERNEL typename TVec<N>::F vLabFInv(const typename TVec<N>::F &AValue) {
+  const typename TVec<N>::F hCube = AValue*AValue*AValue;
+  return vSelect<N>(hCube > CEpsilon, hCube, (116.0f*AValue - 16.0f)*(1.0f/CKappa));
+}
+
+//------------------------------------------------------------------------------
+
+// The pixels are handled in chunks: deinterleaved into float planes, converted a vector at
+// a time and written back. Building the vectors straight from scalars would stall on store
+// forwarding.
+const int CChunk = 256;
+
+struct TPlanes {
+  float C[3][CChunk] __attribute__((aligned(32)));
+};
+
+PT_KERNEL void load(const uint16_t (*APixels)[3], const int ACount, TPlanes &APlanes) {
+  for (int i = 0; i < ACount; ++i) {
+    APlanes.C[0][i] = APixels[i][0];
+    APlanes.C[1][i] = APixels[i][1];
+    APlanes.C[2][i] = APixels[i][2];
+  }
+}
+
+PT_KERNEL void store(uint16_t (*APixels)[3], const int ACount, const TPlanes &APlanes) {
+  // clamped before, so truncation is all that is left
+  for (int i = 0; i < ACount; ++i) {
+    APixels[i][0] = (uint16_t)(int32_t)APlanes.C[0][i];
+    APixels[i][1] = (uint16_t)(int32_t)APlanes.C[1][i];
+    APixels[i][2] = (uint16_t)(int32_t)APlanes.C[2][i];
+  }
+}
+
+template <int N>
+PT_KERNEL typename TVec<N>::F get(const TPlanes &APlanes, const int AChannel, const int AIdx) {
+  typename TVec<N>::F hResult;
+  memcpy(&hResult, &APlanes.C[AChannel][AIdx], sizeof(hResult));
+  return hResult;
+}
+
+template <int N>
+PT_KERNEL void put(TPlanes &APlanes, const int AChannel, const int AIdx,
+                   const typename TVec<N>::F &AValue) {
+  memcpy(&APlanes.C[AChannel][AIdx], &AValue, sizeof(AValue));
+}
+
+//------------------------------------------------------------------------------
+
+template <int N>
+PT_KERNEL void rgbToLabSpan(uint16_t (*APixels)[3], const size_t ACount,
+                            const float AToXyz[3][3])
+{
+  typedef typename TVec<N>::F F;
+  TPlanes hPlanes = {};
+  for (size_t hStart = 0; hStart < ACount; hStart += CChunk) {
+    const int hCount = (int)((ACount - hStart) < (size_t)CChunk ? ACount - hStart : CChunk);
+    load(APixels + hStart, hCount, hPlanes);
+
+    for (int i = 0; i < hCount; i += N) {
+      const F hR = get<N>(hPlanes, 0, i);
+      const F hG = get<N>(hPlanes, 1, i);
+      const F hB = get<N>(hPlanes, 2, i);
+
+      F hF[3];
+      for (int c = 0; c < 3; ++c)
+        hF[c] = vLabF<N>(AToXyz[c][0]*hR + AToXyz[c][1]*hG + AToXyz[c][2]*hB);
+
+      put<N>(hPlanes, 0, i, vClamp<N>(0xffff*(116.0f/100.0f*hF[1] - 16.0f/100.0f), 0.0f, 65535.0f));
+      put<N>(hPlanes, 1, i, vClamp<N>(0x101*(128.0f + 500.0f*(hF[0] - hF[1])),      0.0f, 65535.0f));
+      put<N>(hPlanes, 2, i, vClamp<N>(0x101*(128.0f + 200.0f*(hF[1] - hF[2])),      0.0f, 65535.0f));
+    }
+    store(APixels + hStart, hCount, hPlanes);
+  }
+}
+
+template <int N>
+PT_KERNEL void labToRgbSpan(uint16_t (*APixels)[3], const size_t ACount,
+                            const float AToRgb[3][3], const float AOffset[3])
+{
+  typedef typename TVec<N>::F F;
+  TPlanes hPlanes = {};
+  for (size_t hStart = 0; hStart < ACount; hStart += CChunk) {
+    const int hCount = (int)((ACount - hStart) < (size_t)CChunk ? ACount - hStart : CChunk);
+    load(APixels + hStart, hCount, hPlanes);
+
+    for (int i = 0; i < hCount; i += N) {
+      const F hL = get<N>(hPlanes, 0, i)*(100.0f/0xffff);
+      const F hA = (get<N>(hPlanes, 1, i) - (float)0x8080)*(128.0f/0x8080);
+      const F hB = (get<N>(hPlanes, 2, i) - (float)0x8080)*(128.0f/0x8080);
+
+      const F hFy = (hL + 16.0f)*(1.0f/116.0f);
+      F hXyz[3];
+      hXyz[0] = vLabFInv<N>(hA*(1.0f/500.0f) + hFy);
+      hXyz[1] = vSelect<N>(hL <= CKappa*CEpsilon, hL*(1.0f/CKappa), hFy*hFy*hFy);
+      hXyz[2] = vLabFInv<N>(hFy - hB*(1.0f/200.0f));
+
+      for (int c = 0; c < 3; ++c)
+        put<N>(hPlanes, c, i,
+               vClamp<N>(AToRgb[c][0]*hXyz[0] + AToRgb[c][1]*hXyz[1] + AToRgb[c][2]*hXyz[2] +
+                         AOffset[c], 0.0f, 65535.0f));
+    }
+    store(APixels + hStart, hCount, hPlanes);
+  }
+}
+
+//------------------------------------------------------------------------------
+// Polar kernels. atan() is a minimax polynomial on [0,1] after folding the octants
+// (below 3e-6 rad, well under a step of the 0x7fff/pi hue curves); sin() and cos() are
+// Taylor polynomials on [-pi/4,pi/4] after the quadrant reduction (below 1e-6).
+
+template <int N>
+PT_KERNEL typename TVec<N>::F vAtan2(const typename TVec<N>::F &AY, const typename TVec<N>::F &AX) {
+  typedef typename TVec<N>::F F;
+  const F hAbsX = vSelect<N>(AX < 0.0f, -AX, AX);
+  const F hAbsY = vSelect<N>(AY < 0.0f, -AY, AY);
+  const F hMax  = vSelect<N>(hAbsX > hAbsY, hAbsX, hAbsY);
+  const F hMin  = vSelect<N>(hAbsX > hAbsY, hAbsY, hAbsX);
+  // grey: 0/1 gives a hue of 0 like ToHue()
+  const F hT    = hMin/vSelect<N>(hMax > 0.0f, hMax, vSplat<N>(1.0f));
+  const F hT2   = hT*hT;
+  F hAngle = hT*(0.99997726f + hT2*(-0.33262347f + hT2*(0.19354346f +
+                 hT2*(-0.11643287f + hT2*(0.05265332f + hT2*(-0.01172120f))))));
+  hAngle = vSelect<N>(hAbsY > hAbsX, CPi/2 - hAngle, hAngle);
+  hAngle = vSelect<N>(AX < 0.0f, CPi - hAngle, hAngle);
+  return vSelect<N>(AY < 0.0f, -hAngle, hAngle);
+}
+
+template <int N>
+PT_KERNEL void vSinCos(const typename TVec<N>::F &AAngle,
+                       typename TVec<N>::F &ASin, typename TVec<N>::F &ACos)
+{
+  typedef typename TVec<N>::F F;
+  typedef typename TVec<N>::I I;
+  // quadrant: no conversion in the vector extensions, the lanes are converted one by one
+  const F hQ = AAngle*(2.0f/CPi);
+  I hQuadrant;
+  F hQuadrantF;
+  for (int i = 0; i < N; ++i) {
+    hQuadrant[i]  = (int32_t)floorf(hQ[i] + 0.5f);
+    hQuadrantF[i] = (float)hQuadrant[i];
+  }
+  // two part pi/2 keeps the reduction exact for the angles that occur here
+  const F hR  = (AAngle - hQuadrantF*1.5703125f) - hQuadrantF*4.83826794897e-4f;
+  const F hR2 = hR*hR;
+  const F hSin = hR*(1.0f + hR2*(-1.0f/6 + hR2*(1.0f/120 + hR2*(-1.0f/5040 + hR2*(1.0f/362880)))));
+  const F hCos = 1.0f + hR2*(-0.5f + hR2*(1.0f/24 + hR2*(-1.0f/720 + hR2*(1.0f/40320))));
+
+  const I hSwap   = (hQuadrant & 1) != 0;
+  const I hNegSin = (hQuadrant & 2) != 0;
+  const I hNegCos = ((hQuadrant + 1) & 2) != 0;
+  ASin = vSelect<N>(hSwap, hCos, hSin);
+  ACos = vSelect<N>(hSwap, hSin, hCos);
+  ASin = vSelect<N>(hNegSin, -ASin, ASin);
+  ACos = vSelect<N>(hNegCos, -ACos, ACos);
+}
+
+template <int N>
+PT_KERNEL void labToPolarSpan(const uint16_t (*APixels)[3], const size_t ACount,
+                              const float ANeutral, float *AChroma, float *AHue)
+{
+  typedef typename TVec<N>::F F;
+  TPlanes hPlanes = {};
+  for (size_t hStart = 0; hStart < ACount; hStart += CChunk) {
+    const int hCount = (int)((ACount - hStart) < (size_t)CChunk ? ACount - hStart : CChunk);
+    load(APixels + hStart, hCount, hPlanes);
+
+    for (int i = 0; i < hCount; i += N) {
+      const F hA = get<N>(hPlanes, 1, i) - ANeutral;
+      const F hB = get<N>(hPlanes, 2, i) - ANeutral;
+      F hHue = vAtan2<N>(hB, hA);
+      hHue = vSelect<N>(hHue < 0.0f, hHue + 2*CPi, hHue);
+      put<N>(hPlanes, 0, i, vSqrt<N>(hA*hA + hB*hB));
+      put<N>(hPlanes, 1, i, hHue);
+    }
+    memcpy(AChroma + hStart, hPlanes.C[0], hCount*sizeof(float));
+    memcpy(AHue    + hStart, hPlanes.C[1], hCount*sizeof(float));
+  }
+}
+
+template <int N>
+PT_KERNEL void polarToLabSpan(uint16_t (*APixels)[3], const size_t ACount,
+                              const float ANeutral, const float *AChroma, const float *AHue)
+{
+  typedef typename TVec<N>::F F;
+  TPlanes hPlanes = {};
+  for (size_t hStart = 0; hStart < ACount; hStart += CChunk) {
+    const int hCount = (int)((ACount - hStart) < (size_t)CChunk ? ACount - hStart : CChunk);
+    memcpy(hPlanes.C[0], AChroma + hStart, hCount*sizeof(float));
+    memcpy(hPlanes.C[1], AHue    + hStart, hCount*sizeof(float));
+
+    for (int i = 0; i < hCount; i += N) {
+      const F hChroma = get<N>(hPlanes, 0, i);
+      F hSin, hCos;
+      vSinCos<N>(get<N>(hPlanes, 1, i), hSin, hCos);
+      put<N>(hPlanes, 1, i, vClamp<N>(hChroma*hCos + ANeutral, 0.0f, 65535.0f));
+      put<N>(hPlanes, 2, i, vClamp<N>(hChroma*hSin + ANeutral, 0.0f, 65535.0f));
+    }
+    // L stays
+    for (int i = 0; i < hCount; ++i) {
+      APixels[hStart + i][1] = (uint16_t)(int32_t)hPlanes.C[1][i];
+      APixels[hStart + i][2] = (uint16_t)(int32_t)hPlanes.C[2][i];
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+// Baseline and AVX2 builds of the same kernels.
+
+void rgbToLabBase(uint16_t (*APixels)[3], const size_t ACount, const float AToXyz[3][3]) {
+  rgbToLabSpan<4>(APixels, ACount, AToXyz);
+}
+
+void labToRgbBase(uint16_t (*APixels)[3], const size_t ACount,
+                  const float AToRgb[3][3], const float AOffset[3]) {
+  labToRgbSpan<4>(APixels, ACount, AToRgb, AOffset);
+}
+
+void labToPolarBase(const uint16_t (*APixels)[3], const size_t ACount,
+                    const float ANeutral, float *AChroma, float *AHue) {
+  labToPolarSpan<4>(APixels, ACount, ANeutral, AChroma, AHue);
+}
+
+void polarToLabBase(uint16_t (*APixels)[3], const size_t ACount,
+                    const float ANeutral, const float *AChroma, const float *AHue) {
+  polarToLabSpan<4>(APixels, ACount, ANeutral, AChroma, AHue);
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+#define PT_LAB_DISPATCH
+
+__attribute__((target("avx2,fma")))
+void rgbToLabAvx2(uint16_t (*APixels)[3], const size_t ACount, const float AToXyz[3][3]) {
+  rgbToLabSpan<8>(APixels, ACount, AToXyz);
+}
+
+__attribute__((target("avx2,fma")))
+void labToRgbAvx2(uint16_t (*APixels)[3], const size_t ACount,
+                  const float AToRgb[3][3], const float AOffset[3]) {
+  labToRgbSpan<8>(APixels, ACount, AToRgb, AOffset);
+}
+
+__attribute__((target("avx2,fma")))
+void labToPolarAvx2(const uint16_t (*APixels)[3], const size_t ACount,
+                    const float ANeutral, float *AChroma, float *AHue) {
+  labToPolarSpan<8>(APixels, ACount, ANeutral, AChroma, AHue);
+}
+
+__attribute__((target("avx2,fma")))
+void polarToLabAvx2(uint16_t (*APixels)[3], const size_t ACount,
+                    const float ANeutral, const float *AChroma, const float *AHue) {
+  polarToLabSpan<8>(APixels, ACount, ANeutral, AChroma, AHue);
+}
+
+bool hasAvx2() {
+  static const bool hAvx2 = [] {
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+  }();
+  return hAvx2;
+}
+#endif
+
+} // namespace
+
+//==============================================================================
+
+void rgbToLab(uint16_t (*APixels)[3], const size_t ACount, const float AToXyz[3][3]) {
+#ifdef PT_LAB_DISPATCH
+  if (hasAvx2()) return rgbToLabAvx2(APixels, ACount, AToXyz);
+#endif
+  rgbToLabBase(APixels, ACount, AToXyz);
+}
+
+//------------------------------------------------------------------------------
+
+void labToRgb(uint16_t (*APixels)[3], const size_t ACount,
+              const float AToRgb[3][3], const float AOffset[3])
+{
+#ifdef PT_LAB_DISPATCH
+  if (hasAvx2()) return labToRgbAvx2(APixels, ACount, AToRgb, AOffset);
+#endif
+  labToRgbBase(APixels, ACount, AToRgb, AOffset);
+}
+
+//------------------------------------------------------------------------------
+
+void labToPolar(const uint16_t (*APixels)[3], const size_t ACount,
+                const float ANeutral, float *AChroma, float *AHue)
+{
+#ifdef PT_LAB_DISPATCH
+  if (hasAvx2()) return labToPolarAvx2(APixels, ACount, ANeutral, AChroma, AHue);
+#endif
+  labToPolarBase(APixels, ACount, ANeutral, AChroma, AHue);
+}
+
+//------------------------------------------------------------------------------
+
+void polarToLab(uint16_t (*APixels)[3], const size_t ACount,
+                const float ANeutral, const float *AChroma, const float *AHue)
+{
+#ifdef PT_LAB_DISPATCH
+  if (hasAvx2()) return polarToLabAvx2(APixels, ACount, ANeutral, AChroma, AHue);
+#endif
+  polarToLabBase(APixels, ACount, ANeutral, AChroma, AHue);
+}
+
+//------------------------------------------------------------------------------
+
+const char *isaName() {
+#ifdef PT_LAB_DISPATCH
+  if (hasAvx2()) return "avx2";
+#endif
+  return "baseline";
+}
+
+//==============================================================================
+
+void rgbToLabReference(uint16_t (*APixels)[3], const size_t ACount,
+                       const double AMatrix[3][3], const double AWhite[3])
+{
+  static double hTable[0x20000];
+  static bool   hInited = false;
+  if (!hInited) {
+    for (uint32_t i = 0; i < 0x20000; i++) {
+      const double r = (double)i/0xffff;
+      hTable[i] = r > 216.0/24389.0 ? pow(r,1/3.0) : (24389.0/27.0*r + 16.0)/116.0;
+    }
+    hInited = true;
+  }
+
+  for (size_t i = 0; i < ACount; i++) {
+    double xyz[3];
+    for (short c = 0; c < 3; c++) {
+      xyz[c] = (AMatrix[c][0]*APixels[i][0] +
+                AMatrix[c][1]*APixels[i][1] +
+                AMatrix[c][2]*APixels[i][2]) / AWhite[c];
+      xyz[c] = hTable[std::min((int32_t)0x1ffff, (int32_t)std::max(0.0, xyz[c] + 0.5))];
+    }
+    const int32_t L = (int32_t)(0xffff*(116.0/100.0*xyz[1] - 16.0/100.0));
+    const int32_t a = (int32_t)(0x101*(128.0 + 500.0*(xyz[0] - xyz[1])));
+    const int32_t b = (int32_t)(0x101*(128.0 + 200.0*(xyz[1] - xyz[2])));
+    APixels[i][0] = std::max(0, std::min(0xffff, L));
+    APixels[i][1] = std::max(0, std::min(0xffff, a));
+    APixels[i][2] = std::max(0, std::min(0xffff, b));
+  }
+}
+
+//------------------------------------------------------------------------------
+
+void labToRgbReference(uint16_t (*APixels)[3], const size_t ACount,
+                       const double AMatrix[3][3], const double AWhite[3])
+{
+  const double epsilon = 216.0/24389.0;
+  const double kappa   = 24389.0/27.0;
+
+  for (size_t i = 0; i < ACount; i++) {
+    const double L = APixels[i][0]*100.0/0xffff;
+    const double a = (APixels[i][1] - 0x8080)/((double)0x8080/128.0);
+    const double b = (APixels[i][2] - 0x8080)/((double)0x8080/128.0);
+
+    const double Tmp1 = (L + 16.0)/116.0;
+    const double yr   = (L <= kappa*epsilon) ? (L/kappa) : (Tmp1*Tmp1*Tmp1);
+    const double fy   = (yr <= epsilon) ? ((kappa*yr + 16.0)/116.0) : Tmp1;
+    const double fz   = fy - b/200.0;
+    const double fx   = a/500.0 + fy;
+    const double fz3  = fz*fz*fz;
+    const double fx3  = fx*fx*fx;
+    const double zr   = (fz3 <= epsilon) ? ((116.0*fz - 16.0)/kappa) : fz3;
+    const double xr   = (fx3 <= epsilon) ? ((116.0*fx - 16.0)/kappa) : fx3;
+
+    const double xyz[3] = { xr*AWhite[0]*65535.0 - 0.5,
+                            yr*AWhite[1]*65535.0 - 0.5,
+                            zr*AWhite[2]*65535.0 - 0.5 };
+    for (short c = 0; c < 3; c++) {
+      const int32_t Value = (int32_t)(AMatrix[c][0]*xyz[0] +
+                                      AMatrix[c][1]*xyz[1] +
+                                      AMatrix[c][2]*xyz[2]);
+      APixels[i][c] = std::max(0, std::min(0xffff, Value));
+    }
+  }
+}
+
+} // namespace ptLabKernels
@@ -0,0 +1,71 @@
+/*******************************************************************************
+**
+** Photivo
+**
+** Copyright (C) 2026 agent <agent@local>
+**
+** This file is part of Photivo.
+**
+** Photivo is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License version 3
+** as published by the Free Software Foundation.
+**
+** Photivo is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with Photivo.  If not, see <http://www.gnu.org/licenses/>.
+**
+*******************************************************************************/
+
+#ifndef PTLABKERNELS_H
+#define PTLABKERNELS_H
+
+#include <cstddef>
+#include <cstdint>
+
+//==============================================================================
+
+/*! Vectorised float32 kernels for the matrix based RGB <-> Lab and the Lab <-> LCh conversions
+    of ptImage.
+    They work on spans of interleaved 16 bit pixels in place, eight pixels per step, and are
+    compiled once for the baseline instruction set and once for AVX2/FMA. The variant is picked
+    at runtime from the CPU features. The reference functions are the former double precision
+    implementations, kept to benchmark and check the kernels against.
+ */
+namespace ptLabKernels {
+
+/*! RGB -> Lab. \c AToXyz maps 16 bit RGB to XYZ relative to the reference white,
+    i.e. the RGB->XYZ matrix with row \c r divided by \c white[r]*0xffff. */
+void rgbToLab(uint16_t (*APixels)[3], const size_t ACount, const float AToXyz[3][3]);
+
+/*! Lab -> RGB. \c AToRgb maps XYZ relative to the reference white to 16 bit RGB,
+    i.e. the XYZ->RGB matrix with column \c c multiplied by \c white[c]*0xffff.
+    \c AOffset is added to each RGB value before clipping. */
+void labToRgb(uint16_t (*APixels)[3], const size_t ACount,
+              const float AToRgb[3][3], const float AOffset[3]);
+
+/*! Lab -> chroma and hue, a and b taken around \c ANeutral. The hue is in [0,2pi), 0 for
+    grey pixels like the former atan2() code. \c AChroma and \c AHue get \c ACount values. */
+void labToPolar(const uint16_t (*APixels)[3], const size_t ACount,
+                const float ANeutral, float *AChroma, float *AHue);
+
+/*! Chroma and hue (any angle) -> a and b around \c ANeutral, clipped. L is left alone. */
+void polarToLab(uint16_t (*APixels)[3], const size_t ACount,
+                const float ANeutral, const float *AChroma, const float *AHue);
+
+/*! Name of the instruction set the kernels run with on this CPU. */
+const char *isaName();
+
+/*! Double precision reference, same signatures as above but with the unfolded matrices
+    and reference white. */
+void rgbToLabReference(uint16_t (*APixels)[3], const size_t ACount,
+                       const double AMatrix[3][3], const double AWhite[3]);
+void labToRgbReference(uint16_t (*APixels)[3], const size_t ACount,
+                       const double AMatrix[3][3], const double AWhite[3]);
+
+} // namespace ptLabKernels
+
+#endif // PTLABKERNELS_H
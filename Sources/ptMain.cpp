@@ -25,6 +25,7 @@
 #include "ptDefines.h"
 #include "ptInfo.h"
 #include "ptCalloc.h"
+#include "ptCmsTransformCache.h"
 #include "ptConfirmRequest.h"
 #include "ptConstants.h"
 #include "ptMessageBox.h"
@@ -43,6 +44,9 @@
 #include "ptWiener.h"
 #include "ptParseCli.h"
 #include "ptImageHelper.h"
+#include "ptProfiler.h"
+#include "ptRawIndex.h"
+#include "ptBench.h"
 #include "filters/imagespot/ptTuningSpot.h"
 #include "qtsingleapplication/qtsingleapplication.h"
 #include "filemgmt/ptFileMgrWindow.h"
@@ -104,6 +108,8 @@ cmsCIExyY       D65;
 cmsCIExyY       D50;
 // precalculated color transform
 cmsHTRANSFORM ToPreviewTransform = NULL;
+ptCmsTransform ToPreviewTransformRef;
+ptCmsLut ToPreviewLut;   // set instead of the transform for "high res pre calc"
 void ReadSidecar(const QString& Sidecar);
 void SetRatingFromXmp();
 void SetTagsFromXmp();
@@ -151,6 +157,7 @@ ptSettings    *Settings = NULL;
 // Run mode
 short NextPhase;
 short NextSubPhase;
+short UpdatePending = 0; // a request came in while the pipe was running
 short ImageSaved;
 short ImageCleanUp;
 
@@ -263,6 +270,7 @@ short  ReadJobFile(const QString FileName);
 void   WriteOut();
 void   UpdatePreviewImage(const ptImage* ForcedImage   = NULL,
                           const short    OnlyHistogram = 0);
+void   RunProxyPreview(const short Phase);
 void   UpdateCropToolUI();
 void   PreCalcTransforms();
 void   CB_ZoomFitButton();
@@ -290,6 +298,7 @@ int    photivoMain(int Argc, char *Argv[]);
 void   CleanupResources();
 void copyFolder(QString sourceFolder, QString destFolder);
 void CB_PixelReader(const QPointF Point, const ptPixelReading PixelReading);
+void CB_Viewport(const QRect Visible);
 bool GBusy = false;
 
 // undo-redo & clipboard support
@@ -420,9 +429,53 @@ void ReportProgress(const QString Message) {
   MainWindow->StatusLabel->repaint();
   // Workaround to keep the GUI responsive
   // during pipe processing...
-  QApplication::processEvents(QEventLoop::ExcludeUserInputEvents);
+  // An interactive run can be superseded by a new setting, so the filter
+  // controls get user input as well (see ptPipeInputFilter).
+  if (TheProcessor && TheProcessor->IsCancellable()) {
+    QApplication::processEvents();
+  } else {
+    QApplication::processEvents(QEventLoop::ExcludeUserInputEvents);
+  }
 }
 
+////////////////////////////////////////////////////////////////////////////////
+//
+// Input filter for interactive pipe runs.
+// Only the filter configuration widgets (and their popups) may take user input
+// while the pipe is running. Everything else, also the other controls in the
+// processing tabs, could pull the images from under the processor. That input
+// is dropped like on a busy widget.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+class ptPipeInputFilter: public QObject {
+protected:
+  bool eventFilter(QObject *AObject, QEvent *AEvent) {
+    if (!TheProcessor || !TheProcessor->IsCancellable()) return false;
+
+    switch (AEvent->type()) {
+      case QEvent::MouseButtonPress:
+      case QEvent::MouseButtonRelease:
+      case QEvent::MouseButtonDblClick:
+      case QEvent::KeyPress:
+      case QEvent::KeyRelease:
+      case QEvent::Wheel:
+      case QEvent::ContextMenu:
+      case QEvent::Shortcut:
+        break;
+      default:
+        return false;
+    }
+
+    if (QApplication::activePopupWidget()) return false;
+
+    for (QObject* hObject = AObject; hObject; hObject = hObject->parent()) {
+      if (qobject_cast<ptToolBox*>(hObject)) return false;
+    }
+    return true;
+  }
+};
+
 ////////////////////////////////////////////////////////////////////////////////
 //
 // Main : instantiating toplevel windows, settings and options ..
@@ -573,6 +626,7 @@ int photivoMain(int Argc, char *Argv[]) {
 "Syntax: photivo [inputfile | -i imagefile | -j jobfile |\n"
 "                 --load-and-delete imagefile]\n"
 "                [--pts ptsfile] [--sidecar sidecarfile] [-h] [--new-instance]\n"
+"                [--profile outputfile] [--bench presets]\n"
 "Options:\n"
 "inputfile\n"
 "      Specify the image or settings file to load. Works like -i for image files\n"
@@ -595,12 +649,21 @@ int photivoMain(int Argc, char *Argv[]) {
 "      running Photivo. Job files are always opened in a new instance.\n"
 "--no-fmgr or -p\n"
 "      Prevent auto-open file manager when Photivo starts.\n"
+"--profile outputfile\n"
+"      Record time and memory of every filter and DcRaw step and write them to\n"
+"      outputfile after each pipe run. Chrome trace JSON, or a summary for *.csv.\n"
+"--bench presets\n"
+"      Run the full size pipe on synthetic 12, 24 and 50 MP inputs with each\n"
+"      settings file in presets (a .pts file or a directory) and print the\n"
+"      time and memory of every step, after timing the demosaicing algorithms\n"
+"      at 1, 2, 4 ... threads with their error against the synthetic scene.\n"
+"      Needs no GUI.\n"
 "--help or -h\n"
 "      Display this usage information.\n\n"
 "For more documentation visit the wiki: http://photivo.org/photivo/start\n"
   ) + "</pre>";
 
-  ptCliCommands cli = { cliNoAction, "", "", "", false, false };
+  ptCliCommands cli = { cliNoAction, "", "", "", false, false, "" };
 
 #ifdef Q_OS_MAC
 //Just Skip if engaged by QFileOpenEvent
@@ -620,7 +683,7 @@ int photivoMain(int Argc, char *Argv[]) {
   }
 
   ImageCleanUp = cli.Mode == cliLoadAndDelImage;
-  JobMode = cli.Mode == cliProcessJob;
+  JobMode = cli.Mode == cliProcessJob || cli.Mode == cliBench; // bench runs like a job
   PtsFileToOpen = cli.PtsFilename;
 
   if (JobMode) {
@@ -634,6 +697,10 @@ int photivoMain(int Argc, char *Argv[]) {
     Sidecar = cli.Sidecar;
   }
 
+  if (cli.ProfileFilename != "") {
+    GProfiler->setOutputFile(cli.ProfileFilename);
+  }
+
   // QtSingleInstance, add CLI-Switch to skip and allow multiple instances
   // JobMode is always run in a new instance
   // Sent messages are handled by ptMainWindow::OtherInstanceMessage
@@ -849,6 +916,9 @@ int photivoMain(int Argc, char *Argv[]) {
   Settings->SetValue("MainDirectory",QCoreApplication::applicationDirPath().append("/"));
   Settings->SetValue("Sidecar", Sidecar);
 
+  // Identify results of raw files seen before
+  ptRawIndex::instance()->setFileName(UserDirectory + "rawindex.dat");
+
   // Set paths once with first start
   if (FirstStart == 1) {
       Settings->SetValue("RawsDirectory", UserDirectory);
@@ -887,7 +957,11 @@ int photivoMain(int Argc, char *Argv[]) {
   // (And thus have to run a batch job)
 
   if (JobMode) {
+    if (cli.Mode == cliBench) {
+      exit(ptBench().run(JobFileName));
+    }
     RunJob(JobFileName);
+    ptRawIndex::instance()->save();
     exit(EXIT_SUCCESS);
   }
 
@@ -932,6 +1006,7 @@ int photivoMain(int Argc, char *Argv[]) {
       new ptViewWindow(MainWindow->ViewFrameCentralWidget, MainWindow);
 
   ViewWindow->SetPixelReader(CB_PixelReader);
+  ViewWindow->SetViewportHandler(CB_Viewport);
 
   HistogramWindow =
       new ptHistogramWindow(NULL,MainWindow->HistogramFrameCentralWidget);
@@ -1110,6 +1185,8 @@ void CB_Event0() {
   NextPhase = ptProcessorPhase_Raw;
   NextSubPhase = ptProcessorPhase_Load;
   ImageSaved = 0;
+  if (Settings->GetInt("JobMode") == 0)
+    qApp->installEventFilter(new ptPipeInputFilter);
 
   PreCalcTransforms();
 
@@ -1184,59 +1261,31 @@ void CB_Event0() {
 ////////////////////////////////////////////////////////////////////////////////
 
 void PreCalcTransforms() {
-  cmsToneCurve* Gamma = cmsBuildGamma(NULL, 1.0);
-  cmsToneCurve* Gamma3[3];
-  Gamma3[0] = Gamma3[1] = Gamma3[2] = Gamma;
-
-  cmsHPROFILE InProfile = 0;
-
-  cmsCIExyY DFromReference;
-
-  switch (Settings->GetInt("WorkColor")) {
-    case ptSpace_sRGB_D65 :
-    case ptSpace_AdobeRGB_D65 :
-      DFromReference = D65;
-      break;
-    case ptSpace_WideGamutRGB_D50 :
-    case ptSpace_ProPhotoRGB_D50 :
-      DFromReference = D50;
-      break;
-    default:
-      assert(0);
-  }
-
   ptImage::setCurrentRGB(Settings->GetInt("WorkColor"));
 
-  InProfile = cmsCreateRGBProfile(&DFromReference,
-                                  (cmsCIExyYTRIPLE*)&RGBPrimaries[Settings->GetInt("WorkColor")],
-                                  Gamma3);
-
-  if (!InProfile) {
-    ptLogError(ptError_Profile,"Could not open InProfile profile.");
-    return;
-  }
-
-  cmsFreeToneCurve(Gamma);
-
-  if (Settings->GetInt("CMQuality") == ptCMQuality_HighResPreCalc) {
-    ToPreviewTransform =
-      cmsCreateTransform(InProfile,
-                         TYPE_RGB_16,
-                         PreviewColorProfile,
-                         TYPE_RGB_16,
-                         Settings->GetInt("PreviewColorProfileIntent"),
-                         cmsFLAGS_HIGHRESPRECALC | cmsFLAGS_BLACKPOINTCOMPENSATION);
-  } else { // fast sRGB preview also uses the not optimized profile for output
-    ToPreviewTransform =
-      cmsCreateTransform(InProfile,
-                         TYPE_RGB_16,
-                         PreviewColorProfile,
-                         TYPE_RGB_16,
-                         Settings->GetInt("PreviewColorProfileIntent"),
-                         cmsFLAGS_NOOPTIMIZE | cmsFLAGS_BLACKPOINTCOMPENSATION);
-  }
-
-  cmsCloseProfile(InProfile);
+  // The cache keeps the transforms for the other working spaces and profiles,
+  // so switching back and forth does not build them again.
+  ptCmsEnd WorkEnd    = ptCmsEnd::workspace(Settings->GetInt("WorkColor"));
+  ptCmsEnd PreviewEnd = ptCmsEnd::profile(PreviewColorProfile);
+  ToPreviewTransformRef =
+    ptCmsTransformCache::instance()->get(
+      WorkEnd,    TYPE_RGB_16,
+      PreviewEnd, TYPE_RGB_16,
+      Settings->GetInt("PreviewColorProfileIntent"),
+      cmsFLAGS_NOOPTIMIZE | cmsFLAGS_BLACKPOINTCOMPENSATION);
+  ToPreviewTransform = ToPreviewTransformRef.get();
+  if (!ToPreviewTransform)
+    ptLogError(ptError_Profile,"Could not create preview colour transform.");
+
+  // "High res pre calc" bakes the transform into a lookup table, see ptColorLut;
+  // fast sRGB preview does not use the transform at all.
+  ToPreviewLut =
+    Settings->GetInt("CMQuality") == ptCMQuality_HighResPreCalc ?
+      ptCmsTransformCache::instance()->lut(
+        WorkEnd, PreviewEnd,
+        Settings->GetInt("PreviewColorProfileIntent"),
+        cmsFLAGS_NOOPTIMIZE | cmsFLAGS_BLACKPOINTCOMPENSATION) :
+      ptCmsLut();
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -1294,9 +1343,15 @@ void Update(short Phase,
 
   if (Settings->GetInt("BlockUpdate") == 1) return; // hard block
   if (Settings->GetInt("PipeIsRunning") == 1) {
-    // record that we got here with the new settings
-    // and make sure the pipe is run after the current
-    // pass automatically -> timer
+    // record that we got here with the new settings,
+    // stop the stale run and let the running Update()
+    // start the pipe again from the earliest phase.
+    if (Phase < ptProcessorPhase_Preview) {
+      if (Phase < NextPhase) NextPhase = Phase;
+      if (SubPhase > 0 && SubPhase < NextSubPhase) NextSubPhase = SubPhase;
+      UpdatePending = 1;
+      if (TheProcessor) TheProcessor->RequestCancel();
+    }
     return;
   } else Settings->SetValue("PipeIsRunning",1);
 
@@ -1313,9 +1368,24 @@ void Update(short Phase,
         ImageSaved = 0;
         MainWindow->UpdateSettings();
         if(Settings->GetInt("HaveImage")==1) {
-          if (NextPhase < ptProcessorPhase_Output)
-            TheProcessor->Run(NextPhase, NextSubPhase, WithIdentify, ProcessorMode);
-          UpdatePreviewImage();
+          // Rerun as long as newer requests come in. NextPhase is only reset
+          // after a complete run, so a superseded run continues from whichever
+          // phase is earlier.
+          do {
+            // A rerun takes the settings changed meanwhile.
+            if (UpdatePending) MainWindow->UpdateSettings();
+            UpdatePending = 0;
+            // Coarse result first for the tab stages, then refine at pipe size.
+            if (ProcessorMode == ptProcessorMode_Preview)
+              RunProxyPreview(NextPhase);
+            if (UpdatePending) continue;
+            if (NextPhase < ptProcessorPhase_Output)
+              TheProcessor->Run(NextPhase, NextSubPhase, WithIdentify, ProcessorMode);
+            if (UpdatePending) continue;
+            NextPhase = ptProcessorPhase_Output;
+            NextSubPhase = ptProcessorPhase_Highlights;
+            UpdatePreviewImage();
+          } while (UpdatePending);
         }
         NextPhase = ptProcessorPhase_Output;
         NextSubPhase = ptProcessorPhase_Highlights;
@@ -1352,6 +1422,11 @@ void Update(short Phase,
   }
   Settings->SetValue("PipeIsRunning",0);
 
+  // The view may have moved while the pipe was busy.
+  if (!JobMode && ViewWindow && Phase < ptProcessorPhase_Preview) {
+    CB_Viewport(ViewWindow->visibleImageRect());
+  }
+
 #ifdef Q_OS_WIN
   if (!JobMode) {
     Win7Taskbar->setProgressState(ptEcWin7::NoProgress);
@@ -1622,88 +1697,114 @@ void AfterAll(ptImage* Image, const short FinalRun = 0, const short Resize = 1)
 void EndSharpen(ptImage* Image, cmsHPROFILE Profile, const int Intent) {
   ReportProgress(QObject::tr("Wiener Filter"));
   int InColorSpace = Image->m_ColorSpace;
-  cmsHPROFILE InternalProfile = 0;
-  if (Profile == NULL || InColorSpace != ptSpace_Profiled) {
-    // linear case
-    cmsToneCurve* Gamma = cmsBuildGamma(NULL, 1.0);
-    cmsToneCurve* Gamma3[3];
-    Gamma3[0] = Gamma3[1] = Gamma3[2] = Gamma;
-
-    cmsCIExyY       DFromReference;
-
-    switch (Image->m_ColorSpace) {
-      case ptSpace_sRGB_D65 :
-      case ptSpace_AdobeRGB_D65 :
-        DFromReference = D65;
-        break;
-      case ptSpace_WideGamutRGB_D50 :
-      case ptSpace_ProPhotoRGB_D50 :
-        DFromReference = D50;
-        break;
-      default:
-        assert(0);
-    }
-
-    InternalProfile = cmsCreateRGBProfile(&DFromReference,
-                                    (cmsCIExyYTRIPLE*)&RGBPrimaries[Image->m_ColorSpace],
-                                    Gamma3);
-
-    if (!InternalProfile) {
-      ptLogError(ptError_Profile,"Could not open InternalProfile profile.");
-      return;
-    }
-
-    cmsFreeToneCurve(Gamma);
-  } else {
-    // profiled case
-    InternalProfile = Profile;
+  // linear working space or the given profile
+  ptCmsEnd InternalEnd = (Profile == NULL || InColorSpace != ptSpace_Profiled) ?
+                         ptCmsEnd::workspace(Image->m_ColorSpace) :
+                         ptCmsEnd::profile(Profile);
+  ptCmsTransform ToLab =
+    ptCmsTransformCache::instance()->get(InternalEnd, TYPE_RGB_16,
+                                         ptCmsEnd::lab(), TYPE_Lab_16,
+                                         Intent,
+                                         cmsFLAGS_NOOPTIMIZE | cmsFLAGS_BLACKPOINTCOMPENSATION);
+  ptCmsTransform FromLab =
+    ptCmsTransformCache::instance()->get(ptCmsEnd::lab(), TYPE_Lab_16,
+                                         InternalEnd, TYPE_RGB_16,
+                                         Intent,
+                                         cmsFLAGS_NOOPTIMIZE | cmsFLAGS_BLACKPOINTCOMPENSATION);
+  if (!ToLab || !FromLab) {
+    ptLogError(ptError_Profile,"Could not create colour transform.");
+    return;
   }
 
-  cmsHPROFILE LabProfile = 0;
-  LabProfile = cmsCreateLab4Profile(NULL);
-  // to Lab
-  cmsHTRANSFORM Transform;
-  Transform = cmsCreateTransform(InternalProfile,
-                                 TYPE_RGB_16,
-                                 LabProfile,
-                                 TYPE_Lab_16,
-                                 Intent,
-                                 cmsFLAGS_NOOPTIMIZE | cmsFLAGS_BLACKPOINTCOMPENSATION);
+  // The Wiener filter only changes L, with "only edges" just for a part of the pixels.
+  // The pixels it leaves alone get their RGB back from a copy instead of the inverse
+  // transform, which also spares them the round trip error.
+  Image->toUInt16()->toInterleaved();
+  Image->detach();
+  const TImage16Data RGBCopy(*Image->m_Data);
 
+  // to Lab
   int32_t Size = Image->m_Width*Image->m_Height;
   int32_t Step = 100000;
+  std::vector<uint16_t> LBefore(Size);
 #pragma omp parallel for schedule(static)
   for (int32_t i = 0; i < Size; i+=Step) {
     int32_t Length = (i+Step)<Size ? Step : Size - i;
     uint16_t* Tile = &(Image->m_Image[i][0]);
-    cmsDoTransform(Transform,Tile,Tile,Length);
+    cmsDoTransform(ToLab.get(),Tile,Tile,Length);
+    for (int32_t k = i; k < i+Length; k++) LBefore[k] = Image->m_Image[k][0];
   }
   Image->m_ColorSpace = ptSpace_Lab;
   // Wiener Filter
   GFilterDM->GetFilterFromName(Fuid::Wiener_Out)->runFilter(Image);
 
-  // to RGB
-  Transform = cmsCreateTransform(LabProfile,
-                                 TYPE_Lab_16,
-                                 InternalProfile,
-                                 TYPE_RGB_16,
-                                 Intent,
-                                 cmsFLAGS_NOOPTIMIZE | cmsFLAGS_BLACKPOINTCOMPENSATION);
-
+  // to RGB, changed pixels only
 #pragma omp parallel for schedule(static)
   for (int32_t i = 0; i < Size; i+=Step) {
     int32_t Length = (i+Step)<Size ? Step : Size - i;
-    uint16_t* Tile = &(Image->m_Image[i][0]);
-    cmsDoTransform(Transform,Tile,Tile,Length);
+    std::vector<int32_t>  Changed;
+    std::vector<TPixel16> Tile;
+    for (int32_t k = i; k < i+Length; k++) {
+      if (Image->m_Image[k][0] == LBefore[k]) {
+        std::copy(RGBCopy[k].begin(), RGBCopy[k].end(), Image->m_Image[k]);
+      } else {
+        Changed.push_back(k);
+        Tile.push_back(TPixel16{{Image->m_Image[k][0], Image->m_Image[k][1], Image->m_Image[k][2]}});
+      }
+    }
+    if (Tile.empty()) continue;
+    cmsDoTransform(FromLab.get(),Tile.data(),Tile.data(),Tile.size());
+    for (size_t k = 0; k < Changed.size(); k++)
+      std::copy(Tile[k].begin(), Tile[k].end(), Image->m_Image[Changed[k]]);
   }
 
-  cmsDeleteTransform(Transform);
-  cmsCloseProfile(LabProfile);
-  if (Profile == NULL || InColorSpace != ptSpace_Profiled)
-    cmsCloseProfile(InternalProfile);
   Image->m_ColorSpace = InColorSpace;
 }
 
+////////////////////////////////////////////////////////////////////////////////
+//
+// Progressive preview: runs the dirty tabs from Phase on at a reduced scale
+// and shows the result stretched to the size of the current preview image,
+// before the pipe size run refines it. No histogram, no exposure indicator.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void RunProxyPreview(const short Phase) {
+  const short Scale = Settings->GetInt("ProgressivePreview");
+  if (Scale <= 0 || JobMode || !PreviewImage || PreviewImage->m_Width == 0) return;
+  if (Phase < ptProcessorPhase_RGB || Phase > ptProcessorPhase_EyeCandy) return;
+
+  // Which tab output is on screen, see UpdatePreviewImage().
+  short ShowPhase = ptProcessorPhase_EyeCandy;
+  if (Settings->GetInt("PreviewMode") == ptPreviewMode_Tab) {
+    switch (MainWindow->GetCurrentTab()) {
+      case ptRGBTab:         ShowPhase = ptProcessorPhase_RGB;         break;
+      case ptLabCCTab:       ShowPhase = ptProcessorPhase_LabCC;       break;
+      case ptLabSNTab:       ShowPhase = ptProcessorPhase_LabSN;       break;
+      case ptLabEyeCandyTab: ShowPhase = ptProcessorPhase_LabEyeCandy; break;
+      case ptEyeCandyTab:
+      case ptOutTab:         ShowPhase = ptProcessorPhase_EyeCandy;    break;
+      default:               return;   // the shown image is not affected
+    }
+  }
+  if (ShowPhase < Phase) return;
+
+  ptImage Proxy;
+  if (!TheProcessor->RunProxy(Phase, Scale, ShowPhase, &Proxy)) return;
+
+  if (Proxy.m_ColorSpace == ptSpace_Lab)
+    Proxy.LabToRGB(Settings->GetInt("WorkColor"));
+  BeforeGamma(&Proxy,0,0);
+  ptImage* ReturnValue = Proxy.lcmsRGBToPreviewRGB(Settings->GetInt("CMQuality") == ptCMQuality_FastSRGB);
+  if (!ReturnValue) {
+    ptLogError(ptError_lcms,"lcmsRGBToPreviewRGB");
+    return;
+  }
+  AfterAll(&Proxy,0,0);
+
+  ViewWindow->UpdateImage(&Proxy, QSize(PreviewImage->m_Width, PreviewImage->m_Height));
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 //
 // Determine and update the preview image.
@@ -1779,26 +1880,26 @@ void UpdatePreviewImage(const ptImage* ForcedImage   /* = NULL  */,
           PreviewImage->Set(TheDcRaw,
                              Settings->GetInt("WorkColor"));
         } else {
-          PreviewImage->Set(TheProcessor->m_Image_AfterDcRaw);
+          PreviewImage->Set(TheProcessor->RestoreStage(TheProcessor->m_Image_AfterDcRaw));
         }
         break;
       case ptLocalTab:
-        PreviewImage->Set(TheProcessor->m_Image_AfterLocalEdit);
+        PreviewImage->Set(TheProcessor->RestoreStage(TheProcessor->m_Image_AfterLocalEdit));
         break;
       case ptGeometryTab:
         PreviewImage->Set(TheProcessor->m_Image_AfterGeometry);
         break;
       case ptRGBTab:
-        PreviewImage->Set(TheProcessor->m_Image_AfterRGB);
+        PreviewImage->Set(TheProcessor->RestoreStage(TheProcessor->m_Image_AfterRGB));
         break;
       case ptLabCCTab:
-        PreviewImage->Set(TheProcessor->m_Image_AfterLabCC);
+        PreviewImage->Set(TheProcessor->RestoreStage(TheProcessor->m_Image_AfterLabCC));
         break;
       case ptLabSNTab:
-        PreviewImage->Set(TheProcessor->m_Image_AfterLabSN);
+        PreviewImage->Set(TheProcessor->RestoreStage(TheProcessor->m_Image_AfterLabSN));
         break;
       case ptLabEyeCandyTab:
-        PreviewImage->Set(TheProcessor->m_Image_AfterLabEyeCandy);
+        PreviewImage->Set(TheProcessor->RestoreStage(TheProcessor->m_Image_AfterLabEyeCandy));
         break;
       case ptEyeCandyTab:
       case ptOutTab:
@@ -1864,6 +1965,14 @@ void UpdatePreviewImage(const ptImage* ForcedImage   /* = NULL  */,
       } else {
         HistogramImage->Crop(TempCropX, TempCropY, TempCropW, TempCropH);
       }
+    } else if (!TheProcessor->ProcessedViewport().isEmpty() &&
+               HistogramImage->m_Width == TheProcessor->m_Image_AfterEyeCandy->m_Width &&
+               HistogramImage->m_Height == TheProcessor->m_Image_AfterEyeCandy->m_Height) {
+      // Only the processed viewport is up to date.
+      QRect Viewport = TheProcessor->ProcessedViewport() &
+                       QRect(0, 0, HistogramImage->m_Width, HistogramImage->m_Height);
+      if (!Viewport.isEmpty())
+        HistogramImage->Crop(Viewport.x(), Viewport.y(), Viewport.width(), Viewport.height());
     }
 
     // In case of histogram update only, we're done.
@@ -2273,6 +2382,8 @@ void WriteOut() {
   if (Settings->GetInt("JobMode") == 1) {
     OutImage = TheProcessor->m_Image_AfterEyeCandy; // Job mode -> no cache
   } else {
+    // The preview may only have processed the visible part.
+    TheProcessor->RunFullFrame();
     if (!OutImage) OutImage = new(ptImage);
     OutImage->Set(TheProcessor->m_Image_AfterEyeCandy);
   }
@@ -2520,6 +2631,23 @@ void CB_PixelReader(const QPointF Point, const ptPixelReading PixelReading) {
                              QString::number(RGB.B/655.35, 'f', 2));
 }
 
+//==============================================================================
+// Processes the parts of the image that became visible by panning or zooming
+void CB_Viewport(const QRect Visible) {
+  if (Settings->GetInt("PipeIsRunning") || Settings->GetInt("HaveImage")==0 ||
+      !TheProcessor || !TheProcessor->m_Image_AfterEyeCandy || !PreviewImage ||
+      PreviewImage->m_Width == 0 || Visible.isEmpty())
+    return;
+
+  // From displayed to pipe image pixels, with a margin so that small pans need no run.
+  const float Scale = (float)TheProcessor->m_Image_AfterEyeCandy->m_Width / PreviewImage->m_Width;
+  QRect Rect(qFloor(Visible.x()*Scale), qFloor(Visible.y()*Scale),
+             qCeil(Visible.width()*Scale), qCeil(Visible.height()*Scale));
+  Rect.adjust(-Rect.width()/4, -Rect.height()/4, Rect.width()/4, Rect.height()/4);
+
+  if (TheProcessor->SetViewport(Rect)) Update(ptProcessorPhase_RGB);
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 //
 // For convenience...
@@ -2552,6 +2680,9 @@ void CB_Tabs(const short) {
 ////////////////////////////////////////////////////////////////////////////////
 
 void CB_MenuFileOpen(const short HaveFile) {
+  // Never delete the processor under a running pipe.
+  if (Settings->GetInt("PipeIsRunning")) return;
+
   QStringList OldInputFileNameList = Settings->GetStringList("InputFileNameList");
   QString InputFileName = "";
   if (HaveFile) {
@@ -2844,6 +2975,8 @@ void CB_MenuFileExit(const short) {
 
   delete BatchWindow;
 
+  ptRawIndex::instance()->save();
+
   // Store the position of the splitter and main window
   Settings->m_IniSettings->
     setValue("MainSplitter",MainWindow->MainSplitter->saveState());
@@ -2889,9 +3022,10 @@ void GimpExport(const short UsePipe) {
 
     ptImage* ImageForGimp = new ptImage;
 
-    if (UsePipe == 1)
+    if (UsePipe == 1) {
+      TheProcessor->RunFullFrame();
       ImageForGimp->Set(TheProcessor->m_Image_AfterEyeCandy);
-    else {
+    } else {
       Settings->SetValue("RunMode",0);
 
       // Processing the job.
@@ -3458,6 +3592,7 @@ void CB_PipeSizeChoice(const QVariant Choice) {
         if (TheProcessor->m_Image_DetailPreview == NULL)
           TheProcessor->m_Image_DetailPreview = new ptImage();
         // save a full image if we have several detail views without full view
+        TheProcessor->RestoreStage(TheProcessor->m_Image_AfterDcRaw);
         if (!Settings->useRAWHandling()) {
           TheProcessor->m_Image_DetailPreview->SetScaled(TheProcessor->m_Image_AfterDcRaw,
                                                          Settings->GetInt("Scaled"));
@@ -3979,7 +4114,7 @@ void CB_WhiteBalanceChoice(const QVariant Choice) {
       // impossible to calculate reverse to a spot in dcraw.
       ViewWindow->SaveZoom();
       ViewWindow->ZoomToFit();
-      UpdatePreviewImage(TheProcessor->m_Image_AfterDcRaw);
+      UpdatePreviewImage(TheProcessor->RestoreStage(TheProcessor->m_Image_AfterDcRaw));
 
       // Allow to be selected in the view window. And deactivate main.
       BlockTools(btmBlockAll);
@@ -4434,6 +4569,7 @@ void CB_RotateRightButton() {
 }
 
 void CB_RotateAngleButton() {
+  if (Settings->GetInt("PipeIsRunning")) return;
   if (Settings->GetInt("HaveImage")==0) {
     ptMessageBox::information(MainWindow,
       QObject::tr("No selection"),
@@ -4633,6 +4769,7 @@ void CB_LightsOutChoice(const QVariant Choice) {
 
 // Prepare and start image crop interaction
 void CB_MakeCropButton() {
+  if (Settings->GetInt("PipeIsRunning")) return;
   if (Settings->GetInt("HaveImage")==0) {
     ptMessageBox::information(MainWindow,
       QObject::tr("No crop possible"),
@@ -5417,7 +5554,7 @@ ptImageType CheckImageType(QString filename,
     strcpy(LocalDcRaw->m_UserSetting_InputFileName,filename.toLocal8Bit().data());
   }
 
-  if (LocalDcRaw->Identify() == 0) {
+  if (LocalDcRaw->Identify("", 1) == 0) {
     // we have a raw file
     result = itRaw;
     if (Settings->GetInt("UseThumbnail") == 0) {
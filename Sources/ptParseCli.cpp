@@ -35,7 +35,9 @@ struct Entities {
   int       DelInputFile;
   int       NewInstance;
   int       NoOpenFileMgr;
+  int       Bench;
   bool      ShowHelp;
+  QString   ProfileFilename;
 };
 
 
@@ -49,12 +51,13 @@ ptCliCommands ParseCli(int argc, char *argv[]) {
 
   QStringList params;
   params << "-i" << "-j" << "--load-and-delete" << "--pts" << "--new-instance" << "--no-fmgr" << "-p"
-         << "-h" << "--help" << "-help" << "--sidecar";
+         << "-h" << "--help" << "-help" << "--sidecar" << "--profile" << "--bench";
 
   int i = 1;
   bool MustBeFilename = false;
   bool MustBePtsName  = false;
   bool MustBeSidecar  = false;
+  bool MustBeProfile  = false;
   while (i < argc) {
     QString current = QString::fromLocal8Bit(argv[i]);
     int whichParam = params.indexOf(current.toLower());
@@ -95,6 +98,18 @@ ptCliCommands ParseCli(int argc, char *argv[]) {
       }
     }
 
+    if (MustBeProfile) {
+      if (whichParam > -1 || cli.ProfileFilename != "") {
+        cli.ShowHelp = true;
+        break;
+      } else {
+        cli.ProfileFilename = current;
+        MustBeProfile = false;
+        i++;
+        continue;
+      }
+    }
+
     if (whichParam == 0) {
       cli.LoadFile++;
       MustBeFilename = true;
@@ -115,6 +130,11 @@ ptCliCommands ParseCli(int argc, char *argv[]) {
       break;
     } else if (whichParam == 10) { // --sidecar
       MustBeSidecar = true;
+    } else if (whichParam == 11) { // --profile
+      MustBeProfile = true;
+    } else if (whichParam == 12) { // --bench
+      cli.Bench++;
+      MustBeFilename = true;
     } else if (whichParam == -1) {  // can only be image file without -i param
       if (QFileInfo(current).suffix().toLower() == "pts") {
         MustBePtsName = true;
@@ -125,7 +145,7 @@ ptCliCommands ParseCli(int argc, char *argv[]) {
       continue;
     }
 
-    if ((MustBeFilename || MustBePtsName || MustBeSidecar) && (i >= argc - 1)) {
+    if ((MustBeFilename || MustBePtsName || MustBeSidecar || MustBeProfile) && (i >= argc - 1)) {
       cli.ShowHelp = true;
       break;
     }
@@ -135,8 +155,8 @@ ptCliCommands ParseCli(int argc, char *argv[]) {
 
 
   if (cli.ShowHelp > 0 ||
-      (cli.LoadFile + cli.JobMode + cli.DelInputFile > 1) ||
-      ((cli.JobMode > 0 || cli.DelInputFile > 0) && (cli.PtsFilename != "")) ||
+      (cli.LoadFile + cli.JobMode + cli.DelInputFile + cli.Bench > 1) ||
+      ((cli.JobMode > 0 || cli.DelInputFile > 0 || cli.Bench > 0) && (cli.PtsFilename != "")) ||
       (cli.NewInstance > 1))
   {
     result.Mode = cliShowHelp;
@@ -147,6 +167,7 @@ ptCliCommands ParseCli(int argc, char *argv[]) {
     result.NewInstance   = cli.NewInstance > 0;
     result.NoOpenFileMgr = cli.NoOpenFileMgr;
     result.Sidecar       = cli.Sidecar;
+    result.ProfileFilename = cli.ProfileFilename;
 
     if (cli.LoadFile > 0) {
       result.Mode = cliLoadImage;
@@ -154,6 +175,8 @@ ptCliCommands ParseCli(int argc, char *argv[]) {
       result.Mode = cliProcessJob;
     } else if (cli.DelInputFile > 0) {
       result.Mode = cliLoadAndDelImage;
+    } else if (cli.Bench > 0) {
+      result.Mode = cliBench;
     }
   }
 
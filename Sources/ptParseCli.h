@@ -34,7 +34,8 @@ enum ptCliMode {
   cliLoadImage       = 0,
   cliLoadAndDelImage = 1,
   cliProcessJob      = 2,
-  cliShowHelp        = 3
+  cliShowHelp        = 3,
+  cliBench           = 4
 };
 
 /*! Struct for the results of cli parse. */
@@ -45,6 +46,7 @@ struct ptCliCommands {
   QString Sidecar;
   bool NewInstance;
   bool NoOpenFileMgr;
+  QString ProfileFilename;
 };
 
 /*! Parses the command line and returns invoked action and files to open. */
@@ -32,6 +32,9 @@
 #include "ptDcRaw.h"
 #include "ptMessageBox.h"
 #include "ptImageHelper.h"
+#include "ptImageCache.h"
+#include "ptStageCache.h"
+#include "ptProfiler.h"
 #include <filters/ptFilterDM.h>
 #include <filters/ptFilterBase.h>
 #include <filters/ptFilterUids.h>
@@ -40,6 +43,10 @@
 
 #include <QFileInfo>
 #include <QApplication>
+#include <QStringList>
+#include <QCryptographicHash>
+
+#include <algorithm>
 
 //==============================================================================
 
@@ -48,7 +55,13 @@ void ViewWindowShowStatus(short State);
 
 //==============================================================================
 
-ptProcessor::ptProcessor(PReportProgressFunc AReportProgress) {
+ptProcessor::ptProcessor(PReportProgressFunc AReportProgress):
+  FFilterCache(new ptImageCache(0)),
+  FStageCache(new ptStageCache(0)),
+  FCancellable(false),
+  FFullFrameRun(false),
+  FCancelRequested(false)
+{
   // We work with a callback to avoid dependency on ptMainWindow
   m_ReportProgress = AReportProgress;
 
@@ -71,6 +84,18 @@ ptProcessor::ptProcessor(PReportProgressFunc AReportProgress) {
   m_Image_TextureOverlay2  = nullptr;
 
   m_ScaleFactor            = 0.0f;
+
+  FProcessorMode           = ptProcessorMode_Preview;
+  FFilterCacheActive       = false;
+  FFloatPipe               = false;
+  FProxyRun                = false;
+  FCacheGeneration         = 0;
+
+  FRoiHalo                 = 0;
+  FRoiActive               = false;
+  FRoiPanPending           = false;
+  FRoiPanRun               = false;
+  FTabInput                = nullptr;
 }
 
 //==============================================================================
@@ -118,9 +143,6 @@ void ptProcessor::Run(short Phase,
                       short ProcessorMode)
 {
   try {
-    // Temp var for new-style filters. Needs to be up here to not interfere with gotos and case labels.
-    ptFilterBase *hFilter = nullptr;
-
     printf("(%s,%d) %s\n",__FILE__,__LINE__,__PRETTY_FUNCTION__);
 
     static short PreviousProcessorMode = ptProcessorMode_Preview;
@@ -134,6 +156,49 @@ void ptProcessor::Run(short Phase,
       WithIdentify = 1;
     };
     PreviousProcessorMode = ProcessorMode;
+    FProcessorMode        = ProcessorMode;
+    FStripQueue.clear();
+
+    // Float capable filters may hand their float32 result on to the next one.
+    FFloatPipe = Settings->GetInt("FloatPipe") != 0;
+
+    // Filter results are only remembered for the interactive pipe.
+    // Proxy runs leave the cache alone, their results do not belong to the pipe size images.
+    FFilterCacheActive = (ProcessorMode == ptProcessorMode_Preview) &&
+                         !Settings->GetInt("JobMode") &&
+                         !FProxyRun &&
+                         (Settings->GetInt("FilterCacheSize") > 0);
+    if (FFilterCacheActive) {
+      FFilterCache->setCapacity((size_t)Settings->GetInt("FilterCacheSize") << 20);
+    } else if (!FProxyRun) {
+      FFilterCache->clear();
+    }
+    FFusedLut.reset();
+
+    // A newer request may supersede an interactive run.
+    FCancellable     = (ProcessorMode == ptProcessorMode_Preview) && !Settings->GetInt("JobMode") &&
+                       !FFullFrameRun;
+    FCancelRequested = false;
+
+    // Restrict the filter tabs to the viewport when every filter in them has a bounded halo.
+    const bool hPanRun = FRoiPanPending && (Phase == ptProcessorPhase_RGB) && !FProxyRun;
+    if (!FProxyRun) {
+      FRoiPanPending = false;
+      if (Phase <= ptProcessorPhase_RGB) FRoi = FRequestedRoi;
+    }
+    FRoiActive = FCancellable && !FProxyRun && Settings->GetInt("ViewportProcessing") &&
+                 !FRoi.isEmpty();
+    FRoiHalo   = 0;
+    for (auto hIt = GFilterDM->activeBegin(); FRoiActive && hIt != GFilterDM->activeEnd(); ++hIt) {
+      // The tab indices are not in pipe order, Lab EyeCandy comes last.
+      if (hIt->parentTabIdx() < ptRGBTab || hIt->parentTabIdx() > ptLabEyeCandyTab) continue;
+      if (hIt->haloRadius() < 0) {
+        FRoiActive = false;
+      } else {
+        FRoiHalo += hIt->haloRadius();
+      }
+    }
+    FRoiPanRun = FRoiActive && hPanRun;
 
     // Purposes of timing the lenghty operations.
     FRunTimer.start();
@@ -153,6 +218,14 @@ void ptProcessor::Run(short Phase,
       }
     }
 
+    const short hFromPhase = RestoreStages(Phase);
+    if (hFromPhase < Phase) {
+      Phase = hFromPhase;
+      // A lost dcraw output is redone from the dcraw caches, a bitmap is read again.
+      if (Phase == ptProcessorPhase_Raw) {
+        SubPhase = Settings->useRAWHandling() ? ptProcessorPhase_Highlights : ptProcessorPhase_Load;
+      }
+    }
 
     switch(Phase) {
       //------------------------------------------------------------------------------
@@ -180,12 +253,13 @@ void ptProcessor::Run(short Phase,
         Settings->SetValue("Scaled", m_DcRaw->m_UserSetting_HalfSize);
 
         if (!Settings->useRAWHandling()) {
-          m_ReportProgress(tr("Loading Bitmap"));
+          ReportProgress(tr("Loading Bitmap"));
 
           TRACEMAIN("Start opening bitmap at %d ms.",
                       FRunTimer.elapsed());
 
           if (!m_Image_AfterDcRaw) m_Image_AfterDcRaw = new ptImage();
+          ptProfileScope hProfile("Bitmap load", "dcraw", m_Image_AfterDcRaw);
 
           bool success = false;
 
@@ -219,7 +293,7 @@ void ptProcessor::Run(short Phase,
           Settings->SetValue("ImageW", m_Image_AfterDcRaw->m_Width);
           Settings->SetValue("ImageH", m_Image_AfterDcRaw->m_Height);
 
-          m_ReportProgress(tr("Reading exif info"));
+          ReportProgress(tr("Reading exif info"));
 
           if (ProcessorMode != ptProcessorMode_Thumb) {
             // Read Exif
@@ -233,10 +307,13 @@ void ptProcessor::Run(short Phase,
           switch (SubPhase) {
             case ptProcessorPhase_Load :
 
-              m_ReportProgress(tr("Reading RAW file"));
+              ReportProgress(tr("Reading RAW file"));
 
-              if (WithIdentify) m_DcRaw->Identify();
-              m_DcRaw->RunDcRaw_Phase1();
+              {
+                ptProfileScope hProfile("DcRaw load", "dcraw");
+                if (WithIdentify) m_DcRaw->Identify();
+                m_DcRaw->RunDcRaw_Phase1();
+              }
 
               // Do not forget !
               // Not in DcRawToSettings as at this point it is
@@ -250,7 +327,7 @@ void ptProcessor::Run(short Phase,
                 TRACEKEYVALS("ImageH","%d",Settings->GetInt("ImageH"));
               }
 
-              m_ReportProgress(tr("Reading exif info"));
+              ReportProgress(tr("Reading exif info"));
 
               if (ProcessorMode != ptProcessorMode_Thumb) {
                 // Read Exif
@@ -261,20 +338,26 @@ void ptProcessor::Run(short Phase,
 
             case ptProcessorPhase_Demosaic :
 
-              m_ReportProgress(tr("Demosaicing"));
+              ReportProgress(tr("Demosaicing"));
 
-              // Settings->GetInt("JobMode") causes NoCache
-              m_DcRaw->RunDcRaw_Phase2(Settings->GetInt("JobMode"));
+              {
+                ptProfileScope hProfile("DcRaw demosaic", "dcraw");
+                // Settings->GetInt("JobMode") causes NoCache
+                m_DcRaw->RunDcRaw_Phase2(Settings->GetInt("JobMode"));
+              }
 
               TRACEMAIN("Done Color Scaling and Interpolation at %d ms.",
                         FRunTimer.elapsed());
 
             case ptProcessorPhase_Highlights :
 
-              m_ReportProgress(tr("Recovering highlights"));
+              ReportProgress(tr("Recovering highlights"));
 
-              // Settings->GetInt("JobMode") causes NoCache
-              m_DcRaw->RunDcRaw_Phase3(Settings->GetInt("JobMode"));
+              {
+                ptProfileScope hProfile("DcRaw highlights", "dcraw");
+                // Settings->GetInt("JobMode") causes NoCache
+                m_DcRaw->RunDcRaw_Phase3(Settings->GetInt("JobMode"));
+              }
 
               TRACEMAIN("Done Highlights at %d ms.",FRunTimer.elapsed());
 
@@ -381,862 +464,748 @@ void ptProcessor::Run(short Phase,
       //------------------------------------------------------------------------------
 
       case ptProcessorPhase_RGB: // Run everything in RGB.
+        // Pipe size, crop or rotation may have changed the image size since the viewport
+        // was set. Its rectangle does not fit any more, process the whole image.
+        if (FRoiActive && FRoiFrame != QSize(m_Image_AfterGeometry->m_Width,
+                                             m_Image_AfterGeometry->m_Height)) {
+          FRoiActive    = false;
+          FRoiPanRun    = false;
+          FRequestedRoi = QRect();
+        }
+
         // Geometry block
         // This will skip the rest of the pipe, to make geometry adjustments easier.
 
         if (Settings->ToolIsActive("TabBlock")){ // &&
           if (!m_Image_AfterRGB) m_Image_AfterRGB = new ptImage();
-          m_Image_AfterRGB->Set(m_Image_AfterGeometry);
+          m_Image_AfterRGB->Share(m_Image_AfterGeometry);
           if (!m_Image_AfterLabCC) m_Image_AfterLabCC = new ptImage();
-          m_Image_AfterLabCC->Set(m_Image_AfterGeometry);
+          m_Image_AfterLabCC->Share(m_Image_AfterGeometry);
           if (!m_Image_AfterLabSN) m_Image_AfterLabSN = new ptImage();
-          m_Image_AfterLabSN->Set(m_Image_AfterGeometry);
+          m_Image_AfterLabSN->Share(m_Image_AfterGeometry);
           if (!m_Image_AfterEyeCandy) m_Image_AfterEyeCandy = new ptImage();
-          m_Image_AfterEyeCandy->Set(m_Image_AfterGeometry);
+          m_Image_AfterEyeCandy->Share(m_Image_AfterGeometry);
+          FCheckpointKeys.remove(m_Image_AfterRGB);
+          FCheckpointKeys.remove(m_Image_AfterLabCC);
+          FCheckpointKeys.remove(m_Image_AfterLabSN);
+          FCheckpointKeys.remove(m_Image_AfterEyeCandy);
           goto Exit;
         }
 
-        if (Settings->GetInt("JobMode")) {
-          m_Image_AfterRGB = m_Image_AfterGeometry; // Job mode -> no cache
-        } else {
-          if (!m_Image_AfterRGB) m_Image_AfterRGB = new ptImage();
-          m_Image_AfterRGB->Set(m_Image_AfterGeometry);
-        }
-
-        //***************************************************************************
-        // Channel mixing.
-
-        hFilter = GFilterDM->GetFilterFromName(Fuid::ChannelMixer_RGB);
-        if (hFilter->isActive()) {
-          m_ReportProgress(hFilter->caption());
-          hFilter->runFilter(m_Image_AfterRGB);
-        }
-
-
-        //***************************************************************************
-        // Highlights
-
-        hFilter = GFilterDM->GetFilterFromName(Fuid::Highlights_RGB);
-        if (hFilter->isActive()) {
-          m_ReportProgress(hFilter->caption());
-          hFilter->runFilter(m_Image_AfterRGB);
-        }
-
-
-        //***************************************************************************
-        // Vibrance
-
-        hFilter = GFilterDM->GetFilterFromName(Fuid::ColorIntensity_RGB);
-        if (hFilter->isActive()) {
-          m_ReportProgress(hFilter->caption());
-          hFilter->runFilter(m_Image_AfterRGB);
-        }
-
-
-        //***************************************************************************
-        // Brightness
-
-        hFilter = GFilterDM->GetFilterFromName(Fuid::Brightness_RGB);
-        if (hFilter->isActive()) {
-          m_ReportProgress(hFilter->caption());
-          hFilter->runFilter(m_Image_AfterRGB);
-        }
-
-
-        //***************************************************************************
-        // Exposure and Exposure gain
-
-        hFilter = GFilterDM->GetFilterFromName(Fuid::Exposure_RGB);
-        if (hFilter->isActive()) {
-          m_ReportProgress(hFilter->caption());
-          hFilter->runFilter(m_Image_AfterRGB);
-        }
-
-
-        //***************************************************************************
-        // Reinhard 05
-
-        hFilter = GFilterDM->GetFilterFromName(Fuid::ReinhardBrighten_RGB);
-        if (hFilter->isActive()) {
-          m_ReportProgress(hFilter->caption());
-          hFilter->runFilter(m_Image_AfterRGB);
-        }
-
-
-        //***************************************************************************
-        // Gamma tool
-
-        hFilter = GFilterDM->GetFilterFromName(Fuid::GammaTool_RGB);
-        if (hFilter->isActive()) {
-          m_ReportProgress(hFilter->caption());
-          hFilter->runFilter(m_Image_AfterRGB);
-        }
-
+        // fall through
 
-        //***************************************************************************
-        // Normalization
-
-        hFilter = GFilterDM->GetFilterFromName(Fuid::Normalization_RGB);
-        if (hFilter->isActive()) {
-          m_ReportProgress(hFilter->caption());
-          hFilter->runFilter(m_Image_AfterRGB);
-        }
-
-
-        //***************************************************************************
-        // Color Enhancement
-
-        hFilter = GFilterDM->GetFilterFromName(Fuid::ColorEnhancement_RGB);
-        if (hFilter->isActive()) {
-          m_ReportProgress(hFilter->caption());
-          hFilter->runFilter(m_Image_AfterRGB);
-        }
-
-
-        //***************************************************************************
-        // LMHRecovery
-
-        hFilter = GFilterDM->GetFilterFromName(Fuid::LMHRecovery_RGB);
-        if (hFilter->isActive()) {
-          m_ReportProgress(hFilter->caption());
-          hFilter->runFilter(m_Image_AfterRGB);
-        }
-
-        //***************************************************************************
-        // RGB Texturecontrast
-
-        hFilter = GFilterDM->GetFilterFromName(Fuid::TextureContrast_RGB);
-        if (hFilter->isActive()) {
-          m_ReportProgress(hFilter->caption());
-          hFilter->runFilter(m_Image_AfterRGB);
-        }
-
-        //***************************************************************************
-        // Local contrast
-
-        hFilter = GFilterDM->GetFilterFromName(Fuid::LocalContrast1_RGB);
-        if (hFilter->isActive()) {
-          m_ReportProgress(hFilter->caption());
-          hFilter->runFilter(m_Image_AfterRGB);
-        }
-
-        hFilter = GFilterDM->GetFilterFromName(Fuid::LocalContrast2_RGB);
-        if (hFilter->isActive()) {
-          m_ReportProgress(hFilter->caption());
-          hFilter->runFilter(m_Image_AfterRGB);
-        }
-
-
-       //***************************************************************************
-       // RGB Contrast.
-
-        hFilter = GFilterDM->GetFilterFromName(Fuid::SigContrastRgb_RGB);
-        if (hFilter->isActive()) {
-          m_ReportProgress(hFilter->caption());
-          hFilter->runFilter(m_Image_AfterRGB);
-        }
-
-
-        //***************************************************************************
-        // Levels
-
-        hFilter = GFilterDM->GetFilterFromName(Fuid::Levels_RGB);
-        if (hFilter->isActive()) {
-          m_ReportProgress(hFilter->caption());
-          hFilter->runFilter(m_Image_AfterRGB);
-        }
-
-
-        //***************************************************************************
-        // RGB Curves.
-
-        hFilter = GFilterDM->GetFilterFromName(Fuid::RgbCurve_RGB);
-        if (hFilter->isActive()) {
-          m_ReportProgress(hFilter->caption());
-          hFilter->runFilter(m_Image_AfterRGB);
-        }
-
-
-
-      case ptProcessorPhase_LabCC : // Run everything in LAB.
-
-        if (Settings->GetInt("JobMode")) {
-          m_Image_AfterLabCC = m_Image_AfterRGB; // Job mode -> no cache
-        } else {
-          if (!m_Image_AfterLabCC) m_Image_AfterLabCC = new ptImage();
-          m_Image_AfterLabCC->Set(m_Image_AfterRGB);
-        }
-
-
-        //***************************************************************************
-        // LAB Transform, this has to be the first filter
-        // in the LAB series, because it needs RGB input
-
-        hFilter = GFilterDM->GetFilterFromName(Fuid::LabTransform_LabCC);
-        if (hFilter->isActive()) {
-          m_ReportProgress(hFilter->caption());
-          hFilter->runFilter(m_Image_AfterLabCC);
-        }
-
-
-        //***************************************************************************
-        // Shadows Highlights
-
-        hFilter = GFilterDM->GetFilterFromName(Fuid::ShadowsHighlights_LabCC);
-        if (hFilter->isActive()) {
-          m_ReportProgress(hFilter->caption());
-          hFilter->runFilter(m_Image_AfterLabCC);
-        }
+      case ptProcessorPhase_LabCC:
+      case ptProcessorPhase_LabSN:
+      case ptProcessorPhase_LabEyeCandy:
+      case ptProcessorPhase_EyeCandy:
+        RunFilterTabs(qMax(Phase, ptProcessorPhase_RGB));
 
 
-        //***************************************************************************
-        // LabLMHLightRecovery
-
-        hFilter = GFilterDM->GetFilterFromName(Fuid::LMHRecovery_LabCC);
-        if (hFilter->isActive()) {
-          m_ReportProgress(hFilter->caption());
-          hFilter->runFilter(m_Image_AfterLabCC);
-        }
-
-
-        //***************************************************************************
-        // Dynamic Range Compression
-
-        hFilter = GFilterDM->GetFilterFromName(Fuid::Drc_LabCC);
-        if (hFilter->isActive()) {
-          m_ReportProgress(hFilter->caption());
-          hFilter->runFilter(m_Image_AfterLabCC);
-        }
-
-
-        //***************************************************************************
-        // Texture curve
-
-        hFilter = GFilterDM->GetFilterFromName(Fuid::TextureCurve_LabCC);
-        if (hFilter->isActive()) {
-          m_ReportProgress(hFilter->caption());
-          hFilter->runFilter(m_Image_AfterLabCC);
-        }
-
-
-        //***************************************************************************
-        // Texturecontrast
-
-        hFilter = GFilterDM->GetFilterFromName(Fuid::TextureContrast1_LabCC);
-        if (hFilter->isActive()) {
-          m_ReportProgress(hFilter->caption());
-          hFilter->runFilter(m_Image_AfterLabCC);
-        }
-
-        hFilter = GFilterDM->GetFilterFromName(Fuid::TextureContrast2_LabCC);
-        if (hFilter->isActive()) {
-          m_ReportProgress(hFilter->caption());
-          hFilter->runFilter(m_Image_AfterLabCC);
-        }
-
-        //***************************************************************************
-        // Local contrast
-
-        hFilter = GFilterDM->GetFilterFromName(Fuid::LocalContrast1_LabCC);
-        if (hFilter->isActive()) {
-          m_ReportProgress(hFilter->caption());
-          hFilter->runFilter(m_Image_AfterLabCC);
-        }
-
-        hFilter = GFilterDM->GetFilterFromName(Fuid::LocalContrast2_LabCC);
-        if (hFilter->isActive()) {
-          m_ReportProgress(hFilter->caption());
-          hFilter->runFilter(m_Image_AfterLabCC);
-        }
-
-
-        //***************************************************************************
-        // Local Contrast Stretch
-
-        hFilter = GFilterDM->GetFilterFromName(Fuid::LocalContrastStretch1_LabCC);
-        if (hFilter->isActive()) {
-          m_ReportProgress(hFilter->caption());
-          hFilter->runFilter(m_Image_AfterLabCC);
-        }
-
-        hFilter = GFilterDM->GetFilterFromName(Fuid::LocalContrastStretch2_LabCC);
-        if (hFilter->isActive()) {
-          m_ReportProgress(hFilter->caption());
-          hFilter->runFilter(m_Image_AfterLabCC);
-        }
-
-
-        //***************************************************************************
-        // L Contrast
-
-        hFilter = GFilterDM->GetFilterFromName(Fuid::SigContrastLab_LabCC);
-        if (hFilter->isActive()) {
-          m_ReportProgress(hFilter->caption());
-          hFilter->runFilter(m_Image_AfterLabCC);
-        }
-
-
-        //***************************************************************************
-        // Saturation
-
-        hFilter = GFilterDM->GetFilterFromName(Fuid::Saturation_LabCC);
-        if (hFilter->isActive()) {
-          m_ReportProgress(hFilter->caption());
-          hFilter->runFilter(m_Image_AfterLabCC);
-        }
-
-
-        //***************************************************************************
-        // Color Boost
-
-        hFilter = GFilterDM->GetFilterFromName(Fuid::ColorBoost_LabCC);
-        if (hFilter->isActive()) {
-          m_ReportProgress(hFilter->caption());
-          hFilter->runFilter(m_Image_AfterLabCC);
-        }
-
-
-        //***************************************************************************
-        // Levels
-
-        hFilter = GFilterDM->GetFilterFromName(Fuid::Levels_LabCC);
-        if (hFilter->isActive()) {
-          m_ReportProgress(hFilter->caption());
-          hFilter->runFilter(m_Image_AfterLabCC);
-        }
-
-
-
-      case ptProcessorPhase_LabSN : // Run everything in LABSN.
-
-        if (Settings->GetInt("JobMode")) {
-          m_Image_AfterLabSN = m_Image_AfterLabCC; // Job mode -> no cache
-        } else {
-          if (!m_Image_AfterLabSN) m_Image_AfterLabSN = new ptImage();
-          m_Image_AfterLabSN->Set(m_Image_AfterLabCC);
-        }
-
-
-        //***************************************************************************
-        // Impulse denoise
-
-        hFilter = GFilterDM->GetFilterFromName(Fuid::ImpulseNR_LabSN);
-        if (hFilter->isActive()) {
-          m_ReportProgress(hFilter->caption());
-          hFilter->runFilter(m_Image_AfterLabSN);
-        }
-
-
-        //***************************************************************************
-        // Edge avoiding wavelet filter
-
-        hFilter = GFilterDM->GetFilterFromName(Fuid::EAWavelets_LabSN);
-        if (hFilter->isActive()) {
-          m_ReportProgress(hFilter->caption());
-          hFilter->runFilter(m_Image_AfterLabSN);
-        }
-
-
-        //***************************************************************************
-        // GreyCStoration on L
-
-        hFilter = GFilterDM->GetFilterFromName(Fuid::GreyCStoration_LabSN);
-        if (hFilter->isActive()) {
-          m_ReportProgress(hFilter->caption());
-          hFilter->runFilter(m_Image_AfterLabSN);
-        }
-
-
-        //***************************************************************************
-        // Defringe
-
-        hFilter = GFilterDM->GetFilterFromName(Fuid::Defringe_LabSN);
-        if (hFilter->isActive()) {
-          m_ReportProgress(hFilter->caption());
-          hFilter->runFilter(m_Image_AfterLabSN);
-        }
-
-
-        //***************************************************************************
-        // Wavelet denoise
-
-        hFilter = GFilterDM->GetFilterFromName(Fuid::WaveletDenoise_LabSN);
-        if (hFilter->isActive()) {
-          m_ReportProgress(hFilter->caption());
-          hFilter->runFilter(m_Image_AfterLabSN);
-        }
-
-
-        //***************************************************************************
-        // Bilateral filter on L (luma denoising)
-
-        hFilter = GFilterDM->GetFilterFromName(Fuid::LumaDenoise_LabSN);
-        if (hFilter->isActive()) {
-          m_ReportProgress(hFilter->caption());
-          hFilter->runFilter(m_Image_AfterLabSN);
-        }
-
-
-        //***************************************************************************
-        // Denoise curve
-
-        hFilter = GFilterDM->GetFilterFromName(Fuid::LumaDenoiseCurve_LabSN);
-        if (hFilter->isActive()) {
-          m_ReportProgress(hFilter->caption());
-          hFilter->runFilter(m_Image_AfterLabSN);
-        }
-
-
-        //***************************************************************************
-        // Pyramid denoise filter
-
-        hFilter = GFilterDM->GetFilterFromName(Fuid::PyramidDenoise_LabSN);
-        if (hFilter->isActive()) {
-          m_ReportProgress(hFilter->caption());
-          hFilter->runFilter(m_Image_AfterLabSN);
-        }
-
-
-        //***************************************************************************
-        // Bilateral filter on AB
-
-        hFilter = GFilterDM->GetFilterFromName(Fuid::ColorDenoise_LabSN);
-        if (hFilter->isActive()) {
-          m_ReportProgress(hFilter->caption());
-          hFilter->runFilter(m_Image_AfterLabSN);
-        }
-
-
-        //***************************************************************************
-        // Detail / denoise curve
+  //***************************************************************************
+  Exit:
 
-        hFilter = GFilterDM->GetFilterFromName(Fuid::DetailCurve_LabSN);
-        if (hFilter->isActive()) {
-          m_ReportProgress(hFilter->caption());
-          hFilter->runFilter(m_Image_AfterLabSN);
+        if (!FProxyRun) {
+          Settings->SetValue("PipeImageW",m_Image_AfterEyeCandy->m_Width);
+          Settings->SetValue("PipeImageH",m_Image_AfterEyeCandy->m_Height);
         }
 
+      case ptProcessorPhase_Output : // Run Output.
 
-        //***************************************************************************
-        // Gradient Sharpen
-
-        hFilter = GFilterDM->GetFilterFromName(Fuid::GradientSharpen_LabSN);
-        if (hFilter->isActive()) {
-          m_ReportProgress(hFilter->caption());
-          hFilter->runFilter(m_Image_AfterLabSN);
-        }
+        TRACEMAIN("Done pipe processing at %d ms.",FRunTimer.elapsed());
 
+        break;
 
-        //***************************************************************************
-        // Wiener Filter Sharpen
+      default : // Should not happen.
+        assert(!"Invalid processor phase in ptProcessor::Run()");
+    }
 
-        hFilter = GFilterDM->GetFilterFromName(Fuid::Wiener_LabSN);
-        if (hFilter->isActive()) {
-          m_ReportProgress(hFilter->caption());
-          hFilter->runFilter(m_Image_AfterLabSN);
-        }
+    FCancellable = false;
+    if (Phase < ptProcessorPhase_Output && m_Image_AfterEyeCandy && !FProxyRun) {
+      if (!FRoiActive) {
+        FRoiValid = QRect(0, 0, m_Image_AfterEyeCandy->m_Width, m_Image_AfterEyeCandy->m_Height);
+      } else if (FRoiPanRun) {
+        FRoiValid += FRoi;
+      } else {
+        FRoiValid = FRoi;
+      }
+    }
+    if (ProcessorMode == ptProcessorMode_Preview && !Settings->GetInt("JobMode") && !FProxyRun) {
+      EnforceStageBudget();
+    }
+    GProfiler->flush();
+    m_ReportProgress(tr("Ready"));
+  } catch (TCancelled) {
+    FCancellable = false;
+    if (!FProxyRun) FRoiValid = QRegion();
+    TRACEMAIN("Run cancelled at %d ms.",FRunTimer.elapsed());
+  } catch (std::bad_alloc) {
+    FCancellable = false;
+    printf("\n*************************\n\nMemory error in processor\n\n*************************\n\n");
+    fflush(stdout);
+    throw std::bad_alloc();
+  }
+}
 
+//==============================================================================
 
-        //***************************************************************************
-        // Inverse Diffusion Sharpen
+bool ptProcessor::RunProxy(short Phase, short AScale, short AShowPhase, ptImage *AProxy) {
+  assert(Phase >= ptProcessorPhase_RGB && Phase <= ptProcessorPhase_EyeCandy);
+  assert(AShowPhase >= Phase && AShowPhase <= ptProcessorPhase_EyeCandy);
+
+  // Checkpoints in pipe order, each tab reads the one before its own.
+  ptImage **hStages[] = { &m_Image_AfterGeometry, &m_Image_AfterRGB, &m_Image_AfterLabCC,
+                          &m_Image_AfterLabSN, &m_Image_AfterLabEyeCandy, &m_Image_AfterEyeCandy };
+  const int hInputIdx = Phase - ptProcessorPhase_RGB;
+  // A pan run only adds area, the part on screen is already up to date.
+  if (FRoiPanPending) return false;
+
+  const ptImage *hInput = RestoreStage(*hStages[hInputIdx]);
+  if (!m_DcRaw || !hInput || hInput->isNull() || (hInput->m_Width >> AScale) < 16 ||
+      (hInput->m_Height >> AScale) < 16)
+    return false;
+
+  // Swap in private images for the dirty tabs and their input, so that Run() works on those.
+  ptImage *hSaved[6];
+  std::unique_ptr<ptImage> hProxies[6];
+  for (int i = 0; i < 6; i++) {
+    hSaved[i] = *hStages[i];
+    if (i >= hInputIdx) {
+      hProxies[i].reset(new ptImage());
+      *hStages[i] = hProxies[i].get();
+    }
+  }
+  hProxies[hInputIdx]->SetScaled(hInput, AScale);
 
-        hFilter = GFilterDM->GetFilterFromName(Fuid::InvDiffSharpen_LabSN);
-        if (hFilter->isActive()) {
-          m_ReportProgress(hFilter->caption());
-          hFilter->runFilter(m_Image_AfterLabSN);
-        }
+  // Size dependent filters have to scale their radii accordingly.
+  const float hScaleFactor = m_ScaleFactor;
+  m_ScaleFactor /= (float)(1 << AScale);
+  FProxyRun = true;
 
+  try {
+    Run(Phase);
+  } catch (...) {
+    FProxyRun     = false;
+    m_ScaleFactor = hScaleFactor;
+    for (int i = 0; i < 6; i++) *hStages[i] = hSaved[i];
+    throw;
+  }
 
-        //***************************************************************************
-        // USM
+  FProxyRun     = false;
+  m_ScaleFactor = hScaleFactor;
+  for (int i = 0; i < 6; i++) *hStages[i] = hSaved[i];
 
-        hFilter = GFilterDM->GetFilterFromName(Fuid::Usm_LabSN);
-        if (hFilter->isActive()) {
-          m_ReportProgress(hFilter->caption());
-          hFilter->runFilter(m_Image_AfterLabSN);
-        }
+  // A request that came in meanwhile supersedes the refining run as well.
+  if (FCancelRequested) return false;
 
+  AProxy->Share(hProxies[AShowPhase - ptProcessorPhase_Geometry].get());
+  return true;
+}
 
-        //***************************************************************************
-        // Highpass
+//==============================================================================
 
-        hFilter = GFilterDM->GetFilterFromName(Fuid::HighpassSharpen_LabSN);
-        if (hFilter->isActive()) {
-          m_ReportProgress(hFilter->caption());
-          hFilter->runFilter(m_Image_AfterLabSN);
-        }
+ptImage* ptProcessor::RestoreStage(ptImage *AStage) {
+  FStageCache->restore(AStage);
+  return AStage;
+}
 
+//==============================================================================
 
-        //***************************************************************************
-        // Film grain simulation
+short ptProcessor::RestoreStages(short Phase) {
+  // A phase reads the checkpoint before it, pan runs also keep the later ones.
+  // Checkpoint i is written by phase ptProcessorPhase_Raw + i.
+  ptImage *hStages[] = { m_Image_AfterDcRaw, m_Image_AfterLocalEdit, m_Image_AfterGeometry,
+                         m_Image_AfterRGB, m_Image_AfterLabCC, m_Image_AfterLabSN,
+                         m_Image_AfterLabEyeCandy, m_Image_AfterEyeCandy };
+  for (int i = qMax(0, Phase - ptProcessorPhase_LocalEdit); i < 8; i++) {
+    if (!hStages[i]) continue;
+    const bool hLost = !FStageCache->restore(hStages[i]) || hStages[i]->isNull();
+    if (!hLost) continue;
+
+    if (i == Phase - ptProcessorPhase_LocalEdit) {
+      // The input of the run is gone, compute it again together with what it needs.
+      Phase = ptProcessorPhase_Raw + i;
+      i     = qMax(0, Phase - ptProcessorPhase_LocalEdit) - 1;
+    } else if (i > Phase - ptProcessorPhase_LocalEdit) {
+      // A later tab is written anyway, but a pan run would keep the rest of it.
+      FRoiPanRun = false;
+    }
+  }
+  return Phase;
+}
 
-        hFilter = GFilterDM->GetFilterFromName(Fuid::FilmGrain_LabSN);
-        if (hFilter->isActive()) {
-          m_ReportProgress(hFilter->caption());
-          hFilter->runFilter(m_Image_AfterLabSN);
-        }
+//==============================================================================
 
+void ptProcessor::EnforceStageBudget() {
+  FStageCache->setBudget((size_t)Settings->GetInt("StageCacheBudget") << 20);
+
+  FStageCache->track(m_Image_AfterDcRaw);
+  FStageCache->track(m_Image_AfterLocalEdit);
+  FStageCache->track(m_Image_AfterGeometry, true);   // crop, rotate and filters read it directly
+  FStageCache->track(m_Image_AfterRGB);
+  FStageCache->track(m_Image_AfterLabCC);
+  FStageCache->track(m_Image_AfterLabSN);
+  FStageCache->track(m_Image_AfterLabEyeCandy);
+  FStageCache->track(m_Image_AfterEyeCandy, true);   // shown, output and pixel reader
+
+  // The DcRaw phase caches and the filter cache cannot be spilled, but they count
+  // against the budget.
+  size_t hExternalBytes = FFilterCache->occupancy();
+  if (m_DcRaw && m_DcRaw->m_Image_AfterPhase1)
+    hExternalBytes += (size_t)m_DcRaw->m_OutWidth_AfterPhase1*m_DcRaw->m_OutHeight_AfterPhase1*sizeof(*m_DcRaw->m_Image_AfterPhase1);
+  if (m_DcRaw && m_DcRaw->m_CfaImage_AfterPhase1)
+    hExternalBytes += (size_t)m_DcRaw->m_OutWidth_AfterPhase1*m_DcRaw->m_OutHeight_AfterPhase1*sizeof(*m_DcRaw->m_CfaImage_AfterPhase1);
+  if (m_DcRaw && m_DcRaw->m_Image_AfterPhase2)
+    hExternalBytes += (size_t)m_DcRaw->m_OutWidth*m_DcRaw->m_OutHeight*sizeof(*m_DcRaw->m_Image_AfterPhase2);
+  FStageCache->enforce(hExternalBytes);
+
+  TRACEMAIN("Stage cache: %s",
+            QString("%1 hits, %2 misses, %3 spills, %4 MB resident")
+              .arg(FStageCache->hits()).arg(FStageCache->misses()).arg(FStageCache->spills())
+              .arg((int)((FStageCache->residentBytes() + hExternalBytes) >> 20))
+              .toLocal8Bit().data());
+}
 
-        //***************************************************************************
-        // View Lab
+//==============================================================================
 
-        hFilter = GFilterDM->GetFilterFromName(Fuid::ViewLab_LabSN);
-        if (hFilter->isActive()) {
-          m_ReportProgress(hFilter->caption());
-          hFilter->runFilter(m_Image_AfterLabSN);
-        }
+void ptProcessor::ReportProgress(const QString Message) {
+  m_ReportProgress(Message);
+  // Reporting processes pending events, a newer request may have come in meanwhile.
+  CheckCancelled();
+}
 
+//==============================================================================
 
-        //***************************************************************************
-      case ptProcessorPhase_LabEyeCandy : // Run everything in Lab eyecandy.
+void ptProcessor::RequestCancel() {
+  if (FCancellable) FCancelRequested = true;
+}
 
-        if (Settings->GetInt("JobMode")) {
-          m_Image_AfterLabEyeCandy = m_Image_AfterLabSN; // Job mode -> no cache
-        } else {
-          if (!m_Image_AfterLabEyeCandy) m_Image_AfterLabEyeCandy = new ptImage();
-          m_Image_AfterLabEyeCandy->Set(m_Image_AfterLabSN);
-        }
+//==============================================================================
 
-        //***************************************************************************
-        // Outline
+bool ptProcessor::IsCancellable() const {
+  return FCancellable;
+}
 
-        hFilter = GFilterDM->GetFilterFromName(Fuid::Outline_LabEyeCandy);
-        if (hFilter->isActive()) {
-          m_ReportProgress(hFilter->caption());
-          hFilter->runFilter(m_Image_AfterLabEyeCandy);
-        }
+//==============================================================================
 
-        //***************************************************************************
-        // LByHue Curve
+void ptProcessor::CheckCancelled() {
+  if (FCancellable && FCancelRequested) throw TCancelled();
+}
 
-        hFilter = GFilterDM->GetFilterFromName(Fuid::LumaByHueCurve_LabEyeCandy);
-        if (hFilter->isActive()) {
-          m_ReportProgress(hFilter->caption());
-          hFilter->runFilter(m_Image_AfterLabEyeCandy);
-        }
+//==============================================================================
 
+bool ptProcessor::SetViewport(const QRect &ARect) {
+  const QRect hFrame = m_Image_AfterEyeCandy ?
+    QRect(0, 0, m_Image_AfterEyeCandy->m_Width, m_Image_AfterEyeCandy->m_Height) : QRect();
+  const QRect hRect  = ARect & hFrame;
 
-        //***************************************************************************
-        // Saturation Curve
+  // Restricting the run only pays when it leaves out a good part of the image. Otherwise the
+  // whole image is processed, which keeps the filter cache, fusion and resuming usable.
+  if (hRect.isEmpty() ||
+      4*(qint64)hRect.width()*hRect.height() > 3*(qint64)hFrame.width()*hFrame.height()) {
+    FRequestedRoi = QRect();
+  } else {
+    FRequestedRoi = hRect;
+    FRoiFrame     = hFrame.size();
+  }
 
-        hFilter = GFilterDM->GetFilterFromName(Fuid::SatCurve_LabEyeCandy);
-        if (hFilter->isActive()) {
-          m_ReportProgress(hFilter->caption());
-          hFilter->runFilter(m_Image_AfterLabEyeCandy);
-        }
+  const QRect hNeeded = FRequestedRoi.isEmpty() ? hFrame : FRequestedRoi;
+  if (FRoiValid.isEmpty() || QRegion(hNeeded).subtracted(FRoiValid).isEmpty()) return false;
 
+  FRoiPanPending = true;
+  return true;
+}
 
-        //***************************************************************************
-        // Hue Curve
-        hFilter = GFilterDM->GetFilterFromName(Fuid::HueCurve_LabEyeCandy);
-        if (hFilter->isActive()) {
-          m_ReportProgress(hFilter->caption());
-          hFilter->runFilter(m_Image_AfterLabEyeCandy);
-        }
+//==============================================================================
 
+QRect ptProcessor::ProcessedViewport() const {
+  return FRoiActive ? FRoi : QRect();
+}
 
-        //***************************************************************************
-        // L Curve
+//==============================================================================
 
-        hFilter = GFilterDM->GetFilterFromName(Fuid::LCurve_LabEyeCandy);
-        if (hFilter->isActive()) {
-          m_ReportProgress(hFilter->caption());
-          hFilter->runFilter(m_Image_AfterLabEyeCandy);
-        }
+void ptProcessor::RunFullFrame() {
+  if (ProcessedViewport().isEmpty()) return;
 
-        //***************************************************************************
-        // a b Curves
+  // Not cancellable means no viewport either, the next interactive run gets it back.
+  FFullFrameRun = true;
+  try {
+    Run(ptProcessorPhase_RGB);
+  } catch (...) {
+    FFullFrameRun = false;
+    throw;
+  }
+  FFullFrameRun = false;
+}
 
-        hFilter = GFilterDM->GetFilterFromName(Fuid::ABCurves_LabEyeCandy);
-        if (hFilter->isActive()) {
-          m_ReportProgress(hFilter->caption());
-          hFilter->runFilter(m_Image_AfterLabEyeCandy);
-        }
+//==============================================================================
 
-        
-        //***************************************************************************
-        // Colorcontrast
+const QList<ptProcessor::TPipeStage> &ptProcessor::PipeStages() {
+  static const QList<TPipeStage> hStages = QList<TPipeStage>()
+    << TPipeStage{ptProcessorPhase_RGB, &ptProcessor::m_Image_AfterGeometry,
+                  &ptProcessor::m_Image_AfterRGB, false, QStringList()
+         << Fuid::ChannelMixer_RGB        << Fuid::Highlights_RGB          << Fuid::ColorIntensity_RGB
+         << Fuid::Brightness_RGB          << Fuid::Exposure_RGB            << Fuid::ReinhardBrighten_RGB
+         << Fuid::GammaTool_RGB           << Fuid::Normalization_RGB       << Fuid::ColorEnhancement_RGB
+         << Fuid::LMHRecovery_RGB         << Fuid::TextureContrast_RGB     << Fuid::LocalContrast1_RGB
+         << Fuid::LocalContrast2_RGB      << Fuid::SigContrastRgb_RGB      << Fuid::Levels_RGB
+         << Fuid::RgbCurve_RGB}
+    // Lab transform needs RGB input, so it has to stay the first filter of the Lab tabs.
+    << TPipeStage{ptProcessorPhase_LabCC, &ptProcessor::m_Image_AfterRGB,
+                  &ptProcessor::m_Image_AfterLabCC, false, QStringList()
+         << Fuid::LabTransform_LabCC      << Fuid::ShadowsHighlights_LabCC << Fuid::LMHRecovery_LabCC
+         << Fuid::Drc_LabCC               << Fuid::TextureCurve_LabCC      << Fuid::TextureContrast1_LabCC
+         << Fuid::TextureContrast2_LabCC  << Fuid::LocalContrast1_LabCC    << Fuid::LocalContrast2_LabCC
+         << Fuid::LocalContrastStretch1_LabCC << Fuid::LocalContrastStretch2_LabCC
+         << Fuid::SigContrastLab_LabCC    << Fuid::Saturation_LabCC        << Fuid::ColorBoost_LabCC
+         << Fuid::Levels_LabCC}
+    << TPipeStage{ptProcessorPhase_LabSN, &ptProcessor::m_Image_AfterLabCC,
+                  &ptProcessor::m_Image_AfterLabSN, false, QStringList()
+         << Fuid::ImpulseNR_LabSN         << Fuid::EAWavelets_LabSN        << Fuid::GreyCStoration_LabSN
+         << Fuid::Defringe_LabSN          << Fuid::WaveletDenoise_LabSN    << Fuid::LumaDenoise_LabSN
+         << Fuid::LumaDenoiseCurve_LabSN  << Fuid::PyramidDenoise_LabSN    << Fuid::ColorDenoise_LabSN
+         << Fuid::DetailCurve_LabSN       << Fuid::GradientSharpen_LabSN   << Fuid::Wiener_LabSN
+         << Fuid::InvDiffSharpen_LabSN    << Fuid::Usm_LabSN               << Fuid::HighpassSharpen_LabSN
+         << Fuid::FilmGrain_LabSN         << Fuid::ViewLab_LabSN}
+    << TPipeStage{ptProcessorPhase_LabEyeCandy, &ptProcessor::m_Image_AfterLabSN,
+                  &ptProcessor::m_Image_AfterLabEyeCandy, false, QStringList()
+         << Fuid::Outline_LabEyeCandy     << Fuid::LumaByHueCurve_LabEyeCandy << Fuid::SatCurve_LabEyeCandy
+         << Fuid::HueCurve_LabEyeCandy    << Fuid::LCurve_LabEyeCandy      << Fuid::ABCurves_LabEyeCandy
+         << Fuid::ColorContrast_LabEyeCandy << Fuid::ToneAdjust1_LabEyeCandy << Fuid::ToneAdjust2_LabEyeCandy
+         << Fuid::LumaAdjust_LabEyeCandy  << Fuid::SatAdjust_LabEyeCandy   << Fuid::Tone_LabEyeCandy
+         << Fuid::Vignette_LabEyeCandy}
+    // Back to RGB here also gives the L histogram in tab mode for the Lab tabs.
+    << TPipeStage{ptProcessorPhase_EyeCandy, &ptProcessor::m_Image_AfterLabEyeCandy,
+                  &ptProcessor::m_Image_AfterEyeCandy, true, QStringList()
+         << Fuid::BlackWhite_EyeCandy     << Fuid::SimpleTone_EyeCandy     << Fuid::ColorTone1_EyeCandy
+         << Fuid::ColorTone2_EyeCandy     << Fuid::CrossProcessing_EyeCandy << Fuid::SigContrastRgb_EyeCandy
+         << Fuid::TextureOverlay1_EyeCandy << Fuid::TextureOverlay2_EyeCandy << Fuid::GradualOverlay1_EyeCandy
+         << Fuid::GradualOverlay2_EyeCandy << Fuid::Vignette_EyeCandy      << Fuid::GradualBlur1_EyeCandy
+         << Fuid::GradualBlur2_EyeCandy   << Fuid::SoftglowOrton_EyeCandy  << Fuid::ColorIntensity_EyeCandy
+         << Fuid::RTone_EyeCandy          << Fuid::GTone_EyeCandy          << Fuid::BTone_EyeCandy};
+  return hStages;
+}
 
-        hFilter = GFilterDM->GetFilterFromName(Fuid::ColorContrast_LabEyeCandy);
-        if (hFilter->isActive()) {
-          m_ReportProgress(hFilter->caption());
-          hFilter->runFilter(m_Image_AfterLabEyeCandy);
-        }
+//==============================================================================
 
+void ptProcessor::RunFilterTabs(short AFromPhase) {
+  const bool hJobMode = Settings->GetInt("JobMode");
 
-        //***************************************************************************
-        // LAB Tone adjustments
+  for (const TPipeStage &hStage: PipeStages()) {
+    if (hStage.Phase < AFromPhase) continue;
 
-        hFilter = GFilterDM->GetFilterFromName(Fuid::ToneAdjust1_LabEyeCandy);
-        if (hFilter->isActive()) {
-          m_ReportProgress(hFilter->caption());
-          hFilter->runFilter(m_Image_AfterLabEyeCandy);
-        }
+    ptImage  *hInput  = this->*hStage.Input;
+    ptImage *&hOutput = this->*hStage.Output;
+    if (hJobMode) {
+      hOutput = hInput; // Job mode -> no cache
+    } else {
+      if (!hOutput) hOutput = new ptImage();
+      if (!FRoiPanRun) hOutput->Share(hInput);
+    }
+    BeginFilterTab(hInput);
 
-        hFilter = GFilterDM->GetFilterFromName(Fuid::ToneAdjust2_LabEyeCandy);
-        if (hFilter->isActive()) {
-          m_ReportProgress(hFilter->caption());
-          hFilter->runFilter(m_Image_AfterLabEyeCandy);
-        }
+    // A checkpoint already has the conversion on entry behind it.
+    const QList<TRunItem> hRunList = BuildRunList(hStage);
+    const int             hFirst   = ResumeFromCheckpoint(hRunList, hOutput);
 
+    if (hFirst == 0 && hStage.RgbOnEntry && hOutput->m_ColorSpace == ptSpace_Lab) {
+      ReportProgress(tr("Lab to RGB"));
+      hOutput->detach();
+      hOutput->LabToRGB(Settings->GetInt("WorkColor"));
+      TRACEMAIN("Done conversion to RGB at %d ms.",FRunTimer.elapsed());
+    }
 
-        //***************************************************************************
-        // Luminance adjustment
+    for (int i = hFirst; i < hRunList.size(); i++) {
+      RunFilter(hRunList.at(i), hOutput);
+    }
 
-        hFilter = GFilterDM->GetFilterFromName(Fuid::LumaAdjust_LabEyeCandy);
-        if (hFilter->isActive()) {
-          m_ReportProgress(hFilter->caption());
-          hFilter->runFilter(m_Image_AfterLabEyeCandy);
-        }
+    EndFilterTab(hOutput);
+  }
+}
 
+//==============================================================================
 
-        //***************************************************************************
-        // Saturation adjustment
+int ptProcessor::ResumeFromCheckpoint(const QList<TRunItem> &ARunList, ptImage *AImage) {
+  if (!FFilterCacheActive || FRoiActive) return 0;
 
-        hFilter = GFilterDM->GetFilterFromName(Fuid::SatAdjust_LabEyeCandy);
-        if (hFilter->isActive()) {
-          m_ReportProgress(hFilter->caption());
-          hFilter->runFilter(m_Image_AfterLabEyeCandy);
-        }
+  // The keys of all filters of the tab, as if each of them ran.
+  QList<QByteArray> hKeys;
+  QByteArray        hKey = FCacheKey;
+  for (const TRunItem &hItem: ARunList) {
+    if (hItem.Filter->isActive()) hKey = hItem.Filter->cacheKey(hKey);
+    hKeys << hKey;
+  }
 
+  // The last checkpoint wins, it already contains everything before it.
+  for (int i = hKeys.size() - 1; i >= 0; i--) {
+    TImagePtr hCached = FFilterCache->find(hKeys.at(i));
+    if (!hCached) continue;
+    AImage->Share(hCached.get());
+    FCacheKey = hKeys.at(i);
+    return i + 1;
+  }
+  return 0;
+}
 
-        //***************************************************************************
-        // LAB Tone second stage
+//==============================================================================
 
-        hFilter = GFilterDM->GetFilterFromName(Fuid::Tone_LabEyeCandy);
-        if (hFilter->isActive()) {
-          m_ReportProgress(hFilter->caption());
-          hFilter->runFilter(m_Image_AfterLabEyeCandy);
-        }
+QList<ptProcessor::TRunItem> ptProcessor::BuildRunList(const TPipeStage &AStage) const {
+  QList<TRunItem> hRunList;
 
+  if (Settings->GetInt("JobMode")) {
+    for (const QString &hId: AStage.FilterIds) {
+      ptFilterBase *hFilter = GFilterDM->GetFilterFromName(hId);
+      if (hFilter->isActive())
+        hRunList << TRunItem{hFilter, (int)hFilter->inputSpace()};
+    }
+    PlanColorSpaces(hRunList);
+    return hRunList;
+  }
 
-        //***************************************************************************
-        // Vignette
+  // All filters of a stage live in the same tab, the first one tells which.
+  const int hGroup = GFilterDM->GetFilterFromName(AStage.FilterIds.first())->parentTabIdx();
+  for (ptFilterBase *hFilter: GFilterDM->activeGroup(hGroup)) {
+    // The tab may show filters that are not part of the pipe (yet).
+    if (AStage.FilterIds.contains(hFilter->uniqueName()))
+      hRunList << TRunItem{hFilter, (int)hFilter->inputSpace()};
+  }
+  PlanColorSpaces(hRunList);
+  return hRunList;
+}
 
-        hFilter = GFilterDM->GetFilterFromName(Fuid::Vignette_LabEyeCandy);
-        if (hFilter->isActive()) {
-          m_ReportProgress(hFilter->caption());
-          hFilter->runFilter(m_Image_AfterLabEyeCandy);
-        }
+//==============================================================================
 
+void ptProcessor::PlanColorSpaces(QList<TRunItem> &ARunList) {
+  const int hLch = (int)ptFilterBase::TColorSpace::Lch;
+  const int hLab = (int)ptFilterBase::TColorSpace::Lab;
 
+  for (int i = 0; i < ARunList.size(); ++i) {
+    if (ARunList[i].InputSpace != hLch) continue;
+    const bool hInRun = (i > 0 && ARunList[i-1].InputSpace == hLch) ||
+                        (i+1 < ARunList.size() && ARunList[i+1].InputSpace == hLch);
+    if (!hInRun) ARunList[i].InputSpace = hLab;
+  }
+}
 
+//==============================================================================
 
-      case ptProcessorPhase_EyeCandy : // Run EyeCandy.
+void ptProcessor::ConvertSpace(ptImage *AImage, const int ASpace) {
+  typedef ptFilterBase::TColorSpace TSpace;
+  const short hSpace = AImage->m_ColorSpace;
+
+  switch ((TSpace)ASpace) {
+    case TSpace::Rgb:
+      if (hSpace != ptSpace_Lab && hSpace != ptSpace_LCH && hSpace != ptSpace_XYZ) return;
+      break;
+    case TSpace::Lab:
+      if (hSpace == ptSpace_Lab) return;
+      break;
+    case TSpace::Lch:
+      if (hSpace == ptSpace_LCH) return;
+      break;
+    default:
+      // Any space, but only the hue filters know LCh.
+      if (hSpace != ptSpace_LCH) return;
+      break;
+  }
 
-        if (Settings->GetInt("JobMode")) {
-          m_Image_AfterEyeCandy = m_Image_AfterLabEyeCandy; // Job mode -> no cache
-        } else {
-          if (!m_Image_AfterEyeCandy) m_Image_AfterEyeCandy = new ptImage();
-          m_Image_AfterEyeCandy->Set(m_Image_AfterLabEyeCandy);
-        }
+  ptProfileScope hProfile("Colour space conversion", "filter", AImage);
+  // LCh lives in its own planes, every other conversion writes to the pixels in place.
+  const bool hPolar = hSpace == ptSpace_LCH || (hSpace == ptSpace_Lab && (TSpace)ASpace == TSpace::Lch);
+  if (!hPolar) AImage->detach();
 
-        // Has to be here to allow L histogram in Tabmode
-        // Come back from Lab space if we ever were there ...
-        if (m_Image_AfterEyeCandy->m_ColorSpace == ptSpace_Lab) {
-          m_ReportProgress(tr("Lab to RGB"));
-          m_Image_AfterEyeCandy->LabToRGB(Settings->GetInt("WorkColor"));
-          TRACEMAIN("Done conversion to RGB at %d ms.",FRunTimer.elapsed());
-        }
+  switch ((TSpace)ASpace) {
+    case TSpace::Rgb: AImage->toRGB();               break;
+    case TSpace::Lch: AImage->toLab()->LabToLch();   break;
+    default:          AImage->toLab();               break;
+  }
+}
 
 
-        //***************************************************************************
-        // Black & White Styler
+//==============================================================================
 
-        hFilter = GFilterDM->GetFilterFromName(Fuid::BlackWhite_EyeCandy);
-        if (hFilter->isActive()) {
-          m_ReportProgress(hFilter->caption());
-          hFilter->runFilter(m_Image_AfterEyeCandy);
-        }
+void ptProcessor::RunFilter(const TRunItem &AItem, ptImage *AImage) {
+  ptFilterBase *hFilter = AItem.Filter;
+  if (!hFilter->isActive()) return;
 
+  CheckCancelled();
 
-        //***************************************************************************
-        // Simple Tone
+  // The viewport is processed as one window at the tab end, like a single strip.
+  if (FRoiActive) {
+    FStripQueue.append(hFilter);
+    return;
+  }
 
-        hFilter = GFilterDM->GetFilterFromName(Fuid::SimpleTone_EyeCandy);
-        if (hFilter->isActive()) {
-          m_ReportProgress(hFilter->caption());
-          hFilter->runFilter(m_Image_AfterEyeCandy);
-        }
+  // Continue the key chain of ResumeFromCheckpoint() for the filters that really run.
+  if (FFilterCacheActive) FCacheKey = hFilter->cacheKey(FCacheKey);
 
+  // Queued strip filters must run first, so only fuse while the queue is empty.
+  if (hFilter->pointSpace() != ptFilterBase::TPointSpace::None && FStripQueue.isEmpty()) {
+    FuseFilter(hFilter, AImage);
+    return;
+  }
 
-        //***************************************************************************
-        // Color toning
+  if (FProcessorMode == ptProcessorMode_Full &&
+      Settings->GetInt("FullPipeStripHeight") > 0 &&
+      hFilter->haloRadius() >= 0)
+  {
+    // The strip filters work on the output of the fused ones.
+    if (FFusedLut) FlushFilters(AImage);
+    FStripQueue.append(hFilter);
+    return;
+  }
 
-        hFilter = GFilterDM->GetFilterFromName(Fuid::ColorTone1_EyeCandy);
-        if (hFilter->isActive()) {
-          m_ReportProgress(hFilter->caption());
-          hFilter->runFilter(m_Image_AfterEyeCandy);
-        }
+  // A filter that needs the whole image: bring the image up to date first.
+  FlushFilters(AImage);
+  ConvertSpace(AImage, AItem.InputSpace);
+
+  ReportProgress(hFilter->caption());
+  if (FFloatPipe && hFilter->supportsFloat()) AImage->toFloat();
+  QTime hTimer;
+  hTimer.start();
+  hFilter->runFilter(AImage);
+  UpdateFilterCost(hFilter, AImage, hTimer.elapsed());
+
+  // The cache holds interleaved 16 bit images. A float or planar result is remembered as such
+  // a copy, while the pipe goes on with the original. LCh results are intermediate.
+  if (FFilterCacheActive && IsCheckpoint(hFilter, AImage) && AImage->m_ColorSpace != ptSpace_LCH) {
+    if (AImage->isFloat() || AImage->isPlanar()) {
+      ptImage hCopy;
+      hCopy.Share(AImage);
+      hCopy.toUInt16()->toInterleaved();
+      FFilterCache->insert(FCacheKey, &hCopy);
+    } else {
+      FFilterCache->insert(FCacheKey, AImage);
+    }
+  }
+}
 
-        hFilter = GFilterDM->GetFilterFromName(Fuid::ColorTone2_EyeCandy);
-        if (hFilter->isActive()) {
-          m_ReportProgress(hFilter->caption());
-          hFilter->runFilter(m_Image_AfterEyeCandy);
-        }
+//==============================================================================
 
+void ptProcessor::UpdateFilterCost(const ptFilterBase *AFilter, const ptImage *AImage, int AMsecs) {
+  const double hMPix = (double)AImage->m_Width*AImage->m_Height/1e6;
+  if (hMPix <= 0.0) return;
 
-        //***************************************************************************
-        // Crossprocessing
+  // Smoothed, single runs vary with what else the machine is doing.
+  const double hCost = AMsecs/hMPix;
+  auto hIt = FFilterCost.find(AFilter->uniqueName());
+  if (hIt == FFilterCost.end()) {
+    FFilterCost.insert(AFilter->uniqueName(), hCost);
+  } else {
+    *hIt = 0.5*(*hIt + hCost);
+  }
+}
 
-        hFilter = GFilterDM->GetFilterFromName(Fuid::CrossProcessing_EyeCandy);
-        if (hFilter->isActive()) {
-          m_ReportProgress(hFilter->caption());
-          hFilter->runFilter(m_Image_AfterEyeCandy);
-        }
+//==============================================================================
 
+bool ptProcessor::IsCheckpoint(const ptFilterBase *AFilter, const ptImage *AImage) const {
+  if (AFilter->isSlow()) return true;
 
-        //***************************************************************************
-        // RGB Contrast.
+  const double hMPix = (double)AImage->m_Width*AImage->m_Height/1e6;
+  return FFilterCost.value(AFilter->uniqueName(), 0.0)*hMPix >= Settings->GetInt("CheckpointMinCost");
+}
 
-        hFilter = GFilterDM->GetFilterFromName(Fuid::SigContrastRgb_EyeCandy);
-        if (hFilter->isActive()) {
-          m_ReportProgress(hFilter->caption());
-          hFilter->runFilter(m_Image_AfterEyeCandy);
-        }
+//==============================================================================
 
+void ptProcessor::FuseFilter(ptFilterBase *AFilter, ptImage *AImage) {
+  const bool hLab = (AFilter->pointSpace() == ptFilterBase::TPointSpace::Lab);
 
-        //***************************************************************************
-        // Texture Overlay
+  if (FFusedLut && (FFusedLut->m_ColorSpace == ptSpace_Lab) != hLab) {
+    FlushFilters(AImage);
+  }
 
-        hFilter = GFilterDM->GetFilterFromName(Fuid::TextureOverlay1_EyeCandy);
-        if (hFilter->isActive()) {
-          m_ReportProgress(hFilter->caption());
-          hFilter->runFilter(m_Image_AfterEyeCandy);
-        }
+  if (!FFusedLut) {
+    // Labelled in the filter's space, so its toRGB()/toLab() calls are no-ops on the table.
+    FFusedLut.reset(new ptImage());
+    FFusedLut->SetIdentityLut(hLab ? ptSpace_Lab : ptImage::getCurrentRGB());
+  }
 
-        hFilter = GFilterDM->GetFilterFromName(Fuid::TextureOverlay2_EyeCandy);
-        if (hFilter->isActive()) {
-          m_ReportProgress(hFilter->caption());
-          hFilter->runFilter(m_Image_AfterEyeCandy);
-        }
+  // Running the filter on the output of the previous ones composes the tables.
+  ReportProgress(AFilter->caption());
+  AFilter->runFilter(FFusedLut.get());
+}
 
+//==============================================================================
 
-        //***************************************************************************
-        // Gradual Overlay
+void ptProcessor::FlushFilters(ptImage *AImage) {
+  if (FRoiActive) {
+    FlushViewport(AImage);
+    return;
+  }
 
-        hFilter = GFilterDM->GetFilterFromName(Fuid::GradualOverlay1_EyeCandy);
-        if (hFilter->isActive()) {
-          m_ReportProgress(hFilter->caption());
-          hFilter->runFilter(m_Image_AfterEyeCandy);
-        }
+  if (FFusedLut) {
+    ptProfileScope hProfile("Fused point filters", "filter", AImage);
+    AImage->toUInt16();
+    ConvertSpace(AImage, (int)(FFusedLut->m_ColorSpace == ptSpace_Lab ? ptFilterBase::TColorSpace::Lab
+                                                                      : ptFilterBase::TColorSpace::Rgb));
+    AImage->detach();
+    AImage->ApplyLut(FFusedLut.get());   // a planar image only has the changed planes touched
+    FFusedLut.reset();
+    // A lookup table pass is cheaper than a checkpoint's memory, see IsCheckpoint().
+  }
 
-        hFilter = GFilterDM->GetFilterFromName(Fuid::GradualOverlay2_EyeCandy);
-        if (hFilter->isActive()) {
-          m_ReportProgress(hFilter->caption());
-          hFilter->runFilter(m_Image_AfterEyeCandy);
-        }
+  if (FStripQueue.isEmpty()) return;
 
+  // The strips are cut from the pixels, which an LCh image does not have.
+  if (AImage->m_ColorSpace == ptSpace_LCH) ConvertSpace(AImage, (int)ptFilterBase::TColorSpace::Lab);
+  AImage->toUInt16()->toInterleaved();
 
-        //***************************************************************************
-        // Vignette
+  // Each filter needs its own halo from the output of the previous one,
+  // so the halos of a filter chain add up.
+  int         hHalo = 0;
+  QStringList hCaptions;
+  for (ptFilterBase *hFilter: FStripQueue) {
+    hHalo += hFilter->haloRadius();
+    hCaptions << hFilter->caption();
+  }
+  ReportProgress(hCaptions.join(", "));
 
-        hFilter = GFilterDM->GetFilterFromName(Fuid::Vignette_EyeCandy);
-        if (hFilter->isActive()) {
-          m_ReportProgress(hFilter->caption());
-          hFilter->runFilter(m_Image_AfterEyeCandy);
-        }
+  const int hWidth       = AImage->m_Width;
+  const int hHeight      = AImage->m_Height;
+  const int hStripHeight = qMax(Settings->GetInt("FullPipeStripHeight"), hHalo);
 
+  if (hStripHeight >= hHeight) {
+    for (ptFilterBase *hFilter: FStripQueue)
+      hFilter->runFilter(AImage);
+    FStripQueue.clear();
+    return;
+  }
 
-        //***************************************************************************
-        // Gradual Blur 1
+  ptImage      hStrip;
+  TImage16Data hTail;   // unprocessed input rows just above the current strip
+  short        hColorSpace = AImage->m_ColorSpace;
 
-        hFilter = GFilterDM->GetFilterFromName(Fuid::GradualBlur1_EyeCandy);
-        if (hFilter->isActive()) {
-          m_ReportProgress(hFilter->caption());
-          hFilter->runFilter(m_Image_AfterEyeCandy);
-        }
+  for (int hTop = 0; hTop < hHeight; hTop += hStripHeight) {
+    const int hRows       = qMin(hStripHeight, hHeight - hTop);
+    const int hHaloTop    = qMin(hHalo, hTop);
+    const int hHaloBottom = qMin(hHalo, hHeight - hTop - hRows);
 
+    hStrip.SetRows(AImage, hTop - hHaloTop, hHaloTop + hRows + hHaloBottom);
+    // The rows above hTop already hold output of the previous strip.
+    if (hHaloTop > 0)
+      std::copy(hTail.end() - (size_t)hHaloTop*hWidth, hTail.end(), hStrip.m_Data->begin());
 
-        //***************************************************************************
-        // Gradual Blur 2
+    for (ptFilterBase *hFilter: FStripQueue)
+      hFilter->runFilter(&hStrip);
+    // PutRows() copies interleaved 16 bit rows, the filters may have left float or planes.
+    hStrip.toUInt16()->toInterleaved();
 
-        hFilter = GFilterDM->GetFilterFromName(Fuid::GradualBlur2_EyeCandy);
-        if (hFilter->isActive()) {
-          m_ReportProgress(hFilter->caption());
-          hFilter->runFilter(m_Image_AfterEyeCandy);
-        }
+    // Keep the input the next strip needs as its upper halo before overwriting it.
+    const int hKeep = qMin(hHalo, hRows);
+    hTail.assign(AImage->m_Data->begin() + (size_t)(hTop + hRows - hKeep)*hWidth,
+                 AImage->m_Data->begin() + (size_t)(hTop + hRows)*hWidth);
 
+    AImage->PutRows(&hStrip, hHaloTop, hTop, hRows);
+    hColorSpace = hStrip.m_ColorSpace;
+  }
 
-        //***************************************************************************
-        // Softglow
+  // Filters may have switched between RGB and Lab on the way.
+  AImage->m_ColorSpace = hColorSpace;
+  FStripQueue.clear();
 
-        hFilter = GFilterDM->GetFilterFromName(Fuid::SoftglowOrton_EyeCandy);
-        if (hFilter->isActive()) {
-          m_ReportProgress(hFilter->caption());
-          hFilter->runFilter(m_Image_AfterEyeCandy);
-        }
+  TRACEMAIN("Done strip processing at %d ms.", FRunTimer.elapsed());
+}
 
+//==============================================================================
 
-        //***************************************************************************
-        // Vibrance
+void ptProcessor::FlushViewport(ptImage *AImage) {
+  int         hTabHalo = 0;
+  QStringList hCaptions;
+  for (ptFilterBase *hFilter: FStripQueue) {
+    hTabHalo += hFilter->haloRadius();
+    hCaptions << hFilter->caption();
+  }
+  FRoiHalo = qMax(0, FRoiHalo - hTabHalo);
 
-        hFilter = GFilterDM->GetFilterFromName(Fuid::ColorIntensity_EyeCandy);
-        if (hFilter->isActive()) {
-          m_ReportProgress(hFilter->caption());
-          hFilter->runFilter(m_Image_AfterEyeCandy);
-        }
+  // Outside the viewport a normal run leaves the tab input untouched.
+  if (FStripQueue.isEmpty() && !FRoiPanRun) return;
 
+  const QRect hFrame(0, 0, AImage->m_Width, AImage->m_Height);
+  const QRect hOut = FRoi.adjusted(-FRoiHalo, -FRoiHalo, FRoiHalo, FRoiHalo) & hFrame;
+  const QRect hIn  = hOut.adjusted(-hTabHalo, -hTabHalo, hTabHalo, hTabHalo) & hFrame;
+  if (hOut.isEmpty()) {
+    FStripQueue.clear();
+    return;
+  }
 
-        //***************************************************************************
-        // Tone curves
+  if (!hCaptions.isEmpty()) ReportProgress(hCaptions.join(", "));
+
+  // In a pan run the tab image still holds the previous result, so start from the tab input.
+  ptImage hWindow;
+  hWindow.SetRect(FRoiPanRun ? FTabInput : AImage, hIn.x(), hIn.y(), hIn.width(), hIn.height());
+  for (ptFilterBase *hFilter: FStripQueue)
+    hFilter->runFilter(&hWindow);
+  hWindow.toUInt16()->toInterleaved();
+
+  // Filters may have switched between RGB and Lab on the way.
+  if (hWindow.m_ColorSpace != AImage->m_ColorSpace) {
+    ptImage *hTarget = FRoiPanRun ? &hWindow : AImage;
+    const short hSpace = FRoiPanRun ? AImage->m_ColorSpace : hWindow.m_ColorSpace;
+    hTarget->detach();
+    if (hSpace == ptSpace_Lab) {
+      hTarget->toLab();
+    } else {
+      hTarget->toRGB();
+    }
+  }
 
-        hFilter = GFilterDM->GetFilterFromName(Fuid::RTone_EyeCandy);
-        if (hFilter->isActive()) {
-          m_ReportProgress(tr("Applying R curve"));
-          hFilter->runFilter(m_Image_AfterEyeCandy);
-          TRACEMAIN("Done R Curve at %d ms.",FRunTimer.elapsed());
-        }
+  AImage->PutRect(&hWindow, hOut.x() - hIn.x(), hOut.y() - hIn.y(),
+                  hOut.x(), hOut.y(), hOut.width(), hOut.height());
+  FStripQueue.clear();
 
-        hFilter = GFilterDM->GetFilterFromName(Fuid::GTone_EyeCandy);
-        if (hFilter->isActive()) {
-          m_ReportProgress(tr("Applying G curve"));
-          hFilter->runFilter(m_Image_AfterEyeCandy);
-          TRACEMAIN("Done G Curve at %d ms.",FRunTimer.elapsed());
-        }
+  TRACEMAIN("Done viewport processing at %d ms.", FRunTimer.elapsed());
+}
 
-        hFilter = GFilterDM->GetFilterFromName(Fuid::BTone_EyeCandy);
-        if (hFilter->isActive()) {
-          m_ReportProgress(tr("Applying B curve"));
-          hFilter->runFilter(m_Image_AfterEyeCandy);
-          TRACEMAIN("Done B Curve at %d ms.",FRunTimer.elapsed());
-        }
+//==============================================================================
 
+void ptProcessor::BeginFilterTab(const ptImage *AInput) {
+  FTabInput = AInput;
 
-  //***************************************************************************
-  Exit:
+  QByteArray hInputKey = FCheckpointKeys.value(AInput);
+  if (hInputKey.isEmpty()) {
+    hInputKey = NewCacheGeneration();
+  }
 
-        Settings->SetValue("PipeImageW",m_Image_AfterEyeCandy->m_Width);
-        Settings->SetValue("PipeImageH",m_Image_AfterEyeCandy->m_Height);
+  // Several filters also depend on these global settings.
+  QCryptographicHash hHash(QCryptographicHash::Md5);
+  hHash.addData(hInputKey);
+  hHash.addData(QByteArray::number(Settings->GetDouble("InputPowerFactor")));
+  hHash.addData(QByteArray::number(Settings->GetInt("WorkColor")));
+  FCacheKey = hHash.result();
+}
 
-      case ptProcessorPhase_Output : // Run Output.
+//==============================================================================
 
-        TRACEMAIN("Done pipe processing at %d ms.",FRunTimer.elapsed());
+void ptProcessor::EndFilterTab(ptImage *AImage) {
+  FlushFilters(AImage);
+  // Tab images are shown, cached and handed to the next tab as interleaved 16 bit Lab or RGB.
+  ConvertSpace(AImage, (int)ptFilterBase::TColorSpace::Any);
+  AImage->toUInt16()->toInterleaved();
 
-        break;
+  // A viewport run leaves most of the image stale, that is no checkpoint to continue from.
+  if (FFilterCacheActive && !FRoiActive) {
+    FCheckpointKeys.insert(AImage, FCacheKey);
+  } else {
+    FCheckpointKeys.remove(AImage);
+  }
+}
 
-      default : // Should not happen.
-        assert(!"Invalid processor phase in ptProcessor::Run()");
-    }
+//==============================================================================
 
-    m_ReportProgress(tr("Ready"));
-  } catch (std::bad_alloc) {
-    printf("\n*************************\n\nMemory error in processor\n\n*************************\n\n");
-    fflush(stdout);
-    throw std::bad_alloc();
-  }
+QByteArray ptProcessor::NewCacheGeneration() {
+  return QByteArray("generation") + QByteArray::number(++FCacheGeneration);
 }
 
 //==============================================================================
 
 void ptProcessor::RunLocalEdit(ptProcessorStopBefore StopBefore) {
   ptFilterBase *hFilter = nullptr;
+  RestoreStage(m_Image_AfterDcRaw);
 
   // We fetch the image from the input processing
   if (!Settings->useRAWHandling()) {
     // image is a bitmap
     if (StopBefore == ptProcessorStopBefore::NoStop) {
-      m_ReportProgress(tr("Transfer Bitmap"));
+      ReportProgress(tr("Transfer Bitmap"));
     }
 
     // This will be equivalent to m_PipeSize EXCEPT if overwritten
@@ -1286,7 +1255,7 @@ void ptProcessor::RunLocalEdit(ptProcessorStopBefore StopBefore) {
   hFilter = GFilterDM->GetFilterFromName(Fuid::SpotTuning_Local);
   if (hFilter->isActive()) {
     if (StopBefore == ptProcessorStopBefore::NoStop) {
-      m_ReportProgress(tr("Spot tuning"));
+      ReportProgress(tr("Spot tuning"));
     }
 
     hFilter->runFilter(m_Image_AfterLocalEdit);
@@ -1299,9 +1268,13 @@ void ptProcessor::RunLocalEdit(ptProcessorStopBefore StopBefore) {
 //==============================================================================
 
 void ptProcessor::RunGeometry(ptProcessorStopBefore StopBefore) {
+  RestoreStage(m_Image_AfterLocalEdit);
   if (!m_Image_AfterGeometry) m_Image_AfterGeometry = new ptImage();
   m_Image_AfterGeometry->Set(m_Image_AfterLocalEdit);
 
+  // Everything after this point has to be recalculated.
+  FCheckpointKeys.insert(m_Image_AfterGeometry, NewCacheGeneration());
+
   // Often used.
   int TmpScaled = Settings->GetInt("Scaled");
 
@@ -1311,7 +1284,7 @@ void ptProcessor::RunGeometry(ptProcessorStopBefore StopBefore) {
       Settings->ToolIsActive("TabLensfunDistortion") || Settings->ToolIsActive("TabLensfunGeometry") )
   {
     if (StopBefore == ptProcessorStopBefore::NoStop) {
-      m_ReportProgress(tr("Lensfun corrections"));
+      ReportProgress(tr("Lensfun corrections"));
     }
     int modflags = 0;
 
@@ -1463,7 +1436,7 @@ void ptProcessor::RunGeometry(ptProcessorStopBefore StopBefore) {
   if (Settings->ToolIsActive("TabDefish"))
   {
     if (StopBefore == ptProcessorStopBefore::NoStop) {
-      m_ReportProgress(tr("Defish correction"));
+      ReportProgress(tr("Defish correction"));
     }
 
     lfLens LensData = lfLens();
@@ -1522,7 +1495,7 @@ void ptProcessor::RunGeometry(ptProcessorStopBefore StopBefore) {
   // Rotation
   if (Settings->ToolIsActive("TabRotation")) {
     if (StopBefore == ptProcessorStopBefore::NoStop) {
-      m_ReportProgress(tr("Perspective transform"));
+      ReportProgress(tr("Perspective transform"));
     }
 
     m_Image_AfterGeometry->ptCIPerspective(Settings->GetDouble("Rotate"),
@@ -1576,7 +1549,7 @@ void ptProcessor::RunGeometry(ptProcessorStopBefore StopBefore) {
       if (StopBefore == ptProcessorStopBefore::NoStop) {
         TRACEKEYVALS("CropW","%d",Settings->GetInt("CropW"));
         TRACEKEYVALS("CropH","%d",Settings->GetInt("CropH"));
-        m_ReportProgress(tr("Cropping"));
+        ReportProgress(tr("Cropping"));
       }
 
       m_Image_AfterGeometry->Crop(Settings->GetInt("CropX") >> TmpScaled,
@@ -1603,7 +1576,7 @@ void ptProcessor::RunGeometry(ptProcessorStopBefore StopBefore) {
   // Liquid rescale
   if (Settings->ToolIsActive("TabLiquidRescale")) {
     if (StopBefore == ptProcessorStopBefore::NoStop) {
-      m_ReportProgress(tr("Seam carving"));
+      ReportProgress(tr("Seam carving"));
     }
 
     if (Settings->GetInt("LqrScaling") == ptLqr_ScaleRelative) {
@@ -1626,7 +1599,7 @@ void ptProcessor::RunGeometry(ptProcessorStopBefore StopBefore) {
   // Resize
   if (Settings->ToolIsActive("TabResize")) {
     if (StopBefore == ptProcessorStopBefore::NoStop) {
-      m_ReportProgress(tr("Resize image"));
+      ReportProgress(tr("Resize image"));
     }
 
     float WidthIn = m_Image_AfterGeometry->m_Width;
@@ -1647,7 +1620,7 @@ void ptProcessor::RunGeometry(ptProcessorStopBefore StopBefore) {
   // Flip
   if (Settings->ToolIsActive("TabFlip")) {
     if (StopBefore == ptProcessorStopBefore::NoStop) {
-      m_ReportProgress(tr("Flip image"));
+      ReportProgress(tr("Flip image"));
     }
 
     m_Image_AfterGeometry->Flip(Settings->GetInt("FlipMode"));
@@ -32,15 +32,25 @@
 
 #include <QString>
 #include <QTime>
+#include <QList>
+#include <QHash>
+#include <QByteArray>
+#include <QStringList>
+#include <QRect>
+#include <QRegion>
 #include <QCoreApplication>
 
 #include <vector>
+#include <memory>
 
 //==============================================================================
 
 // forward for faster compilation
 class ptDcRaw;
 class ptImage;
+class ptFilterBase;
+class ptImageCache;
+class ptStageCache;
 
 //==============================================================================
 
@@ -79,6 +89,13 @@ public:
            short WithIdentify  = 1,
            short ProcessorMode = ptProcessorMode_Preview);
 
+  /*! Runs the tabs from \c Phase on (\c ptProcessorPhase_RGB to \c ptProcessorPhase_EyeCandy)
+      on a copy of their input checkpoint scaled down by 2^\c AScale and puts the proxy result
+      of the tab \c AShowPhase into \c AProxy. The pipe size images stay untouched, so a normal
+      run from \c Phase is still needed afterwards. Returns \c false when the proxy run was
+      cancelled or not possible. */
+  bool RunProxy(short Phase, short AScale, short AShowPhase, ptImage *AProxy);
+
   /*! Rerun Local Edit stage. */
   void RunLocalEdit(ptProcessorStopBefore StopBefore = ptProcessorStopBefore::NoStop);
 
@@ -112,15 +129,162 @@ public:
   //void (*m_ReportProgress)(const QString Message);
   PReportProgressFunc m_ReportProgress;
 
-  // Reporting
+  // Reporting. In an interactive run this is also where a superseded run stops.
   void ReportProgress(const QString Message);
 
+  /*! Interactive runs can be superseded by a newer request. \c RequestCancel() marks the
+      current run as stale, it then stops at the next filter boundary or progress report.
+      The stages from that point on are left invalid, so the caller has to run the pipe
+      again from a phase not later than the one of the cancelled run.
+      \c IsCancellable() is \c true while such a run is in progress. */
+  void RequestCancel();
+  bool IsCancellable() const;
+
+  /*! Interactive runs only process the part of the RGB to EyeCandy tabs that is visible,
+      plus the halos the filters need around it. \c SetViewport() sets that rectangle in
+      pipe image coordinates for the next run starting at the RGB tab or earlier. A rectangle
+      that covers most of the image switches viewport processing off, as does a change of the
+      image size before the next run. It returns \c true when part of the area to process has
+      not been processed yet. A following run of phase \c ptProcessorPhase_RGB then only
+      fills in the missing area instead of starting over.
+      \c ProcessedViewport() is the rectangle processed by the last run, or an empty one
+      when the whole image was processed. */
+  bool  SetViewport(const QRect &ARect);
+  QRect ProcessedViewport() const;
+
+  /*! Brings the RGB to EyeCandy tabs up to date for the whole image after a viewport run,
+      e.g. before \c m_Image_AfterEyeCandy is written or exported. Does nothing when the
+      last run processed the whole image already. The run cannot be cancelled. */
+  void RunFullFrame();
+
+  /*! Checkpoints beyond the “StageCacheBudget” setting are spilled to scratch files after
+      an interactive run. Call \c RestoreStage() before reading pixels of one of the
+      \c m_Image_After* images outside of a run. \c m_Image_AfterGeometry and
+      \c m_Image_AfterEyeCandy are never spilled. A checkpoint whose scratch file cannot be
+      read back comes back as a null image (see \c ptImage::isNull()); the next run that
+      needs it starts early enough to compute it again. Returns \c AStage. */
+  ptImage* RestoreStage(ptImage *AStage);
+
   // Factor for size dependend filters
   float  m_ScaleFactor;
 
 //==============================================================================
 
 private:
-  QTime FRunTimer;
+  /*! One filter tab of the pipe: the checkpoint it reads, the one it writes and its filters in
+      pipe order. The pipe is the sequence of \c PipeStages(), \c RunFilterTabs() runs it. */
+  struct TPipeStage {
+    short                 Phase;
+    ptImage* ptProcessor::*Input;
+    ptImage* ptProcessor::*Output;
+    bool                  RgbOnEntry;     // back from Lab before the first filter
+    QStringList           FilterIds;
+  };
+  static const QList<TPipeStage> &PipeStages();
+
+  /*! An active filter of a stage together with the colour space it is handed its input in,
+      see \c PlanColorSpaces(). */
+  struct TRunItem {
+    ptFilterBase               *Filter;
+    int                         InputSpace;   // ptFilterBase::TColorSpace
+  };
+
+  /*! Runs the filter of \c AItem on \c AImage if it is active. In the interactive pipe the
+      result of a checkpoint filter is stored to the filter cache, see \c IsCheckpoint(). In
+      full size runs filters with a known halo are queued instead and processed strip by strip
+      by \c FlushFilters(). Consecutive point filters in the same colour space are not run on
+      the image at all but on a lookup table, which is applied once when a different filter
+      or the tab end follows. A filter that runs on the image gets it in its planned input
+      space, see \c ConvertSpace(). */
+  void RunFilter(const TRunItem &AItem, ptImage *AImage);
+
+  /*! Runs the filter tabs from \c AFromPhase to the end of the pipe. */
+  void RunFilterTabs(short AFromPhase);
+
+  /*! Looks up the results of the filters in \c ARunList in the filter cache, from the last
+      one backwards. On a hit the cached image is shared into \c AImage, the cache key moves
+      on to that filter and the index of the filter after it is returned; the run continues
+      there. Returns 0 when nothing is cached. */
+  int  ResumeFromCheckpoint(const QList<TRunItem> &ARunList, ptImage *AImage);
+
+  /*! Returns the active filters of \c AStage in pipe order. In GUI mode this comes straight
+      from the active lists of ptFilterDM, so inactive filters are never looked at. In job mode
+      the filters have no positions and the stage's filter list is checked one by one. */
+  QList<TRunItem> BuildRunList(const TPipeStage &AStage) const;
+
+  /*! Decides in which space the filters of \c ARunList get the image. Filters of a run of at
+      least two hue filters (\c TColorSpace::Lch) get it in LCh, so that the run costs one
+      Lab -> LCh -> Lab round trip; a single hue filter gets Lab and does its own polar maths.
+      Any other filter ends such a run. */
+  static void PlanColorSpaces(QList<TRunItem> &ARunList);
+
+  /*! Converts \c AImage to \c ASpace (a \c ptFilterBase::TColorSpace) unless it already is
+      there. This is the only place the pipe changes colour spaces between filters. */
+  void ConvertSpace(ptImage *AImage, const int ASpace);
+
+  /*! Brings \c AImage up to date: applies the fused lookup table
+      and runs all queued filters on overlapping strips of the image, so that filter temporaries
+      only ever cover one strip. */
+  void FlushFilters(ptImage *AImage);
+
+  /*! Filter results become checkpoints in the filter cache only when they are expensive to
+      recompute: for filters flagged slow and for those whose measured run time on the current
+      image size reaches the “CheckpointMinCost” setting (ms). A later run then restarts from
+      the nearest checkpoint before the changed filter (see \c ResumeFromCheckpoint()), while
+      cheap results do not push the expensive ones out of the cache. */
+  void UpdateFilterCost(const ptFilterBase *AFilter, const ptImage *AImage, int AMsecs);
+  bool IsCheckpoint(const ptFilterBase *AFilter, const ptImage *AImage) const;
+
+  /*! Adds the point filter \c AFilter to the fused lookup table, see \c RunFilter(). */
+  void FuseFilter(ptFilterBase *AFilter, ptImage *AImage);
+
+  /*! \c FlushFilters() for viewport runs: runs the queued filters on the viewport plus the
+      halo of the following tabs and puts the result back into \c AImage. */
+  void FlushViewport(ptImage *AImage);
+
+  /*! Start and end of a filter tab. They track the cache keys of the tab checkpoints so that
+      a run starting in a later tab can continue the key chain. */
+  void BeginFilterTab(const ptImage *AInput);
+  void EndFilterTab(ptImage *AImage);
+  QByteArray NewCacheGeneration();
+
+  /*! Reads back the checkpoints a run from \c Phase on needs, and spills the cold ones
+      after an interactive run, see \c RestoreStage(). Returns the phase the run has to
+      start from, earlier than \c Phase when its input checkpoint was lost. */
+  short RestoreStages(short Phase);
+  void EnforceStageBudget();
+
+  /*! Unwinds a cancelled run back to \c Run(), see \c RequestCancel(). */
+  struct TCancelled {};
+  void CheckCancelled();
+
+  QTime                 FRunTimer;
+  short                 FProcessorMode;
+  QList<ptFilterBase*>  FStripQueue;
+  bool                  FFloatPipe;
+  bool                  FProxyRun;
+  bool                  FCancellable;
+  bool                  FFullFrameRun;
+  bool                  FCancelRequested;   // set from nested event processing, same thread
+
+  std::unique_ptr<ptImageCache>     FFilterCache;
+  std::unique_ptr<ptStageCache>     FStageCache;
+  bool                              FFilterCacheActive;
+  QByteArray                        FCacheKey;        // identifies the current state of the tab image
+  QHash<const ptImage*, QByteArray> FCheckpointKeys;
+
+  std::unique_ptr<ptImage>          FFusedLut;        // point filters not yet applied to the tab image
+  QHash<QString, double>            FFilterCost;      // measured ms per megapixel, by unique name
+  uint                              FCacheGeneration;
+
+  QRect                             FRoi;             // viewport of the current run
+  QRect                             FRequestedRoi;
+  QSize                             FRoiFrame;        // image size FRequestedRoi refers to
+  QRegion                           FRoiValid;        // area of the tab images that is up to date
+  int                               FRoiHalo;         // halo still needed by the following tabs
+  bool                              FRoiActive;
+  bool                              FRoiPanPending;
+  bool                              FRoiPanRun;       // only fill in the missing parts of the tabs
+  const ptImage                    *FTabInput;
 };
 #endif
@@ -0,0 +1,299 @@
+/*******************************************************************************
+**
+** Photivo
+**
+** Copyright (C) 2026 agent <agent@local>
+**
+** This file is part of Photivo.
+**
+** Photivo is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License version 3
+** as published by the Free Software Foundation.
+**
+** Photivo is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with Photivo.  If not, see <http://www.gnu.org/licenses/>.
+**
+*******************************************************************************/
+
+#include "ptProfiler.h"
+#include "ptImage.h"
+
+#include <QFile>
+#include <QFileInfo>
+#include <QMap>
+#include <QTextStream>
+
+#include <cstdio>
+#include <ctime>
+
+#ifdef _OPENMP
+  #include <omp.h>
+#endif
+
+#ifdef Q_OS_LINUX
+  #include <unistd.h>
+  #include <sys/resource.h>
+#endif
+
+//==============================================================================
+
+ptProfiler* ptProfiler::FInstance = nullptr;
+
+/*! Global variable to the profiler.*/
+ptProfiler* GProfiler;
+
+//==============================================================================
+
+/*! \class GetGlobalProfiler
+  Helper to instantiate and terminate the profiler.
+  */
+class GetGlobalProfiler
+{
+public:
+  GetGlobalProfiler() {
+    ptProfiler::FInstance = new ptProfiler();
+    GProfiler = ptProfiler::FInstance;
+  }
+  ~GetGlobalProfiler() {
+    delete ptProfiler::FInstance;
+    ptProfiler::FInstance = nullptr;
+    GProfiler = nullptr;
+  }
+};
+
+GetGlobalProfiler GlobalProfiler;
+
+//==============================================================================
+
+ptProfiler::ptProfiler():
+  FEnabled(false)
+{}
+
+//==============================================================================
+
+ptProfiler::~ptProfiler() {
+  this->flush();
+}
+
+//==============================================================================
+/*! Enables recording and sets the file written by \c flush(). An empty name disables it. */
+void ptProfiler::setOutputFile(const QString &AFileName) {
+  FOutputFile = AFileName;
+  FEnabled    = !AFileName.isEmpty();
+  this->clear();
+}
+
+//==============================================================================
+
+void ptProfiler::setEnabled(const bool AEnabled) {
+  FEnabled = AEnabled;
+}
+
+//==============================================================================
+
+void ptProfiler::clear() {
+  FEvents.clear();
+  FClock.start();
+}
+
+//==============================================================================
+
+void ptProfiler::record(const TEvent &AEvent) {
+  if (FEnabled) FEvents.append(AEvent);
+}
+
+//==============================================================================
+
+qint64 ptProfiler::elapsedUs() const {
+  return FClock.nsecsElapsed()/1000;
+}
+
+//==============================================================================
+/*! Writes all events recorded so far to the output file. Called after every processor run,
+    so an interrupted batch still leaves a usable file behind. */
+void ptProfiler::flush() const {
+  if (FOutputFile.isEmpty() || FEvents.isEmpty()) return;
+
+  bool hSuccess;
+  if (QFileInfo(FOutputFile).suffix().toLower() == "csv") {
+    hSuccess = this->writeSummary(FOutputFile);
+  } else {
+    hSuccess = this->writeTrace(FOutputFile);
+  }
+
+  if (!hSuccess)
+    printf("Profiler: could not write %s\n", FOutputFile.toLocal8Bit().data());
+}
+
+//==============================================================================
+
+qint64 ptProfiler::cpuTimeUs() {
+  return (qint64)std::clock()*1000000/CLOCKS_PER_SEC;
+}
+
+//==============================================================================
+
+qint64 ptProfiler::residentBytes() {
+#ifdef Q_OS_LINUX
+  long hPages = 0;
+  long hResident = 0;
+  FILE *hFile = fopen("/proc/self/statm", "r");
+  if (!hFile) return 0;
+  if (fscanf(hFile, "%ld %ld", &hPages, &hResident) != 2) hResident = 0;
+  fclose(hFile);
+  return (qint64)hResident*sysconf(_SC_PAGESIZE);
+#else
+  return 0;
+#endif
+}
+
+//==============================================================================
+
+qint64 ptProfiler::peakResidentBytes() {
+#ifdef Q_OS_LINUX
+  struct rusage hUsage;
+  if (getrusage(RUSAGE_SELF, &hUsage) != 0) return 0;
+  return (qint64)hUsage.ru_maxrss*1024;
+#else
+  return 0;
+#endif
+}
+
+//==============================================================================
+
+int ptProfiler::threadCount() {
+#ifdef _OPENMP
+  return omp_get_max_threads();
+#else
+  return 1;
+#endif
+}
+
+//==============================================================================
+// JSON strings in the trace. Names are filter ids and fixed captions, so quoting
+// backslash and quote is enough.
+static QString JsonString(const QString &AString) {
+  QString hResult = AString;
+  hResult.replace("\\", "\\\\");
+  hResult.replace("\"", "\\\"");
+  return "\"" + hResult + "\"";
+}
+
+//==============================================================================
+
+bool ptProfiler::writeTrace(const QString &AFileName) const {
+  QFile hFile(AFileName);
+  if (!hFile.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text)) return false;
+
+  QTextStream hOut(&hFile);
+  hOut << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+  for (int i = 0; i < FEvents.size(); ++i) {
+    const TEvent &hEvent = FEvents.at(i);
+    hOut << "{\"name\":"   << JsonString(hEvent.Name)
+         << ",\"cat\":"    << JsonString(hEvent.Category)
+         << ",\"ph\":\"X\",\"pid\":1,\"tid\":1"
+         << ",\"ts\":"     << hEvent.StartUs
+         << ",\"dur\":"    << hEvent.WallUs
+         << ",\"args\":{\"cpu_us\":" << hEvent.CpuUs
+         << ",\"threads\":"          << hEvent.Threads
+         << ",\"mem_delta_bytes\":"  << hEvent.MemDeltaBytes
+         << ",\"resident_bytes\":"   << hEvent.ResidentBytes
+         << ",\"width\":"            << hEvent.Width
+         << ",\"height\":"           << hEvent.Height
+         << "}}" << (i < FEvents.size()-1 ? ",\n" : "\n");
+  }
+  hOut << "]}\n";
+
+  return hOut.status() == QTextStream::Ok;
+}
+
+//==============================================================================
+/*! One line per step, sorted by category and name. Memory is the largest single change seen,
+    megapixels are summed over all runs so that \c MPixPerSec is the step's throughput. */
+bool ptProfiler::writeSummary(const QString &AFileName) const {
+  struct TSum {
+    int     Calls;
+    qint64  WallUs;
+    qint64  CpuUs;
+    int     Threads;
+    qint64  MaxMemDelta;
+    double  MPix;
+  };
+
+  QMap<QString, TSum> hSums;
+  for (const TEvent &hEvent: FEvents) {
+    TSum &hSum = hSums[hEvent.Category + "," + hEvent.Name];
+    hSum.Calls       += 1;
+    hSum.WallUs      += hEvent.WallUs;
+    hSum.CpuUs       += hEvent.CpuUs;
+    hSum.Threads      = qMax(hSum.Threads, hEvent.Threads);
+    hSum.MaxMemDelta  = qMax(hSum.MaxMemDelta, hEvent.MemDeltaBytes);
+    hSum.MPix        += (double)hEvent.Width*hEvent.Height/1.0e6;
+  }
+
+  QFile hFile(AFileName);
+  if (!hFile.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text)) return false;
+
+  QTextStream hOut(&hFile);
+  hOut << "Category,Name,Calls,WallMs,CpuMs,CpuPerWall,Threads,MaxMemDeltaMB,MPix,MPixPerSec\n";
+  for (auto hIter = hSums.constBegin(); hIter != hSums.constEnd(); ++hIter) {
+    const TSum &hSum = hIter.value();
+    hOut << hIter.key() << ","
+         << hSum.Calls << ","
+         << QString::number(hSum.WallUs/1000.0, 'f', 3) << ","
+         << QString::number(hSum.CpuUs/1000.0, 'f', 3) << ","
+         << QString::number(hSum.WallUs > 0 ? (double)hSum.CpuUs/hSum.WallUs : 0.0, 'f', 2) << ","
+         << hSum.Threads << ","
+         << QString::number(hSum.MaxMemDelta/1048576.0, 'f', 1) << ","
+         << QString::number(hSum.MPix, 'f', 2) << ","
+         << QString::number(hSum.WallUs > 0 ? hSum.MPix*1.0e6/hSum.WallUs : 0.0, 'f', 2) << "\n";
+  }
+
+  return hOut.status() == QTextStream::Ok;
+}
+
+//==============================================================================
+
+ptProfileScope::ptProfileScope(const QString &AName, const char *ACategory, const ptImage *AImage):
+  FActive(GProfiler && GProfiler->isEnabled()),
+  FCategory(ACategory),
+  FImage(AImage),
+  FStartUs(0),
+  FStartCpuUs(0),
+  FStartMem(0),
+  FThreads(0)
+{
+  if (!FActive) return;
+
+  FName       = AName;
+  FThreads    = ptProfiler::threadCount();
+  FStartMem   = ptProfiler::residentBytes();
+  FStartCpuUs = ptProfiler::cpuTimeUs();
+  FStartUs    = GProfiler->elapsedUs();
+}
+
+//==============================================================================
+
+ptProfileScope::~ptProfileScope() {
+  if (!FActive) return;
+
+  ptProfiler::TEvent hEvent;
+  hEvent.WallUs        = GProfiler->elapsedUs() - FStartUs;
+  hEvent.CpuUs         = ptProfiler::cpuTimeUs() - FStartCpuUs;
+  hEvent.ResidentBytes = ptProfiler::residentBytes();
+  hEvent.MemDeltaBytes = hEvent.ResidentBytes - FStartMem;
+  hEvent.Name          = FName;
+  hEvent.Category      = FCategory;
+  hEvent.StartUs       = FStartUs;
+  hEvent.Threads       = FThreads;
+  hEvent.Width         = FImage ? FImage->m_Width  : 0;
+  hEvent.Height        = FImage ? FImage->m_Height : 0;
+  GProfiler->record(hEvent);
+}
+
+//==============================================================================
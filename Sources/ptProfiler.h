@@ -0,0 +1,127 @@
+/*******************************************************************************
+**
+** Photivo
+**
+** Copyright (C) 2026 agent <agent@local>
+**
+** This file is part of Photivo.
+**
+** Photivo is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License version 3
+** as published by the Free Software Foundation.
+**
+** Photivo is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with Photivo.  If not, see <http://www.gnu.org/licenses/>.
+**
+*******************************************************************************/
+
+#ifndef PTPROFILER_H
+#define PTPROFILER_H
+
+#include <QElapsedTimer>
+#include <QList>
+#include <QString>
+
+class GetGlobalProfiler;
+class ptImage;
+
+//==============================================================================
+
+/*! \class ptProfiler
+  Records the cost of the pipe steps: filter runs and the DcRaw phases. For each run it
+  keeps wall time, CPU time of the process, the number of OpenMP threads available, the change
+  of resident memory and the image size.
+  Recording is off until an output file is set, e.g. via the \c --profile command line option,
+  or until it is switched on explicitly like \c ptBench does.
+  \c flush() then writes everything recorded so far, either as Chrome trace-event JSON (load it
+  in chrome://tracing or Perfetto) or, when the file name ends with \c .csv, as a summary with
+  one line per step.
+  The singleton instance is accessible via the global variable \c GProfiler.
+  */
+class ptProfiler {
+  friend class GetGlobalProfiler;
+
+public:
+  /*! One measured step. Times are in microseconds, \c StartUs relative to the first event. */
+  struct TEvent {
+    QString Name;
+    QString Category;
+    qint64  StartUs;
+    qint64  WallUs;
+    qint64  CpuUs;
+    int     Threads;
+    qint64  MemDeltaBytes;
+    qint64  ResidentBytes;   // at the end of the step
+    int     Width;
+    int     Height;
+  };
+
+  bool    isEnabled() const { return FEnabled; }
+  void    setEnabled(const bool AEnabled);
+  void    setOutputFile(const QString &AFileName);
+  void    clear();
+  void    record(const TEvent &AEvent);
+  const QList<TEvent>& events() const { return FEvents; }
+  qint64  elapsedUs() const;
+  void    flush() const;
+
+  /*! Process wide measurements used by \c ptProfileScope. Memory is 0 where unsupported. */
+  static qint64 cpuTimeUs();
+  static qint64 residentBytes();
+  static qint64 peakResidentBytes();
+  static int    threadCount();
+
+private:
+  ptProfiler();
+  ~ptProfiler();
+
+  bool    writeTrace(const QString &AFileName) const;
+  bool    writeSummary(const QString &AFileName) const;
+
+  static ptProfiler* FInstance;
+
+  bool           FEnabled;
+  QString        FOutputFile;
+  QElapsedTimer  FClock;
+  QList<TEvent>  FEvents;
+};
+
+//==============================================================================
+
+/*! \class ptProfileScope
+  Measures the lifetime of the object and records it with \c GProfiler. Costs next to nothing
+  while profiling is disabled. \c AImage, if given, is read at the end of the scope to record
+  the output size.
+  */
+class ptProfileScope {
+public:
+  ptProfileScope(const QString &AName, const char *ACategory, const ptImage *AImage = nullptr);
+  ~ptProfileScope();
+
+private:
+  ptProfileScope(const ptProfileScope&) = delete;
+  ptProfileScope& operator=(const ptProfileScope&) = delete;
+
+  bool            FActive;
+  QString         FName;
+  const char     *FCategory;
+  const ptImage  *FImage;
+  qint64          FStartUs;
+  qint64          FStartCpuUs;
+  qint64          FStartMem;
+  int             FThreads;
+};
+
+//==============================================================================
+
+/*! Global variable to the profiler.*/
+extern ptProfiler* GProfiler;
+
+//==============================================================================
+
+#endif // PTPROFILER_H
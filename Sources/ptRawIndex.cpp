@@ -0,0 +1,228 @@
+/*******************************************************************************
+**
+** Photivo
+**
+** Copyright (C) 2026 agent <agent@local>
+**
+** This file is part of Photivo.
+**
+** Photivo is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License version 3
+** as published by the Free Software Foundation.
+**
+** Photivo is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with Photivo.  If not, see <http://www.gnu.org/licenses/>.
+**
+*******************************************************************************/
+
+#include "ptRawIndex.h"
+
+#include <QDataStream>
+#include <QDateTime>
+#include <QFile>
+#include <QFileInfo>
+#include <QMutexLocker>
+
+#include <algorithm>
+#include <vector>
+
+//==============================================================================
+
+ptRawIndex::ptRawIndex():
+  FUseCounter(0),
+  FUnsaved(0)
+{}
+
+//------------------------------------------------------------------------------
+
+ptRawIndex::~ptRawIndex() {
+  save();
+}
+
+//------------------------------------------------------------------------------
+
+ptRawIndex *ptRawIndex::instance() {
+  static ptRawIndex hInstance;
+  return &hInstance;
+}
+
+//------------------------------------------------------------------------------
+
+void ptRawIndex::setFileName(const QString &AFileName) {
+  QMutexLocker hLock(&FMutex);
+  FFileName = AFileName;
+  load();
+}
+
+//------------------------------------------------------------------------------
+
+QByteArray ptRawIndex::find(const QString &AFilePath) {
+  QString hKey;
+  qint64  hSize, hModTime;
+  if (!stat(AFilePath, hKey, hSize, hModTime))
+    return QByteArray();
+
+  QMutexLocker hLock(&FMutex);
+  auto hIter = FEntries.find(hKey);
+  if (hIter == FEntries.end())
+    return QByteArray();
+
+  if (hIter->Size != hSize || hIter->ModTime != hModTime) {
+    FEntries.erase(hIter);
+    ++FUnsaved;
+    return QByteArray();
+  }
+
+  hIter->Used = ++FUseCounter;
+  return hIter->Record;
+}
+
+//------------------------------------------------------------------------------
+
+void ptRawIndex::insert(const QString &AFilePath, const QByteArray &ARecord) {
+  TEntry  hEntry;
+  QString hKey;
+  if (!stat(AFilePath, hKey, hEntry.Size, hEntry.ModTime))
+    return;
+  hEntry.Record = ARecord;
+
+  QMutexLocker hLock(&FMutex);
+  hEntry.Used   = ++FUseCounter;
+
+  // A full identify of an indexed file gives the same record again, that is no change.
+  auto hIter = FEntries.find(hKey);
+  if (hIter != FEntries.end() && hIter->Size == hEntry.Size &&
+      hIter->ModTime == hEntry.ModTime && hIter->Record == hEntry.Record)
+  {
+    hIter->Used = hEntry.Used;
+    return;
+  }
+
+  FEntries.insert(hKey, hEntry);
+  evict();
+
+  if (++FUnsaved < CSaveEvery)
+    return;
+  hLock.unlock();
+  save();
+}
+
+//------------------------------------------------------------------------------
+// The file is written from a snapshot, so other threads can use the index meanwhile.
+// FSaveMutex keeps two saves from writing the temporary file at the same time.
+void ptRawIndex::save() {
+  QMutexLocker hSaveLock(&FSaveMutex);
+
+  QString                hFileName;
+  QHash<QString, TEntry> hEntries;
+  int                    hUnsaved;
+  {
+    QMutexLocker hLock(&FMutex);
+    if (FFileName.isEmpty() || FUnsaved == 0)
+      return;
+    hFileName = FFileName;
+    hEntries  = FEntries;    // implicitly shared, copied only when the index changes
+    hUnsaved  = FUnsaved;
+    FUnsaved  = 0;
+  }
+
+  if (!writeFile(hFileName, hEntries)) {
+    QMutexLocker hLock(&FMutex);
+    FUnsaved += hUnsaved;
+  }
+}
+
+//------------------------------------------------------------------------------
+
+bool ptRawIndex::stat(const QString &AFilePath, QString &AKey, qint64 &ASize, qint64 &AModTime) const {
+  QFileInfo hInfo(AFilePath);
+  if (!hInfo.isFile())
+    return false;
+
+  AKey     = hInfo.absoluteFilePath();
+  ASize    = hInfo.size();
+  AModTime = hInfo.lastModified().toMSecsSinceEpoch();
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Expects FMutex to be locked.
+void ptRawIndex::load() {
+  FEntries.clear();
+  FUseCounter = 0;
+  FUnsaved    = 0;
+
+  QFile hFile(FFileName);
+  if (FFileName.isEmpty() || !hFile.open(QIODevice::ReadOnly))
+    return;
+
+  QDataStream hStream(&hFile);
+  quint32 hMagic   = 0;
+  qint32  hVersion = 0;
+  qint32  hCount   = 0;
+  hStream >> hMagic >> hVersion >> hCount;
+  if (hMagic != CMagic || hVersion != CVersion)
+    return;
+
+  for (qint32 i = 0; i < hCount && hStream.status() == QDataStream::Ok; ++i) {
+    QString hKey;
+    TEntry  hEntry;
+    hStream >> hKey >> hEntry.Size >> hEntry.ModTime >> hEntry.Record;
+    hEntry.Used = ++FUseCounter;
+    if (hStream.status() == QDataStream::Ok)
+      FEntries.insert(hKey, hEntry);
+  }
+}
+
+//------------------------------------------------------------------------------
+// Writes a temporary file first so that an interrupted save never leaves a truncated
+// index behind.
+bool ptRawIndex::writeFile(const QString &AFileName, const QHash<QString, TEntry> &AEntries) {
+  const QString hTempName = AFileName + ".tmp";
+  QFile hFile(hTempName);
+  if (!hFile.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    return false;
+
+  QDataStream hStream(&hFile);
+  hStream << CMagic << CVersion << (qint32)AEntries.size();
+  for (auto hIter = AEntries.constBegin(); hIter != AEntries.constEnd(); ++hIter)
+    hStream << hIter.key() << hIter->Size << hIter->ModTime << hIter->Record;
+  hFile.close();
+
+  if (hStream.status() != QDataStream::Ok) {
+    QFile::remove(hTempName);
+    return false;
+  }
+
+  QFile::remove(AFileName);
+  return QFile::rename(hTempName, AFileName);
+}
+
+//------------------------------------------------------------------------------
+// Expects FMutex to be locked. Drops the least recently used quarter of the index
+// once it is full.
+void ptRawIndex::evict() {
+  if (FEntries.size() <= CMaxEntries)
+    return;
+
+  std::vector<quint32> hUsed;
+  hUsed.reserve(FEntries.size());
+  for (auto hIter = FEntries.constBegin(); hIter != FEntries.constEnd(); ++hIter)
+    hUsed.push_back(hIter->Used);
+
+  auto hNth = hUsed.begin() + hUsed.size()/4;
+  std::nth_element(hUsed.begin(), hNth, hUsed.end());
+  const quint32 hThreshold = *hNth;
+
+  for (auto hIter = FEntries.begin(); hIter != FEntries.end(); ) {
+    if (hIter->Used < hThreshold)
+      hIter = FEntries.erase(hIter);
+    else
+      ++hIter;
+  }
+}
@@ -0,0 +1,92 @@
+/*******************************************************************************
+**
+** Photivo
+**
+** Copyright (C) 2026 agent <agent@local>
+**
+** This file is part of Photivo.
+**
+** Photivo is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License version 3
+** as published by the Free Software Foundation.
+**
+** Photivo is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with Photivo.  If not, see <http://www.gnu.org/licenses/>.
+**
+*******************************************************************************/
+
+#ifndef PTRAWINDEX_H
+#define PTRAWINDEX_H
+
+#include <QByteArray>
+#include <QHash>
+#include <QMutex>
+#include <QString>
+
+//==============================================================================
+
+/*! ptRawIndex is the persistent index of \c ptDcRaw::Identify() results. Parsing the headers
+    of a raw file means reading makernotes and IFDs scattered over the file, and it happens
+    for the type check when a file is opened or a batch job is started and for every
+    thumbnail of the file manager. The index maps a file, identified by its absolute path,
+    size and modification time, to the record \c ptDcRaw made of the parse, so that these
+    repeat passes need not touch the file headers at all.
+    The records are opaque to the index, see \c ptDcRaw::IndexRecord().
+    All functions are thread-safe.
+ */
+class ptRawIndex {
+public:
+  static ptRawIndex *instance();
+
+  /*! Sets the file the index is kept in and loads it. Without a file the index only lives
+      for the session. */
+  void setFileName(const QString &AFileName);
+
+  /*! Returns the record for \c AFilePath, or an empty array when the file is not indexed or
+      has changed since. */
+  QByteArray find(const QString &AFilePath);
+
+  /*! Stores the record for the current state of \c AFilePath. Every \c CSaveEvery new or
+      changed records the index is written to disk; storing an unchanged record again only
+      marks it as used. */
+  void insert(const QString &AFilePath, const QByteArray &ARecord);
+
+  /*! Writes the index to its file if it changed. The index is not locked while the file
+      is written. */
+  void save();
+
+private:
+  ptRawIndex();
+  ~ptRawIndex();
+
+  struct TEntry {
+    qint64      Size;
+    qint64      ModTime;     // ms since the epoch
+    quint32     Used;        // value of FUseCounter at the last access
+    QByteArray  Record;
+  };
+
+  static const int     CMaxEntries = 20000;
+  static const int     CSaveEvery  = 32;
+  static const quint32 CMagic      = 0x50545249;   // "PTRI"
+  static const qint32  CVersion    = 1;
+
+  bool  stat(const QString &AFilePath, QString &AKey, qint64 &ASize, qint64 &AModTime) const;
+  void  load();
+  void  evict();
+  static bool writeFile(const QString &AFileName, const QHash<QString, TEntry> &AEntries);
+
+  QMutex                  FMutex;
+  QMutex                  FSaveMutex;
+  QString                 FFileName;
+  QHash<QString, TEntry>  FEntries;
+  quint32                 FUseCounter;
+  int                     FUnsaved;
+};
+
+#endif // PTRAWINDEX_H
@@ -369,7 +369,15 @@ ptSettings::ptSettings(const short InitLevel, const QString Path) {
     {"FileMgrShowRAWs"                      ,1    ,1                                     ,0},
     {"FileMgrShowBitmaps"                   ,1    ,1                                     ,0},
     {"BatchIsOpen"                          ,9    ,0                                     ,0},
-    {"BatchLogIsVisible"                    ,1    ,0                                     ,0}
+    {"BatchLogIsVisible"                    ,1    ,0                                     ,0},
+    // stuff for the processor
+    {"FullPipeStripHeight"                  ,1    ,512                                   ,0},  // rows per strip in full size runs, 0 disables strips
+    {"FilterCacheSize"                      ,1    ,256                                   ,0},  // MB for remembered filter results in the interactive pipe, 0 disables
+    {"FloatPipe"                            ,1    ,0                                     ,1},  // 1 keeps float capable filter chains in float32 between filters
+    {"ViewportProcessing"                   ,1    ,1                                     ,0},  // 1 processes only the visible part of the image in interactive runs
+    {"ProgressivePreview"                   ,1    ,2                                     ,0},  // >0 shows a 1/2^n scale proxy before the pipe size run, 0 off
+    {"StageCacheBudget"                     ,1    ,4096                                  ,0},  // MB for the pipe checkpoints before cold ones are spilled to disk, 0 no limit
+    {"CheckpointMinCost"                    ,1    ,40                                    ,0}   // ms a filter must take before its result is kept in the filter cache, 0 keeps all
   };
 
    // Gui Numerical inputs. Copy them from the const array in ptSettingItem.
@@ -0,0 +1,220 @@
+/*******************************************************************************
+**
+** Photivo
+**
+** Copyright (C) 2026 agent <agent@local>
+**
+** This file is part of Photivo.
+**
+** Photivo is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License version 3
+** as published by the Free Software Foundation.
+**
+** Photivo is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with Photivo.  If not, see <http://www.gnu.org/licenses/>.
+**
+*******************************************************************************/
+
+#include "ptStageCache.h"
+#include "ptImage.h"
+
+#include <QDir>
+#include <QSet>
+#include <QTemporaryFile>
+
+#include <cstdio>
+#include <cstring>
+
+//------------------------------------------------------------------------------
+// One scratch file, shared by all checkpoints that had the same buffer.
+struct ptStageCache::TSpill {
+  QTemporaryFile               File;
+  size_t                       Bytes;
+  std::weak_ptr<TImage16Data>  Loaded;   // buffer once read back, for the other checkpoints
+};
+
+//------------------------------------------------------------------------------
+
+ptStageCache::ptStageCache(size_t ABudgetBytes):
+  FBudget(ABudgetBytes),
+  FHits(0),
+  FMisses(0),
+  FSpills(0)
+{}
+
+//------------------------------------------------------------------------------
+
+ptStageCache::~ptStageCache() {}
+
+//------------------------------------------------------------------------------
+
+void ptStageCache::setBudget(size_t ABudgetBytes) {
+  FBudget = ABudgetBytes;
+}
+
+//------------------------------------------------------------------------------
+
+void ptStageCache::track(ptImage *AStage, const bool APinned) {
+  if (!AStage) return;
+
+  TStage hStage = {AStage, APinned, nullptr};
+  const int hIdx = indexOf(AStage);
+  if (hIdx >= 0) {
+    hStage = FStages.takeAt(hIdx);
+    hStage.Pinned = APinned;
+    // Written since it was spilled, the scratch file is stale.
+    if (hStage.Spill && !isSpilled(hStage)) hStage.Spill.reset();
+  }
+  FStages.append(hStage);
+}
+
+//------------------------------------------------------------------------------
+/*! Counts a hit when \c AStage is in memory and a miss when it has to be read back. */
+ptImage* ptStageCache::restore(ptImage *AStage) {
+  const int hIdx = indexOf(AStage);
+  if (hIdx < 0) return AStage;
+
+  TStage hStage = FStages.takeAt(hIdx);
+  FStages.append(hStage);
+  TStage &hEntry = FStages.last();
+
+  if (!hEntry.Spill) {
+    FHits++;
+    return AStage;
+  }
+
+  std::shared_ptr<TSpill> hSpill = hEntry.Spill;
+  hEntry.Spill.reset();
+  if (!isSpilled(hEntry)) return AStage;
+
+  auto hData = hSpill->Loaded.lock();
+  if (!hData) {
+    uchar *hMap = hSpill->File.map(0, hSpill->Bytes);
+    if (!hMap) {
+      printf("(%s,%d) Could not map %s, checkpoint lost\n",
+             __FILE__, __LINE__, hSpill->File.fileName().toLocal8Bit().data());
+      // Leave a null image behind and forget it, the pipe has to compute it again.
+      AStage->m_Width  = 0;
+      AStage->m_Height = 0;
+      FStages.removeLast();
+      return nullptr;
+    }
+    hData = std::make_shared<TImage16Data>(hSpill->Bytes/sizeof(TPixel16));
+    memcpy(hData->data(), hMap, hSpill->Bytes);
+    hSpill->File.unmap(hMap);
+    hSpill->Loaded = hData;
+  }
+
+  AStage->m_Data  = hData;
+  AStage->m_Image = (uint16_t (*)[3]) hData->data();
+  FMisses++;
+  return AStage;
+}
+
+//------------------------------------------------------------------------------
+
+void ptStageCache::enforce(const size_t AExternalBytes) {
+  if (FBudget == 0) return;
+
+  while (residentBytes() + AExternalBytes > FBudget) {
+    // Buffers that a pinned checkpoint holds stay in memory anyway.
+    QSet<const void*> hPinned;
+    for (const TStage &hStage: FStages) {
+      if (hStage.Pinned) hPinned.insert(hStage.Image->m_Data.get());
+    }
+
+    // Spilling a buffer that is also held elsewhere (the filter cache) frees nothing.
+    int hCandidate = -1;
+    for (int i = 0; i < FStages.size(); i++) {
+      const ptImage *hImage = FStages.at(i).Image;
+      if (FStages.at(i).Pinned || FStages.at(i).Spill || hImage->isFloat() ||
+          hImage->isPlanar() || hImage->isNull() || hPinned.contains(hImage->m_Data.get()) ||
+          isHeldElsewhere(hImage))
+        continue;
+      hCandidate = i;
+      break;
+    }
+
+    if (hCandidate < 0 || !spill(hCandidate)) return;
+  }
+}
+
+//------------------------------------------------------------------------------
+
+void ptStageCache::clear() {
+  FStages.clear();
+}
+
+//------------------------------------------------------------------------------
+// Each buffer counts once, however many checkpoints share it. Buffers also held outside
+// the checkpoints are not counted, their owner accounts for them.
+size_t ptStageCache::residentBytes() const {
+  QSet<const void*> hSeen;
+  size_t            hBytes = 0;
+  for (const TStage &hStage: FStages) {
+    const ptImage *hImage = hStage.Image;
+    if (hStage.Spill || hImage->isFloat() || hImage->isPlanar() || isHeldElsewhere(hImage)) continue;
+    if (hSeen.contains(hImage->m_Data.get())) continue;
+    hSeen.insert(hImage->m_Data.get());
+    hBytes += hImage->m_Data->size()*sizeof(TPixel16);
+  }
+  return hBytes;
+}
+
+//------------------------------------------------------------------------------
+
+int ptStageCache::indexOf(const ptImage *AStage) const {
+  for (int i = 0; i < FStages.size(); i++) {
+    if (FStages.at(i).Image == AStage) return i;
+  }
+  return -1;
+}
+
+//------------------------------------------------------------------------------
+// True when more references to the buffer of AImage exist than checkpoints sharing it.
+bool ptStageCache::isHeldElsewhere(const ptImage *AImage) const {
+  long hStages = 0;
+  for (const TStage &hStage: FStages) {
+    if (hStage.Image->m_Data == AImage->m_Data) hStages++;
+  }
+  return AImage->m_Data.use_count() > hStages;
+}
+
+//------------------------------------------------------------------------------
+// A spilled checkpoint holds no pixels. Anything else means it was written meanwhile.
+bool ptStageCache::isSpilled(const TStage &AStage) const {
+  return AStage.Image->m_Image == nullptr && AStage.Image->m_Data->empty() &&
+         !AStage.Image->isFloat() && !AStage.Image->isPlanar();
+}
+
+//------------------------------------------------------------------------------
+// Writes the buffer of checkpoint AIdx to a scratch file and releases it in every
+// checkpoint that shares it.
+bool ptStageCache::spill(const int AIdx) {
+  const std::shared_ptr<TImage16Data> hData = FStages.at(AIdx).Image->m_Data;
+  const size_t hBytes = hData->size()*sizeof(TPixel16);
+
+  auto hSpill = std::make_shared<TSpill>();
+  hSpill->File.setFileTemplate(QDir::tempPath() + "/photivo-stage-XXXXXX");
+  hSpill->Bytes = hBytes;
+  if (!hSpill->File.open() || !hSpill->File.resize(hBytes)) return false;
+
+  uchar *hMap = hSpill->File.map(0, hBytes);
+  if (!hMap) return false;
+  memcpy(hMap, hData->data(), hBytes);
+  hSpill->File.unmap(hMap);
+
+  for (TStage &hStage: FStages) {
+    if (hStage.Image->m_Data != hData) continue;
+    hStage.Spill          = hSpill;
+    hStage.Image->m_Data  = std::make_shared<TImage16Data>();
+    hStage.Image->m_Image = nullptr;
+  }
+  FSpills++;
+  return true;
+}
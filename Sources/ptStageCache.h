@@ -0,0 +1,93 @@
+/*******************************************************************************
+**
+** Photivo
+**
+** Copyright (C) 2026 agent <agent@local>
+**
+** This file is part of Photivo.
+**
+** Photivo is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License version 3
+** as published by the Free Software Foundation.
+**
+** Photivo is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with Photivo.  If not, see <http://www.gnu.org/licenses/>.
+**
+*******************************************************************************/
+
+#ifndef PTSTAGECACHE_H
+#define PTSTAGECACHE_H
+
+#include <QList>
+
+#include <memory>
+
+class ptImage;
+
+//==============================================================================
+
+/*! ptStageCache keeps the pipe checkpoints (\c ptProcessor::m_Image_After*) within a memory
+    budget. When the checkpoints use more than the budget, the least recently used ones are
+    written to memory-mapped scratch files and their pixel buffer is released. \c restore()
+    reads a spilled checkpoint back in. A spilled image keeps its size and colour space but
+    holds no pixels, so it must be restored before anyone reads it.
+    Checkpoints sharing one buffer (see \c ptImage::Share()) are spilled and restored together.
+    A buffer that is also referenced outside the checkpoints, e.g. by the filter cache, is
+    neither spilled nor counted, as spilling it would not free any memory.
+ */
+class ptStageCache {
+public:
+  explicit ptStageCache(size_t ABudgetBytes);
+  ~ptStageCache();
+
+  /*! Budget in bytes, 0 means no limit. Takes effect with the next \c enforce(). */
+  void      setBudget(size_t ABudgetBytes);
+
+  /*! Registers \c AStage as a checkpoint, or marks it as used when it already is one.
+      Pinned checkpoints are never spilled. */
+  void      track(ptImage *AStage, const bool APinned = false);
+
+  /*! Reads a spilled \c AStage back in and marks it as used. Returns \c AStage, or
+      \c nullptr when the scratch file cannot be read. \c AStage is then a null image
+      that is no longer tracked. */
+  ptImage*  restore(ptImage *AStage);
+
+  /*! Spills least recently used checkpoints until they fit into the budget together with
+      \c AExternalBytes of other cached data. */
+  void      enforce(const size_t AExternalBytes = 0);
+
+  /*! Forgets all checkpoints. Spilled ones are not restored. */
+  void      clear();
+
+  size_t    residentBytes() const;
+  int       hits()   const { return FHits; }
+  int       misses() const { return FMisses; }
+  int       spills() const { return FSpills; }
+
+private:
+  struct TSpill;
+
+  struct TStage {
+    ptImage                 *Image;
+    bool                     Pinned;
+    std::shared_ptr<TSpill>  Spill;
+  };
+
+  int  indexOf(const ptImage *AStage) const;
+  bool isSpilled(const TStage &AStage) const;
+  bool isHeldElsewhere(const ptImage *AImage) const;
+  bool spill(const int AIdx);
+
+  QList<TStage>   FStages;    // least recently used first
+  size_t          FBudget;    // in bytes
+  int             FHits;
+  int             FMisses;
+  int             FSpills;
+};
+
+#endif // PTSTAGECACHE_H
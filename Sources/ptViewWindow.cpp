@@ -72,6 +72,13 @@ ptViewWindow::ptViewWindow(QWidget* Parent, ptMainWindow* mainWin)
   FZoomSizeOverlay = new ptReportOverlay(this, "", QColor(75,150,255), QColor(190,220,255),
                                          1000, Qt::AlignRight, 20);
 
+  // Created early because scrolling and resizing already happen during setup.
+  FViewportHandler = NULL;
+  FViewportTimer = new QTimer();
+  FViewportTimer->setSingleShot(true);
+  FViewportTimer->setInterval(250);
+  connect(FViewportTimer, SIGNAL(timeout()), this, SLOT(viewportSettled()));
+
   setHorizontalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
   setVerticalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
   setMouseTracking(true);   // Move events without pressed button. Needed for crop cursor change.
@@ -113,13 +120,14 @@ ptViewWindow::~ptViewWindow() {
   DelAndNull(ac_PReadGroup);
 
   DelAndNull(FPReadTimer);
+  DelAndNull(FViewportTimer);
 }
 
 //==============================================================================
 
 // Convert a 16bit ptImage to an 8bit QPixmap. Mind R<->B. Also update the
 // graphics scene and the viewport.
-void ptViewWindow::UpdateImage(const ptImage* relatedImage) {
+void ptViewWindow::UpdateImage(const ptImage* relatedImage, const QSize& displaySize /*= QSize()*/) {
   if (relatedImage) {
     this->blockSignals(1);
     QImage* Img8bit = new QImage(relatedImage->m_Width, relatedImage->m_Height, QImage::Format_RGB32);
@@ -136,7 +144,12 @@ void ptViewWindow::UpdateImage(const ptImage* relatedImage) {
       Pixel[3] = 0xff;
     }
 
-    F8bitImageItem->setPixmap(QPixmap::fromImage(*Img8bit, Qt::ColorOnly));
+    if (displaySize.isValid() && displaySize != Img8bit->size()) {
+      F8bitImageItem->setPixmap(QPixmap::fromImage(*Img8bit, Qt::ColorOnly)
+                                .scaled(displaySize, Qt::IgnoreAspectRatio, Qt::FastTransformation));
+    } else {
+      F8bitImageItem->setPixmap(QPixmap::fromImage(*Img8bit, Qt::ColorOnly));
+    }
     DelAndNull(Img8bit);
     FImageScene->setSceneRect(0, 0,
                               F8bitImageItem->pixmap().width(),
@@ -170,6 +183,7 @@ void ptViewWindow::ZoomTo(float factor) {
   int z = qRound(FZoomFactor * 100);
   Settings->SetValue("Zoom", z);
   FZoomSizeOverlay->exec(QString::number(z) + "%");
+  FViewportTimer->start();
 }
 
 //==============================================================================
@@ -189,6 +203,7 @@ int ptViewWindow::ZoomToFit(const short withMsg /*= 1*/) {
   }
 
   Settings->SetValue("Zoom",qRound(FZoomFactor * 100));
+  FViewportTimer->start();
   return FZoomFactor;
 }
 
@@ -458,6 +473,28 @@ void ptViewWindow::resizeEvent(QResizeEvent* event) {
     // takes care of positioning the scene inside the viewport on non-fit zooms
     QGraphicsView::resizeEvent(event);
   }
+  FViewportTimer->start();
+}
+
+//==============================================================================
+
+void ptViewWindow::scrollContentsBy(int dx, int dy) {
+  QGraphicsView::scrollContentsBy(dx, dy);
+  // Restarting the timer on every step reports a pan only once it has ended.
+  FViewportTimer->start();
+}
+
+//==============================================================================
+
+QRect ptViewWindow::visibleImageRect() const {
+  const QRect hVisible = mapToScene(viewport()->rect()).boundingRect().toAlignedRect();
+  return hVisible & FImageScene->sceneRect().toAlignedRect();
+}
+
+//==============================================================================
+
+void ptViewWindow::viewportSettled() {
+  if (FViewportHandler) FViewportHandler(visibleImageRect());
 }
 
 //==============================================================================
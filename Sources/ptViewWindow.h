@@ -95,6 +95,9 @@ public:
   inline int zoomPercent() { return qRound(FZoomFactor * 100); }
   inline float zoomFactor() const { return FZoomFactor; }
 
+  // Part of the displayed image that is currently visible, in image pixels.
+  QRect visibleImageRect() const;
+
   // Save (and later restore) current zoom settings. Takes care of
   // everything incl. ptSettings. RestoreZoom() also updates the
   // viewport accordingly.
@@ -119,7 +122,9 @@ public:
   ptRepairInteraction   *spotRepair() const { return FSpotRepair; }
 
   void setGrid(const short enabled, const uint linesX, const uint linesY);
-  void UpdateImage(const ptImage* relatedImage);
+  // A valid displaySize stretches the image to that size, e.g. to show a proxy in place
+  // of the pipe size image without disturbing zoom and scroll position.
+  void UpdateImage(const ptImage* relatedImage, const QSize& displaySize = QSize());
   void ZoomTo(float factor);  // 1.0 means 100%
   int  ZoomToFit(const short withMsg = 1);  // fit complete image into viewport
   void ZoomStep(int direction);
@@ -128,6 +133,10 @@ public:
   void SetPixelReader(void (*PixelReader)(const QPointF Point, const ptPixelReading PixelReading))
     { FPixelReader = PixelReader; }
 
+  // Called with visibleImageRect() once panning or zooming has come to rest.
+  void SetViewportHandler(void (*ViewportHandler)(const QRect Visible))
+    { FViewportHandler = ViewportHandler; }
+
 //------------------------------------------------------------------------------
 
 protected:
@@ -138,6 +147,7 @@ protected:
   void keyReleaseEvent(QKeyEvent* event);
   void paintEvent(QPaintEvent* event);
   void resizeEvent(QResizeEvent* event);
+  void scrollContentsBy(int dx, int dy);
   void mouseDoubleClickEvent(QMouseEvent* event);
   void mousePressEvent(QMouseEvent* event);
   void mouseReleaseEvent(QMouseEvent* event);
@@ -175,6 +185,7 @@ private:
   short                     FZoomModeSav;
   ptPixelReading            FPixelReading;
   QTimer                    *FPReadTimer;
+  QTimer                    *FViewportTimer;
 
   QGraphicsPixmapItem       *F8bitImageItem;
   QLine                     *FDragDelta;
@@ -220,11 +231,13 @@ private:
   ptMainWindow  *FMainWindow;
 
   void (*FPixelReader)(const QPointF Point, const ptPixelReading PixelReading);
+  void (*FViewportHandler)(const QRect Visible);
 
 //------------------------------------------------------------------------------
 
 private slots:
   void finishInteraction(ptStatus ExitStatus);
+  void viewportSettled();
 
   // context menu stuff
   void Menu_Clip_Indicate();
@@ -26,7 +26,7 @@
 // adaptions for Photivo
 // width -> m_Width
 // height -> m_Height
-// image -> m_Image
+// image -> CFA_BAYER/CFA_CHANNEL (m_CfaImage or m_Image)
 
 //%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
 int LinEqSolve(int nDim, float* pfMatr, float* pfVect, float* pfSolution)
@@ -267,7 +267,7 @@ void CLASS CA_correct(double cared, double cablue) {
           indx=row*width+col;
           indx1=rr*TS+cc;
           //rgb[indx1][c] = (rawData[row][col])/65535.0f;
-          rgb[indx1][c] = m_Image[indx][FC(rr,cc)]/65535.0f;//for dcraw implementation
+          rgb[indx1][c] = CFA_CHANNEL(row,col,FC(rr,cc))/65535.0f;//for dcraw implementation
         }
 
       // %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
@@ -284,7 +284,7 @@ void CLASS CA_correct(double cared, double cablue) {
           for (cc=ccmin; cc<ccmax; cc++) {
             c=FCnew(rr,cc);
             //rgb[(rrmax+rr)*TS+cc][c] = (rawData[(height-rr-2)][left+cc])/65535.0f;
-            rgb[(rrmax+rr)*TS+cc][c] = (m_Image[(height-rr-2)*width+left+cc][FC(rr,cc)])/65535.0f;//for dcraw implementation
+            rgb[(rrmax+rr)*TS+cc][c] = CFA_CHANNEL(height-rr-2,left+cc,FC(rr,cc))/65535.0f;//for dcraw implementation
           }
       }
       if (ccmin>0) {
@@ -299,7 +299,7 @@ void CLASS CA_correct(double cared, double cablue) {
           for (cc=0; cc<border; cc++) {
             c=FCnew(rr,cc);
             //rgb[rr*TS+ccmax+cc][c] = (rawData[(top+rr)][(width-cc-2)])/65535.0f;
-            rgb[rr*TS+ccmax+cc][c] = (m_Image[(top+rr)*width+(width-cc-2)][FC(rr,cc)])/65535.0f;//for dcraw implementation
+            rgb[rr*TS+ccmax+cc][c] = CFA_CHANNEL(top+rr,width-cc-2,FC(rr,cc))/65535.0f;//for dcraw implementation
           }
       }
 
@@ -317,7 +317,7 @@ void CLASS CA_correct(double cared, double cablue) {
           for (cc=0; cc<border; cc++) {
             c=FCnew(rr,cc);
             //rgb[(rrmax+rr)*TS+ccmax+cc][c] = (rawData[(height-rr-2)][(width-cc-2)])/65535.0f;
-            rgb[(rrmax+rr)*TS+ccmax+cc][c] = (m_Image[(height-rr-2)*width+(width-cc-2)][FC(rr,cc)])/65535.0f;//for dcraw implementation
+            rgb[(rrmax+rr)*TS+ccmax+cc][c] = CFA_CHANNEL(height-rr-2,width-cc-2,FC(rr,cc))/65535.0f;//for dcraw implementation
           }
       }
       if (rrmin>0 && ccmax<cc1) {
@@ -325,7 +325,7 @@ void CLASS CA_correct(double cared, double cablue) {
           for (cc=0; cc<border; cc++) {
             c=FCnew(rr,cc);
             //rgb[(rr)*TS+ccmax+cc][c] = (rawData[(border2-rr)][(width-cc-2)])/65535.0f;
-            rgb[(rr)*TS+ccmax+cc][c] = (m_Image[(border2-rr)*width+(width-cc-2)][FC(rr,cc)])/65535.0f;//for dcraw implementation
+            rgb[(rr)*TS+ccmax+cc][c] = CFA_CHANNEL(border2-rr,width-cc-2,FC(rr,cc))/65535.0f;//for dcraw implementation
           }
       }
       if (rrmax<rr1 && ccmin>0) {
@@ -333,7 +333,7 @@ void CLASS CA_correct(double cared, double cablue) {
           for (cc=0; cc<border; cc++) {
             c=FCnew(rr,cc);
             //rgb[(rrmax+rr)*TS+cc][c] = (rawData[(height-rr-2)][(border2-cc)])/65535.0f;
-            rgb[(rrmax+rr)*TS+cc][c] = (m_Image[(height-rr-2)*width+(border2-cc)][FC(rr,cc)])/65535.0f;//for dcraw implementation
+            rgb[(rrmax+rr)*TS+cc][c] = CFA_CHANNEL(height-rr-2,border2-cc,FC(rr,cc))/65535.0f;//for dcraw implementation
           }
       }
 
@@ -617,7 +617,7 @@ void CLASS CA_correct(double cared, double cablue) {
           indx1=rr*TS+cc;
           //rgb[indx1][c] = image[indx][c]/65535.0f;
           //rgb[indx1][c] = (rawData[row][col])/65535.0f;
-          rgb[indx1][c] = m_Image[indx][FC(rr,cc)]/65535.0f;//for dcraw implementation
+          rgb[indx1][c] = CFA_CHANNEL(row,col,FC(rr,cc))/65535.0f;//for dcraw implementation
 
           if ((c&1)==0) rgb[indx1][1] = Gtmp[indx];
         }
@@ -636,7 +636,7 @@ void CLASS CA_correct(double cared, double cablue) {
           for (cc=ccmin; cc<ccmax; cc++) {
             c=FCnew(rr,cc);
             //rgb[(rrmax+rr)*TS+cc][c] = (rawData[(height-rr-2)][left+cc])/65535.0f;
-            rgb[(rrmax+rr)*TS+cc][c] = (m_Image[(height-rr-2)*width+left+cc][FC(rr,cc)])/65535.0f;//for dcraw implementation
+            rgb[(rrmax+rr)*TS+cc][c] = CFA_CHANNEL(height-rr-2,left+cc,FC(rr,cc))/65535.0f;//for dcraw implementation
 
             rgb[(rrmax+rr)*TS+cc][1] = Gtmp[(height-rr-2)*width+left+cc];
           }
@@ -654,7 +654,7 @@ void CLASS CA_correct(double cared, double cablue) {
           for (cc=0; cc<border; cc++) {
             c=FCnew(rr,cc);
             //rgb[rr*TS+ccmax+cc][c] = (rawData[(top+rr)][(width-cc-2)])/65535.0f;
-            rgb[rr*TS+ccmax+cc][c] = (m_Image[(top+rr)*width+(width-cc-2)][FC(rr,cc)])/65535.0f;//for dcraw implementation
+            rgb[rr*TS+ccmax+cc][c] = CFA_CHANNEL(top+rr,width-cc-2,FC(rr,cc))/65535.0f;//for dcraw implementation
 
             rgb[rr*TS+ccmax+cc][1] = Gtmp[(top+rr)*width+(width-cc-2)];
           }
@@ -676,7 +676,7 @@ void CLASS CA_correct(double cared, double cablue) {
           for (cc=0; cc<border; cc++) {
             c=FCnew(rr,cc);
             //rgb[(rrmax+rr)*TS+ccmax+cc][c] = (rawData[(height-rr-2)][(width-cc-2)])/65535.0f;
-            rgb[(rrmax+rr)*TS+ccmax+cc][c] = (m_Image[(height-rr-2)*width+(width-cc-2)][FC(rr,cc)])/65535.0f;//for dcraw implementation
+            rgb[(rrmax+rr)*TS+ccmax+cc][c] = CFA_CHANNEL(height-rr-2,width-cc-2,FC(rr,cc))/65535.0f;//for dcraw implementation
 
             rgb[(rrmax+rr)*TS+ccmax+cc][1] = Gtmp[(height-rr-2)*width+(width-cc-2)];
           }
@@ -686,7 +686,7 @@ void CLASS CA_correct(double cared, double cablue) {
           for (cc=0; cc<border; cc++) {
             c=FCnew(rr,cc);
             //rgb[(rr)*TS+ccmax+cc][c] = (rawData[(border2-rr)][(width-cc-2)])/65535.0f;
-            rgb[(rr)*TS+ccmax+cc][c] = (m_Image[(border2-rr)*width+(width-cc-2)][FC(rr,cc)])/65535.0f;//for dcraw implementation
+            rgb[(rr)*TS+ccmax+cc][c] = CFA_CHANNEL(border2-rr,width-cc-2,FC(rr,cc))/65535.0f;//for dcraw implementation
 
             rgb[(rr)*TS+ccmax+cc][1] = Gtmp[(border2-rr)*width+(width-cc-2)];
           }
@@ -696,7 +696,7 @@ void CLASS CA_correct(double cared, double cablue) {
           for (cc=0; cc<border; cc++) {
             c=FCnew(rr,cc);
             //rgb[(rrmax+rr)*TS+cc][c] = (rawData[(height-rr-2)][(border2-cc)])/65535.0f;
-            rgb[(rrmax+rr)*TS+cc][c] = (m_Image[(height-rr-2)*width+(border2-cc)][FC(rr,cc)])/65535.0f;//for dcraw implementation
+            rgb[(rrmax+rr)*TS+cc][c] = CFA_CHANNEL(height-rr-2,border2-cc,FC(rr,cc))/65535.0f;//for dcraw implementation
 
             rgb[(rrmax+rr)*TS+cc][1] = Gtmp[(height-rr-2)*width+(border2-cc)];
           }
@@ -843,7 +843,7 @@ void CLASS CA_correct(double cared, double cablue) {
           c = FCnew(row,col);
 
           //rawData[row][col] = CLIP((int)(65535.0f*rgb[(rr)*TS+cc][c] + 0.5f));
-          m_Image[indx][FC(row,col)] = CLIP((int32_t)(65535.0*rgb[(rr)*TS+cc][c] + 0.5));//for dcraw implementation
+          CFA_BAYER(row,col) = CLIP((int32_t)(65535.0*rgb[(rr)*TS+cc][c] + 0.5));//for dcraw implementation
 
         }
 
@@ -25,7 +25,7 @@
 // adaptions for photivo
 // width -> m_Width
 // height -> m_Height
-// image -> m_Image
+// image -> CFA_BAYER (m_CfaImage or m_Image)
 
 #include "../ptDefines.h"
 
@@ -120,7 +120,7 @@ void CLASS cfa_linedn(float noise)
       for (int rr=top; rr < top+numrows; rr++)
         for (int cc=left, indx=(rr-top)*TS; cc < left+numcols; cc++, indx++) {
 
-          cfain[indx] = m_Image[rr*width+cc][FC(rr,cc)];
+          cfain[indx] = CFA_BAYER(rr,cc);
         }
       //pad the block to a multiple of 16 on both sides
 
@@ -248,8 +248,8 @@ void CLASS cfa_linedn(float noise)
         int row = rr + top;
         for (int col=16+left, indx=rr*TS+16; indx < rr*TS+numcols-16; indx++, col++) {
 
-          if (m_Image[row*width+col][FC(row,col)]<clip_pt && cfadn[indx]<clip_pt)
-            m_Image[row*width+col][FC(row,col)] = CLIP((int32_t)(cfadn[indx]+ 0.5));
+          if (CFA_BAYER(row,col)<clip_pt && cfadn[indx]<clip_pt)
+            CFA_BAYER(row,col) = CLIP((int32_t)(cfadn[indx]+ 0.5));
         }
       }
     }
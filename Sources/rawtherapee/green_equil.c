@@ -66,7 +66,7 @@ void CLASS green_equilibrate(float thresh)
       int numcols = right - left;
 
       int row, col;
-      int rr, cc, c, indx;
+      int rr, cc, indx;
       int vote1, vote2;
 
       /*float val1;*/
@@ -83,7 +83,7 @@ void CLASS green_equilibrate(float thresh)
       for (rr=0; rr < numrows; rr++)
         for (row=rr+top, cc=0; cc < numcols; cc++) {
           col = cc+left;
-          cfa[rr*TS+cc] = m_Image[row*width+col][FC(row,col)];//for dcraw implementation
+          cfa[rr*TS+cc] = CFA_BAYER(row,col);//for dcraw implementation
           //cfa[rr*TS+cc] = rawData[row][col];
 
         }
@@ -162,8 +162,7 @@ void CLASS green_equilibrate(float thresh)
         for (row=rr+top, cc=border+1-(FC(rr,2)&1), indx=rr*TS+cc; cc < numcols-border; cc+=2, indx+=2) {
           if (cfa[indx]<1) continue;
           col = cc + left;
-          c = FC(row,col);
-          m_Image[row*width + col][c] = CLIP((int32_t)(cfa[indx] + 0.5)); //for dcraw implementation
+          CFA_BAYER(row,col) = CLIP((int32_t)(cfa[indx] + 0.5)); //for dcraw implementation
           //rawData[row][col] = CLIP((int)(cfa[indx] + 0.5));
         }
 
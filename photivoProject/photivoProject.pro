@@ -235,10 +235,13 @@ HEADERS += \
     ../Sources/greyc/CImg.h \
     ../Sources/ptAbstractInteraction.h \
     ../Sources/ptAdobeTable.h \
+    ../Sources/ptBench.h \
     ../Sources/ptCalloc.h \
     ../Sources/ptCheck.h \
     ../Sources/ptChoice.h \
     ../Sources/ptCimg.h \
+    ../Sources/ptCmsTransformCache.h \
+    ../Sources/ptColorLut.h \
     ../Sources/ptConfirmRequest.h \
     ../Sources/ptConstants.h \
     ../Sources/ptCurve.h \
@@ -252,16 +255,20 @@ HEADERS += \
     ../Sources/ptHistogramWindow.h \
     ../Sources/ptImage.h \
     ../Sources/ptImage8.h \
+    ../Sources/ptImageCache.h \
     ../Sources/ptImageHelper.h \
     ../Sources/ptInfo.h \
     ../Sources/ptInput.h \
     ../Sources/ptKernel.h \
+    ../Sources/ptLabKernels.h \
     ../Sources/ptLensfun.h \
     ../Sources/ptLineInteraction.h \
     ../Sources/ptMainWindow.h \
     ../Sources/ptMessageBox.h \
     ../Sources/ptParseCli.h \
     ../Sources/ptProcessor.h \
+    ../Sources/ptProfiler.h \
+    ../Sources/ptRawIndex.h \
     ../Sources/ptReportOverlay.h \
     ../Sources/ptResizeFilters.h \
     ../Sources/ptRGBTemperature.h \
@@ -269,6 +276,7 @@ HEADERS += \
     ../Sources/ptSettings.h \
     ../Sources/ptSimpleRectInteraction.h \
     ../Sources/ptSlider.h \
+    ../Sources/ptStageCache.h \
     ../Sources/ptTempFile.h \
     ../Sources/ptTempFilterBase.h \
     ../Sources/ptTheme.h \
@@ -378,10 +386,13 @@ SOURCES += \
     ../Sources/filters/ptFilterFactory.cpp \
     ../Sources/perfectraw/lmmse_interpolate.c \
     ../Sources/ptAbstractInteraction.cpp \
+    ../Sources/ptBench.cpp \
     ../Sources/ptCalloc.cpp \
     ../Sources/ptCheck.cpp \
     ../Sources/ptChoice.cpp \
     ../Sources/ptCimg.cpp \
+    ../Sources/ptCmsTransformCache.cpp \
+    ../Sources/ptColorLut.cpp \
     ../Sources/ptConfirmRequest.cpp \
     ../Sources/ptCurve.cpp \
     ../Sources/ptCurveWindow.cpp \
@@ -401,10 +412,12 @@ SOURCES += \
     ../Sources/ptImage_Lqr.cpp \
     ../Sources/ptImage_Pyramid.cpp \
     ../Sources/ptImage8.cpp \
+    ../Sources/ptImageCache.cpp \
     ../Sources/ptImageHelper.cpp \
     ../Sources/ptInfo.cpp \
     ../Sources/ptInput.cpp \
     ../Sources/ptKernel.cpp \
+    ../Sources/ptLabKernels.cpp \
     ../Sources/ptLensfun.cpp \
     ../Sources/ptLineInteraction.cpp \
     ../Sources/ptMain.cpp \
@@ -412,6 +425,8 @@ SOURCES += \
     ../Sources/ptMessageBox.cpp \
     ../Sources/ptParseCli.cpp \
     ../Sources/ptProcessor.cpp \
+    ../Sources/ptProfiler.cpp \
+    ../Sources/ptRawIndex.cpp \
     ../Sources/ptReportOverlay.cpp \
     ../Sources/ptResizeFilters.cpp \
     ../Sources/ptRGBTemperature.cpp \
@@ -419,6 +434,7 @@ SOURCES += \
     ../Sources/ptSettings.cpp \
     ../Sources/ptSimpleRectInteraction.cpp \
     ../Sources/ptSlider.cpp \
+    ../Sources/ptStageCache.cpp \
     ../Sources/ptTempFile.cpp \
     ../Sources/ptTempFilterBase.cpp \
     ../Sources/ptTheme.cpp \